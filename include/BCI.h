@@ -6,19 +6,24 @@
 #pragma comment(lib, "ws2_32.lib")
 #pragma comment(lib, "winmm.lib")
 
+#include <stdio.h>
 #include <string>
 #include <map>
 #include "UdpSocket.h"
 #include "SockStream.h"
 #include "OSC_Listener.h"
+#include "Cursor.h"
 #include "chai3d.h"
 #include "shared_Data.h"
 
 void linkSharedDataToBCI(shared_data& sharedData);
 void initBCI(void);
 void updateBCI(void);
-bool readFromGTec(map<string, float> &state, sockstream &recStream);
-void writeToGTec(string state, short value);
+bool readFromGTec(cBCI2000Parser &state, streamsock &recSocket);
+bool writeToGTec(const char* state, int value);
+size_t flushToGTec(void);
+void printBCITiming(FILE* file);
 void closeBCI(void);
+void benchmarkGTecParser(FILE* file, const char* trafficFile);
 
 #endif  // BCI_H
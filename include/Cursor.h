@@ -0,0 +1,15 @@
+#ifndef CURSOR_H
+#define CURSOR_H
+
+#include <cmath>
+#include "chai3d.h"
+#include "shared_Data.h"
+
+void initCursor(void);
+void linkSharedDataToCursor(shared_data& sharedData);
+void updateCursor(void);
+void stepCursor(double dt);
+void resetCursor(void);
+void predictCursor(long long nowNs, double& pos, double& vel, unsigned long& resets, input_tag& input);
+
+#endif  // CURSOR_H
@@ -30,42 +30,98 @@
 #ifndef INCLUDED_MESSAGEMAPPINGOSCPACKETLISTENER_H
 #define INCLUDED_MESSAGEMAPPINGOSCPACKETLISTENER_H
 
+#include <vector>
 #include <string.h>
-#include <map>
 
 #include "OscPacketListener.h"
+#include "OscAddressTrie.h"
+#include "OscAddressPattern.h"
 
 
 
 namespace osc{
 
+// T derives from MessageMappingOscPacketListener<T> (so the handlers are reached with a static_cast).
+// Addresses are compiled into a trie as they are registered, and each message is dispatched with one
+// pass over its address.
+//
+// A handler may also be registered for an OSC address pattern (e.g. "/COG/*" or "/EXP/{SMILE,CLENCH}";
+// see OscAddressPattern.h), in which case a message goes to every handler whose address or pattern
+// it matches: the exact one first, then the patterns in the order they were registered. Which
+// handlers an address matches is worked out the first time it arrives and cached, so afterwards it
+// costs a hash lookup. (Register handlers before receiving, not from inside a handler.)
 template< class T >
 class MessageMappingOscPacketListener : public OscPacketListener{
 public:
     typedef void (T::*function_type)(const osc::ReceivedMessage&, const IpEndpointName&);
 
 protected:
+    // (registering an address or pattern again replaces its handler)
     void RegisterMessageFunction( const char *addressPattern, function_type f )
     {
-        functions_.insert( std::make_pair( addressPattern, f ) );
+        if( AddressPattern::IsPattern( addressPattern ) ){
+            for( size_t i = 0; i < patterns_.size(); ++i ){
+                if( strcmp( patterns_[i].Source(), addressPattern ) == 0 ){
+                    functions_[patternIds_[i]] = f;
+                    return;
+                }
+            }
+            patterns_.push_back( AddressPattern( addressPattern ) );
+            patternIds_.push_back( (int)functions_.size() );
+            functions_.push_back( f );
+            matches_.Clear();
+            return;
+        }
+
+        int id = addresses_.Find( addressPattern );
+        if( id == -1 ){
+            addresses_.Add( addressPattern, (int)functions_.size() );
+            functions_.push_back( f );
+            matches_.Clear();
+        }else{
+            functions_[id] = f;
+        }
     }
 
     virtual void ProcessMessage( const osc::ReceivedMessage& m,
 		const IpEndpointName& remoteEndpoint )
     {
-        typename function_map_type::iterator i = functions_.find( m.AddressPattern() );
-        if( i != functions_.end() )
-            (dynamic_cast<T*>(this)->*(i->second))( m, remoteEndpoint );
+        const char *address = m.AddressPattern();
+
+        // with exact addresses only, the trie alone decides
+        if( patterns_.empty() ){
+            int id = addresses_.Find( address );
+            if( id != -1 )
+                (static_cast<T*>(this)->*(functions_[id]))( m, remoteEndpoint );
+            return;
+        }
+
+        const int *ids;
+        int count;
+        if( !matches_.Find( address, ids, count ) ){
+            matched_.clear();
+            int id = addresses_.Find( address );
+            if( id != -1 )
+                matched_.push_back( id );
+            for( size_t i = 0; i < patterns_.size(); ++i ){
+                if( patterns_[i].Match( address ) )
+                    matched_.push_back( patternIds_[i] );
+            }
+            count = (int)matched_.size();
+            ids = matches_.Insert( address, (count > 0) ? &matched_[0] : 0, count );
+        }
+
+        for( int i = 0; i < count; ++i )
+            (static_cast<T*>(this)->*(functions_[ids[i]]))( m, remoteEndpoint );
     }
     
 private:
-    struct cstr_compare{
-        bool operator()( const char *lhs, const char *rhs ) const
-            { return strcmp( lhs, rhs ) < 0; }
-    };
-
-    typedef std::map<const char*, function_type, cstr_compare> function_map_type;
-    function_map_type functions_;
+    AddressTrie addresses_;
+    std::vector<AddressPattern> patterns_;
+    std::vector<int> patternIds_;           // id of each pattern's handler
+    std::vector<function_type> functions_;  // indexed by address or pattern id
+    AddressMatchCache matches_;             // address -> ids of every handler it matches
+    std::vector<int> matched_;              // (scratch for filling the cache)
 };
 
 } // namespace osc
@@ -2,9 +2,12 @@
 #ifndef NEUROTOUCH_H
 #define NEUROTOUCH_H
 
+#ifdef _WIN32
 #include <conio.h>
+#endif
 #include <cmath>
 #include "cNeuroTouch.h"
+#include "Cursor.h"
 #include "BCI.h"
 #include "OSC_Listener.h"
 #include "cForceSensor.h"
@@ -14,8 +17,10 @@
 void initNeuroTouch(void);
 void linkSharedDataToNeuroTouch(shared_data& sharedData);
 void updateNeuroTouch(void);
-void updateCursor(void);
 void computeForce(void);
+void publishHapticState(void);
+void printNeuroTouchTiming(FILE* file);
+void printInputLatency(FILE* file);
 void closeNeuroTouch(void);
 
 #endif  // NEUROTOUCH_H
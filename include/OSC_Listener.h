@@ -1,15 +1,57 @@
 #pragma once
-#include "OscPacketListener.h"
+#include "MessageMappingOscPacketListener.h"
+#include "cSeqLock.h"
+
+#define EMO_HISTORY 16 // cognitive states kept for consumers to check for missed updates and compute rates
+
+// one cognitive state, as published by the listener for each /COG message
+typedef struct {
+	float cogRight;
+	float cogLeft;
+	float cogNeutral;
+	unsigned long sequence; // 1 for the first message, then +1 per message (0 = nothing received yet)
+	long long timeNs; // arrival time of the packet it came from (getMonotonicTimeNs) [nsec]
+} emo_state;
+
+// the most recent states, oldest first
+typedef struct {
+	emo_state states[EMO_HISTORY];
+	int count; // states held (fewer than EMO_HISTORY until that many have arrived)
+} emo_history;
+
+// Listens for Emotiv cognitive states. The BCI thread (the only writer) publishes each state as a whole,
+// so any number of other threads can read a consistent one without ever blocking the listener.
+// Messages are dispatched on their address through a trie built once, in the constructor.
 class OSC_Listener :
-	public osc::OscPacketListener
+	public osc::MessageMappingOscPacketListener<OSC_Listener>
 {
 public:
 	OSC_Listener(void);
 	void queryEmoState(float& Cog_Right, float& Cog_Left, float& Cog_Neutral);
+	void queryEmoState(float& Cog_Right, float& Cog_Left, float& Cog_Neutral, long long& Arrival_Ns);
+	bool getEmoState(emo_state& State) const;
+	void getEmoHistory(emo_history& History) const;
+	double getUpdateRate(void) const;
+	unsigned long long getTornReads(void) const;
+	virtual void ProcessPacket( const char *data, int size, 
+				const IpEndpointName& remoteEndpoint );
 	~OSC_Listener(void);
 
 protected:
 	 virtual void ProcessMessage( const osc::ReceivedMessage& m, 
 				const IpEndpointName& remoteEndpoint );
-};
 
+private:
+	 void ProcessCogLeft( const osc::ReceivedMessage& m, const IpEndpointName& remoteEndpoint );
+	 void ProcessCogRight( const osc::ReceivedMessage& m, const IpEndpointName& remoteEndpoint );
+	 void ProcessCogNeutral( const osc::ReceivedMessage& m, const IpEndpointName& remoteEndpoint );
+	 void publishEmoState(float Cog_Right, float Cog_Left, float Cog_Neutral);
+
+	 cSeqLock<emo_state> m_state; // latest state
+	 cSeqLock<emo_history> m_history; // recent states
+
+	 // listener thread only
+	 long long m_packetTimeNs; // arrival time of the packet being processed [nsec]
+	 emo_state m_latest;
+	 emo_history m_recent;
+};
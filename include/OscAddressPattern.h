@@ -0,0 +1,110 @@
+/*
+	OSC 1.0 address pattern matching for OSC packet listeners (see MessageMappingOscPacketListener.h).
+*/
+#ifndef INCLUDED_OSCADDRESSPATTERN_H
+#define INCLUDED_OSCADDRESSPATTERN_H
+
+#include <vector>
+#include <string>
+
+#include "OscException.h"
+
+// addresses whose matching handlers are remembered (the cache starts over when it fills up)
+#define OSC_MATCH_CACHE_SIZE 256
+
+
+namespace osc{
+
+class MalformedAddressPatternException : public Exception{
+public:
+    MalformedAddressPatternException( const char *w="malformed address pattern" )
+        : Exception( w ) {}
+};
+
+
+// AddressPattern is an OSC 1.0 address pattern, compiled once into a list of
+// tokens and then matched against concrete addresses:
+//
+//     ?          any one character
+//     *          any run of characters, including none
+//     [abc]      one of the characters listed; a-z is a range, and [!...] negates
+//     {foo,bar}  one of the strings listed
+//
+// none of which ever match a '/', so wildcards stay within one part of the
+// address. Any other character matches itself.
+class AddressPattern{
+public:
+    // throws MalformedAddressPatternException for an unterminated [ or {
+    explicit AddressPattern( const char *pattern );
+
+    // whether a string uses any of the characters above (if not, it only matches itself)
+    static bool IsPattern( const char *address );
+
+    bool Match( const char *address ) const;
+
+    const char *Source() const { return source_.c_str(); }
+
+private:
+    enum TokenType { LITERAL, ANY_CHAR, ANY_RUN, CHAR_CLASS, ALTERNATIVES };
+
+    struct Token{
+        TokenType type;
+        int start;               // LITERAL: text_[start, start + length); ALTERNATIVES: alternatives_[start, start + length)
+        int length;
+        unsigned char set[32];   // CHAR_CLASS: bit c is set if character c matches
+    };
+
+    struct Alternative{
+        int start;               // text_[start, start + length)
+        int length;
+    };
+
+    bool MatchFrom( int token, const char *address ) const;
+    bool MatchText( int start, int length, const char *address ) const;
+
+    std::string source_;
+    std::string text_;           // literal runs and alternatives, back to back
+    std::vector<Token> tokens_;
+    std::vector<Alternative> alternatives_;
+};
+
+
+// AddressMatchCache remembers, for each address seen, the ids of the handlers
+// whose patterns it matched (possibly none), so an address that has been seen
+// before costs one hash of its characters and one comparison. It holds at most
+// half of OSC_MATCH_CACHE_SIZE addresses: when full it is emptied and refilled
+// as addresses arrive, which bounds it however many distinct addresses are sent.
+class AddressMatchCache{
+public:
+    AddressMatchCache();
+
+    // ids cached for address (false if it is not cached; ids is then untouched)
+    bool Find( const char *address, const int *&ids, int& count ) const;
+
+    // cache the ids matched by address (returns the stored copy)
+    const int *Insert( const char *address, const int *ids, int count );
+
+    void Clear();
+
+    int Size() const { return size_; }
+
+private:
+    struct Entry{
+        unsigned int hash;
+        int keyStart;            // keys_[keyStart, keyStart + keyLength) (-1 if the slot is empty)
+        int keyLength;
+        int idsStart;            // ids_[idsStart, idsStart + idsCount)
+        int idsCount;
+    };
+
+    static unsigned int Hash( const char *address, int& length );
+
+    std::vector<Entry> entries_; // OSC_MATCH_CACHE_SIZE slots, probed linearly
+    std::string keys_;
+    std::vector<int> ids_;
+    int size_;
+};
+
+} // namespace osc
+
+#endif /* INCLUDED_OSCADDRESSPATTERN_H */
@@ -0,0 +1,53 @@
+/*
+	Address dispatch for OSC packet listeners (see MessageMappingOscPacketListener.h).
+*/
+#ifndef INCLUDED_OSCADDRESSTRIE_H
+#define INCLUDED_OSCADDRESSTRIE_H
+
+#include <vector>
+#include <string>
+
+
+namespace osc{
+
+// AddressTrie maps OSC addresses to small integer ids. Addresses are added
+// once, at registration; Find() then matches an incoming address in a
+// single pass over its characters, with no string comparisons and no
+// allocation.
+//
+// The trie is path compressed: each edge is labelled with a run of
+// characters (e.g. "/COG/" for addresses that all share it), and a node's
+// children are a list of siblings told apart by the first character of
+// their labels, so a lookup only branches where registered addresses differ.
+class AddressTrie{
+public:
+    AddressTrie();
+
+    // add an address (ids are chosen by the caller; adding an address again replaces its id)
+    void Add( const char *address, int id );
+
+    // id of an address exactly as added, or -1
+    int Find( const char *address ) const;
+
+    int Size() const { return size_; }
+
+private:
+    struct Node{
+        char first;        // first character of the label (the root's label is empty)
+        int labelStart;    // label is labels_[labelStart, labelStart + labelLength)
+        int labelLength;
+        int id;            // id of the address ending here (-1 if none)
+        int firstChild;    // index in nodes_ (-1 if none)
+        int nextSibling;
+    };
+
+    int AddNode( int labelStart, int labelLength, int id, int firstChild, int nextSibling );
+
+    std::vector<Node> nodes_;  // nodes_[0] is the root
+    std::string labels_;       // edge labels, back to back
+    int size_;
+};
+
+} // namespace osc
+
+#endif /* INCLUDED_OSCADDRESSTRIE_H */
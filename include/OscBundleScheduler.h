@@ -0,0 +1,120 @@
+/*
+	Jitter buffer for OSC bundles: releases each bundle at its time tag
+	(see OscPacketListener.h, which otherwise dispatches bundles on arrival).
+*/
+#ifndef INCLUDED_OSCBUNDLESCHEDULER_H
+#define INCLUDED_OSCBUNDLESCHEDULER_H
+
+#include <vector>
+
+#include "OscTypes.h"
+#include "PacketListener.h"
+#include "TimerListener.h"
+#include "IpEndpointName.h"
+
+// bundles held at once (when full, the earliest is released ahead of time to make room)
+#define OSC_MAX_HELD_BUNDLES 64
+
+
+class SocketReceiveMultiplexer;
+
+namespace osc{
+
+// BundleScheduler sits between a socket and the listener it would otherwise
+// deliver to. Messages, and bundles tagged "immediately", pass straight
+// through; a bundle tagged for the future is copied into a time-ordered queue
+// and handed to the listener when its time comes, on a one-shot timer of the
+// multiplexer receiving the packets. A bundle whose time has already passed
+// is late: it is counted, then either delivered at once or dropped.
+//
+// Time tags (NTP time) are read against the wall clock, sampled once by
+// Synchronize() and advanced from then on by the monotonic clock, so that
+// adjustments to the wall clock cannot reorder held bundles. A playout delay
+// is added to every tag, which gives bundles stamped when they were sent
+// (rather than for the future) the same fixed delay, absorbing any network
+// jitter shorter than it. Releases are as precise as the multiplexer's
+// timers (about 1 msec).
+//
+// Everything runs on the multiplexer's thread (call Clear() from that thread
+// too, when it is not in Run()).
+class BundleScheduler : public PacketListener, public TimerListener{
+public:
+    enum LatePolicy { DELIVER_LATE, DROP_LATE };
+
+    BundleScheduler( PacketListener *listener, SocketReceiveMultiplexer *multiplexer );
+    virtual ~BundleScheduler();
+
+    // added to every time tag [msec]
+    void SetPlayoutDelay( int delayMilliseconds ) { playoutDelayNs_ = delayMilliseconds * 1000000LL; }
+
+    // sender's clock minus ours, for a sender whose clock is not synchronized with this one [msec]
+    void SetClockOffset( double offsetMilliseconds ) { clockOffsetNs_ = (long long)(offsetMilliseconds * 1.0e6); }
+
+    void SetLatePolicy( LatePolicy policy ) { latePolicy_ = policy; }
+
+    // sample the wall clock again (e.g. before each Run, in case it was stepped since)
+    void Synchronize();
+
+    // discard everything held, and cancel the release timer
+    void Clear();
+
+    virtual void ProcessPacket( const char *data, int size, 
+			const IpEndpointName& remoteEndpoint );
+
+    virtual void TimerExpired();
+
+    // packets passed straight through, bundles held (and released), late (of which dropped),
+    // released early because the queue was full, and discarded by Clear()
+    unsigned long Passed() const { return passed_; }
+    unsigned long Held() const { return held_; }
+    unsigned long Released() const { return released_; }
+    unsigned long Late() const { return late_; }
+    unsigned long Dropped() const { return dropped_; }
+    unsigned long Overflowed() const { return overflowed_; }
+    unsigned long Discarded() const { return discarded_; }
+    int Waiting() const { return (int)queue_.size(); }
+
+    // how far ahead of their release bundles arrived (largest so far), and how late late ones were [nsec]
+    long long MaxLead() const { return maxLeadNs_; }
+    long long MaxLateness() const { return maxLatenessNs_; }
+
+private:
+    struct HeldBundle{
+        long long dueNs;          // release time on the monotonic clock
+        unsigned long sequence;   // (keeps bundles due at the same time in arrival order)
+        int buffer;               // index in buffers_
+        int size;
+        IpEndpointName from;
+    };
+
+    // orders the heap with the earliest bundle on top
+    struct Later{
+        bool operator()( const HeldBundle& a, const HeldBundle& b ) const
+            { return a.dueNs > b.dueNs || (a.dueNs == b.dueNs && a.sequence > b.sequence); }
+    };
+
+    long long DueNs( uint64 timeTag ) const;
+    void Hold( const char *data, int size, const IpEndpointName& from, long long dueNs );
+    void ReleaseFirst();
+    void Arm( long long nowNs );
+
+    PacketListener *listener_;
+    SocketReceiveMultiplexer *multiplexer_;
+    long long playoutDelayNs_;
+    long long clockOffsetNs_;
+    LatePolicy latePolicy_;
+    long long wallMinusMonotonicNs_;    // from Synchronize(): wall clock (Unix time) minus monotonic clock [nsec]
+
+    std::vector<HeldBundle> queue_;           // binary heap (see Later)
+    std::vector< std::vector<char> > buffers_;  // copies of held bundles (reused; each grows to the largest it has held)
+    std::vector<int> freeBuffers_;
+    unsigned long sequence_;
+    long long armedNs_;                 // release time the timer is set for (0 = not set)
+
+    unsigned long passed_, held_, released_, late_, dropped_, overflowed_, discarded_;
+    long long maxLeadNs_, maxLatenessNs_;
+};
+
+} // namespace osc
+
+#endif /* INCLUDED_OSCBUNDLESCHEDULER_H */
@@ -33,6 +33,10 @@
 #include "OscTypes.h"
 #include "OscException.h"
 
+// arguments of a received message whose positions are recorded while it is validated (more than
+// the 14 channels of an Emotiv EPOC); later ones are found by scanning on from the last of these
+#define OSC_INDEXED_ARGUMENTS 32
+
 
 namespace osc{
 
@@ -443,11 +447,36 @@ public:
         return ReceivedMessageArgumentStream( ArgumentsBegin(), ArgumentsEnd() );
     }
 
+    // random access to the arguments, in constant time for the first OSC_INDEXED_ARGUMENTS
+    // (throws MissingArgumentException past the last argument)
+    ReceivedMessageArgument Argument( unsigned long index ) const
+    {
+        if( index < indexedCount_ )
+            return ReceivedMessageArgument( typeTagsBegin_ + index, arguments_ + argumentOffsets_[index] );
+        return UnindexedArgument( index );
+    }
+
+    // typed random access (these also throw WrongArgumentTypeException, like the As...() methods)
+    bool Bool( unsigned long index ) const { return Argument( index ).AsBool(); }
+    int32 Int32( unsigned long index ) const { return Argument( index ).AsInt32(); }
+    int64 Int64( unsigned long index ) const { return Argument( index ).AsInt64(); }
+    float Float( unsigned long index ) const { return Argument( index ).AsFloat(); }
+    double Double( unsigned long index ) const { return Argument( index ).AsDouble(); }
+    uint64 TimeTag( unsigned long index ) const { return Argument( index ).AsTimeTag(); }
+    const char* String( unsigned long index ) const { return Argument( index ).AsString(); }
+
 private:
+    ReceivedMessageArgument UnindexedArgument( unsigned long index ) const;
+
 	const char *addressPattern_;
 	const char *typeTagsBegin_;
 	const char *typeTagsEnd_;
     const char *arguments_;
+
+    // where each of the first arguments starts, from arguments_ (recorded by Init() as it checks them;
+    // 16 bits covers any UDP datagram, and indexing stops at an argument further in than that)
+    unsigned short argumentOffsets_[ OSC_INDEXED_ARGUMENTS ];
+    unsigned long indexedCount_;
 };
 
 
@@ -0,0 +1,58 @@
+/*
+	Timer queue for SocketReceiveMultiplexer (shared by the Win32 and Linux
+	implementations in UdpSocket.cpp and UdpSocketLinux.cpp).
+*/
+#ifndef INCLUDED_TIMERQUEUE_H
+#define INCLUDED_TIMERQUEUE_H
+
+#include <vector>
+
+
+class TimerListener;
+
+// TimerQueue keeps scheduled timer calls in a binary min-heap on their expiry
+// time, so scheduling and firing a timer cost O(log n) however many timers
+// there are. Timers are periodic (fired again periodMs after each time they
+// were due) or one-shot (periodMs 0). Cancelling is O(n), and is safe from
+// inside a TimerExpired() callback, including for the timer being fired.
+//
+// Times are in milliseconds on whatever clock the caller uses. Not thread
+// safe: use from the multiplexer's thread only.
+class TimerQueue{
+public:
+    TimerQueue();
+
+    void Schedule( double expiryMs, int periodMs, TimerListener *listener );
+
+    // remove every timer for listener (periodic only, or one-shot as well); returns how many were removed
+    int Cancel( TimerListener *listener, bool periodicOnly );
+
+    // remove every periodic timer
+    void CancelAllPeriodic();
+
+    bool Empty() const { return heap_.empty(); }
+    double NextExpiryMs() const { return heap_.front().expiryMs; }  // (only if !Empty())
+
+    // call each timer due at or before nowMs once, earliest first (a late periodic timer is
+    // not called twice in one pass). stops after the callback that sets breakFlag
+    void Expire( double nowMs, volatile bool& breakFlag );
+
+private:
+    struct ScheduledTimerCall{
+        double expiryMs;
+        int periodMs;
+        TimerListener *listener;
+    };
+
+    static bool Later( const ScheduledTimerCall& lhs, const ScheduledTimerCall& rhs )
+        { return lhs.expiryMs > rhs.expiryMs; }
+
+    std::vector< ScheduledTimerCall > heap_;
+    std::vector< ScheduledTimerCall > rescheduled_;  // periodic timers fired in this pass (pushed back after it)
+
+    TimerListener *firingListener_;  // listener of the timer being fired (NULL between callbacks)
+    bool firingPeriodic_;
+    bool firingCancelled_;           // the timer being fired was cancelled from its own callback
+};
+
+#endif /* INCLUDED_TIMERQUEUE_H */
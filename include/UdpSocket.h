@@ -39,6 +39,9 @@
 #endif /* INCLUDED_IPENDPOINTNAME_H */
 
 
+// datagrams a multiplexer reads from a ready socket per wakeup, by default (recvmmsg on Linux)
+#define OSC_RECEIVE_BATCH 32
+
 class PacketListener;
 class TimerListener;
 
@@ -54,7 +57,8 @@ public:
     SocketReceiveMultiplexer();
     ~SocketReceiveMultiplexer();
 
-	// only call the attach/detach methods _before_ calling Run
+	// only call the attach/detach methods _before_ calling Run (the timer methods may also be called
+	// from a listener or TimerExpired() callback, i.e., on the thread in Run)
 
     // only one listener per socket, each socket at most once
     void AttachSocketListener( UdpSocket *socket, PacketListener *listener );
@@ -65,6 +69,15 @@ public:
             int initialDelayMilliseconds, int periodMilliseconds, TimerListener *listener );
     void DetachPeriodicTimerListener( TimerListener *listener );  
 
+    // call listener once, delayMilliseconds from now (even across Run calls, until it fires or is cancelled)
+    void AttachOneShotTimerListener( int delayMilliseconds, TimerListener *listener );
+    // remove every periodic and one-shot timer for listener (including one being fired)
+    void CancelTimerListener( TimerListener *listener );
+
+	// at most this many datagrams are read from a ready socket, and passed to its listener in order, per wakeup
+	// (1 = one read per wakeup). only call _before_ calling Run
+	void SetReceiveBatch( int maxDatagrams );
+
     void Run();      // loop and block processing messages indefinitely
 	void RunUntilSigInt();
     void Break();    // call this from a listener to exit once the listener returns
@@ -152,6 +165,7 @@ public:
 	void RunUntilSigInt() { mux_.RunUntilSigInt(); }
     void Break() { mux_.Break(); }
     void AsynchronousBreak() { mux_.AsynchronousBreak(); }
+    void SetReceiveBatch( int maxDatagrams ) { mux_.SetReceiveBatch( maxDatagrams ); }
 };
 
 
@@ -0,0 +1,10 @@
+#ifndef BENCHMARKOSC_H
+#define BENCHMARKOSC_H
+
+#include <stdio.h>
+
+void benchmarkOscReceive(FILE* file);
+void benchmarkOscDispatch(FILE* file);
+void benchmarkOscParse(FILE* file);
+
+#endif  // BENCHMARKOSC_H
@@ -0,0 +1,81 @@
+//===========================================================================
+/*!
+    \file       cBCI2000Commands.h
+
+    \brief
+    Batched state updates for the BCI2000 AppConnector.
+*/
+//===========================================================================
+#ifndef CBCI2000COMMANDS_H
+#define CBCI2000COMMANDS_H
+
+#include <stddef.h>
+#include "SockStream.h"
+#include "cBCI2000Parser.h"
+
+// largest datagram sent (fits an Ethernet frame unfragmented, and holds BCI2000_MAX_STATES full-length lines)
+#define BCI2000_MAX_DATAGRAM 1472
+
+
+//===========================================================================
+/*!
+    \class      cBCI2000Commands
+
+    \brief
+    cBCI2000Commands queues "Name value" state updates for BCI2000 and
+    sends everything queued as a single datagram when flush() is called,
+    instead of one flushed stream write (and one datagram) per state.
+    Setting a state that is already queued just replaces its value, so
+    only the last value set before a flush is sent.
+
+    Nothing is allocated after construction. One thread at a time may
+    queue and flush.
+*/
+//===========================================================================
+class cBCI2000Commands
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cBCI2000Commands (nothing queued).
+    cBCI2000Commands(void);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Queue a state update (BCI2000 states are at most 32 bits; returns false if the name is too long or BCI2000_MAX_STATES other states are queued).
+    bool set(const char* a_name, int a_value);
+
+    // Send every queued update in one datagram (returns bytes sent; 0 if nothing was queued or the send failed).
+    size_t flush(streamsock& a_socket);
+
+    // Forget queued updates without sending them.
+    void clear(void) { m_numPending = 0; }
+
+    // States currently queued.
+    int getPending(void) const { return m_numPending; }
+
+    // Updates queued, updates replaced by a later value before being sent, and datagrams sent.
+    unsigned long getQueued(void) const { return m_queued; }
+    unsigned long getCollapsed(void) const { return m_collapsed; }
+    unsigned long getDatagrams(void) const { return m_datagrams; }
+
+  private:
+
+    char m_names[BCI2000_MAX_STATES][BCI2000_NAME_LENGTH];
+    size_t m_nameLengths[BCI2000_MAX_STATES];
+    int m_values[BCI2000_MAX_STATES];
+    int m_numPending;
+
+    char m_datagram[BCI2000_MAX_DATAGRAM];
+
+    unsigned long m_queued;
+    unsigned long m_collapsed;
+    unsigned long m_datagrams;
+};
+
+#endif  // CBCI2000COMMANDS_H
@@ -0,0 +1,100 @@
+//===========================================================================
+/*!
+    \file       cBCI2000Parser.h
+
+    \brief
+    Allocation-free parser for the BCI2000 AppConnector state stream.
+*/
+//===========================================================================
+#ifndef CBCI2000PARSER_H
+#define CBCI2000PARSER_H
+
+#include <stddef.h>
+
+#define BCI2000_MAX_STATES   32    // most states that can be registered
+#define BCI2000_NAME_LENGTH  32    // longest state name (including terminator)
+#define BCI2000_MAX_LINE     128   // longest line carried over between buffers [bytes]
+
+
+//===========================================================================
+/*!
+    \class      cBCI2000Parser
+
+    \brief
+    cBCI2000Parser scans "Name value" lines (the AppConnector format) in
+    place and stores the values of registered states in a flat array.
+
+    States are registered ahead of time and given fixed slot indices.
+    Registration also picks a hash seed under which every registered name
+    lands in its own bucket (a perfect hash), so parsing a line costs one
+    pass over its bytes plus a single compare to confirm the name;
+    unregistered states are skipped. Nothing is allocated after
+    construction. A line split across two buffers (e.g., datagrams) is
+    carried over and completed by the next call.
+*/
+//===========================================================================
+class cBCI2000Parser
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cBCI2000Parser (no states registered).
+    cBCI2000Parser(void);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Register a state (returns its slot, the existing slot if already registered, or -1 if the table is full).
+    int registerState(const char* a_name);
+
+    // Parse a buffer of lines (returns the number of registered states updated).
+    int parse(const char* a_data, size_t a_length);
+
+    // Forget values, counts, and any partial line (registrations are kept).
+    void reset(void);
+
+    // Latest value of a state (0 until first received).
+    float getValue(int a_slot) const { return m_values[a_slot]; }
+
+    // Number of times a state has been received.
+    unsigned long getUpdates(int a_slot) const { return m_updates[a_slot]; }
+
+    // Lines parsed, and lines skipped (unregistered state or malformed).
+    unsigned long getLines(void) const { return m_lines; }
+    unsigned long getSkipped(void) const { return m_skipped; }
+
+  private:
+
+    // Hash of a name under the current seed.
+    unsigned int hash(const char* a_name, size_t a_length, unsigned int a_seed) const;
+
+    // Choose a seed and bucket count under which registered names do not collide.
+    void buildTable(void);
+
+    // Parse one complete line (without its terminator).
+    bool parseLine(const char* a_line, size_t a_length);
+
+    char m_names[BCI2000_MAX_STATES][BCI2000_NAME_LENGTH];
+    size_t m_nameLengths[BCI2000_MAX_STATES];
+    int m_numStates;
+
+    // perfect hash: bucket -> slot (-1 = empty)
+    int m_buckets[4 * BCI2000_MAX_STATES];
+    unsigned int m_mask;
+    unsigned int m_seed;
+
+    float m_values[BCI2000_MAX_STATES];
+    unsigned long m_updates[BCI2000_MAX_STATES];
+    unsigned long m_lines;
+    unsigned long m_skipped;
+
+    // partial line from the end of the previous buffer
+    char m_carry[BCI2000_MAX_LINE];
+    size_t m_carryLength;
+};
+
+#endif  // CBCI2000PARSER_H
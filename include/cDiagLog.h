@@ -0,0 +1,194 @@
+//===========================================================================
+/*!
+    \file       cDiagLog.h
+
+    \brief
+    Asynchronous diagnostics log that is safe to call from real-time loops.
+*/
+//===========================================================================
+#ifndef CDIAGLOG_H
+#define CDIAGLOG_H
+
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+#include "cRingBuffer.h"
+#include "cLoopTimer.h"
+
+// message levels
+#define DIAG_LEVEL_DEBUG  0
+#define DIAG_LEVEL_INFO   1
+#define DIAG_LEVEL_WARN   2
+#define DIAG_LEVEL_ERROR  3
+
+// lowest level compiled in (e.g., -DDIAG_MIN_LEVEL=0 for debug messages); calls below it compile to nothing
+#ifndef DIAG_MIN_LEVEL
+#define DIAG_MIN_LEVEL DIAG_LEVEL_INFO
+#endif
+
+#define DIAG_MAX_ARGS     6      // most arguments per message
+#define DIAG_MAX_THREADS  32     // most threads that can log
+#define DIAG_RING_SIZE    256    // messages buffered per thread
+#define DIAG_RATE_LIMIT   0.1    // default shortest interval between messages from one call site [sec]
+
+
+// one call site (a static per DIAG_LOG, so rate limiting is per site)
+typedef struct {
+
+    int level;
+    long long interval;                  // shortest time between messages [nsec] (0 = every call)
+    const char* file;
+    int line;
+    std::atomic<long long> next;         // earliest time the next message is allowed [nsec]
+    std::atomic<unsigned long> skipped;  // messages rate-limited away since the last one logged
+
+} diag_site;
+
+// one message, as logged on the calling thread (formatting is left to the flushing thread)
+typedef struct {
+
+    const diag_site* site;
+    const char* format;          // printf-style format (must be a string literal)
+    long long time;              // [nsec]
+    unsigned long skipped;       // messages from the same site suppressed just before this one
+    int numArgs;
+    char types[DIAG_MAX_ARGS];   // 'i' (integer), 'd' (floating point), 's' (string literal)
+    union {
+        long long i;
+        double d;
+        const char* s;
+    } args[DIAG_MAX_ARGS];
+
+} diag_record;
+
+
+//===========================================================================
+/*!
+    \class      cDiagLog
+
+    \brief
+    cDiagLog takes printf-style messages from any thread without doing any
+    I/O there. A call copies the format pointer and its (numeric or
+    string-literal) arguments into a ring owned by the calling thread, so
+    it never locks, allocates, or waits; a background thread calls
+    flush() to format and print what has accumulated (in order per
+    thread, grouped by thread). Messages are dropped (and counted) if a
+    thread's ring fills up.
+
+    Use the DIAG_* macros rather than write(): each call site gets its
+    own rate limit, so an error repeated every tick of a 1 kHz loop
+    prints at most every DIAG_RATE_LIMIT seconds along with a count of
+    the repeats, and levels below DIAG_MIN_LEVEL are removed at compile
+    time (arguments included).
+
+    A thread's ring is allocated the first time it logs; real-time loops
+    should call attachThread() at start-up so that happens up front.
+*/
+//===========================================================================
+class cDiagLog
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cDiagLog.
+    cDiagLog(void);
+
+    //! Destructor of cDiagLog.
+    ~cDiagLog(void);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Allocate the calling thread's ring now (returns false if DIAG_MAX_THREADS threads already log).
+    bool attachThread(void);
+
+    // Log a message (any thread; arguments are integers, floating point, or string literals).
+    template <typename... A>
+    void write(diag_site& a_site, const char* a_format, A... a_args)
+    {
+        static_assert(sizeof...(A) <= DIAG_MAX_ARGS, "too many arguments for a diagnostics message");
+
+        // rate limit per call site
+        long long now = getMonotonicTimeNs();
+        if (a_site.interval > 0) {
+            long long next = a_site.next.load(std::memory_order_relaxed);
+            if (now < next || !a_site.next.compare_exchange_strong(next, now + a_site.interval, std::memory_order_relaxed)) {
+                a_site.skipped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        diag_record record;
+        record.site = &a_site;
+        record.format = a_format;
+        record.time = now;
+        record.skipped = a_site.skipped.exchange(0, std::memory_order_relaxed);
+        record.numArgs = 0;
+        int unused[] = {0, (pack(record, a_args), 0)...};
+        (void)unused;
+
+        if (s_ring == NULL && !attachThread()) {
+            m_unattached.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        s_ring->push(record);
+    }
+
+    // Format and print every buffered message (any one thread at a time; returns the number printed).
+    int flush(FILE* a_file);
+
+    // Messages dropped because a ring was full or too many threads logged.
+    unsigned long getDropped(void) const;
+
+  private:
+
+    // argument packing
+    static void pack(diag_record& r, long long a_value)          { r.types[r.numArgs] = 'i'; r.args[r.numArgs++].i = a_value; }
+    static void pack(diag_record& r, int a_value)                { pack(r, (long long)a_value); }
+    static void pack(diag_record& r, unsigned int a_value)       { pack(r, (long long)a_value); }
+    static void pack(diag_record& r, long a_value)               { pack(r, (long long)a_value); }
+    static void pack(diag_record& r, unsigned long a_value)      { pack(r, (long long)a_value); }
+    static void pack(diag_record& r, unsigned long long a_value) { pack(r, (long long)a_value); }
+    static void pack(diag_record& r, double a_value)             { r.types[r.numArgs] = 'd'; r.args[r.numArgs++].d = a_value; }
+    static void pack(diag_record& r, const char* a_value)        { r.types[r.numArgs] = 's'; r.args[r.numArgs++].s = a_value; }
+
+    // Format one message into a_line.
+    void format(const diag_record& a_record, char* a_line, size_t a_size) const;
+
+    // the calling thread's ring (NULL until attached)
+    static thread_local cRingBuffer<diag_record>* s_ring;
+
+    cRingBuffer<diag_record> m_rings[DIAG_MAX_THREADS];
+    std::atomic<int> m_numRings;
+    std::mutex m_attachLock;    // attaching threads only
+    std::atomic<unsigned long> m_unattached;
+    std::mutex m_flushLock;     // flushing thread(s) only, never the writers
+    long long m_start;          // messages are stamped relative to this [nsec]
+
+    // not copyable
+    cDiagLog(const cDiagLog&);
+    cDiagLog& operator=(const cDiagLog&);
+};
+
+// the process-wide log
+extern cDiagLog diagLog;
+
+// log a message at a level, at most once per a_interval seconds from this call site
+#define DIAG_LOG(a_level, a_interval, ...) \
+    do { \
+        if ((a_level) >= DIAG_MIN_LEVEL) { \
+            static diag_site diagSite = {(a_level), (long long)((a_interval) * 1e9), __FILE__, __LINE__, {0}, {0}}; \
+            diagLog.write(diagSite, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define DIAG_DEBUG(...) DIAG_LOG(DIAG_LEVEL_DEBUG, DIAG_RATE_LIMIT, __VA_ARGS__)
+#define DIAG_INFO(...)  DIAG_LOG(DIAG_LEVEL_INFO,  DIAG_RATE_LIMIT, __VA_ARGS__)
+#define DIAG_WARN(...)  DIAG_LOG(DIAG_LEVEL_WARN,  DIAG_RATE_LIMIT, __VA_ARGS__)
+#define DIAG_ERROR(...) DIAG_LOG(DIAG_LEVEL_ERROR, DIAG_RATE_LIMIT, __VA_ARGS__)
+
+#endif  // CDIAGLOG_H
@@ -0,0 +1,116 @@
+//===========================================================================
+/*!
+    \file       cHardwareInterface.h
+
+    \brief
+    Runtime-selectable backends for the NeuroTouch encoders, the NeuroTouch
+    motor amplifiers, and the ATI force/torque sensor.
+*/
+//===========================================================================
+#ifndef CHARDWAREINTERFACE_H
+#define CHARDWAREINTERFACE_H
+
+#include <string>
+
+// boards compiled in (NOTE: vendor drivers only exist on Windows, so elsewhere only simulated backends are available)
+#ifdef _WIN32
+//#define SENSORAY_ACTIVE  // Sensoray 626 for encoders and DACs
+#define QUAD04_ACTIVE      // Measurement Computing PCI-QUAD04 for encoders
+#define NIDAQ_ACTIVE       // NI USB-6341 for DACs
+#define ATI_ACTIVE         // ATI force/torque sensor through NI-DAQmx
+#endif
+
+// backend selection
+#define HW_HARDWARE  0  // real boards (whichever are compiled in above)
+#define HW_SIMULATED 1  // software models of the boards (no hardware required)
+
+
+//===========================================================================
+/*!
+    \class      cEncoderBackend
+
+    \brief
+    Reads the two NeuroTouch motor angles.
+*/
+//===========================================================================
+class cEncoderBackend
+{
+  public:
+    virtual ~cEncoderBackend() {}
+
+    // Configure the encoder counters (0 indicates success).
+    virtual int openEncoders() = 0;
+
+    // Release the encoder counters (0 indicates success).
+    virtual int closeEncoders() = 0;
+
+    // Treat the current angles as zero (0 indicates success).
+    virtual int zeroEncoders() = 0;
+
+    // Read motor angles [deg] (0 indicates success).
+    virtual int readEncoders(float& a_degA, float& a_degB) = 0;
+};
+
+
+//===========================================================================
+/*!
+    \class      cMotorBackend
+
+    \brief
+    Writes reference voltages to the two NeuroTouch motor amplifiers.
+*/
+//===========================================================================
+class cMotorBackend
+{
+  public:
+    virtual ~cMotorBackend() {}
+
+    // Prepare the analog outputs (0 indicates success).
+    virtual int openMotors() = 0;
+
+    // Drive the analog outputs to a safe state and release them (0 indicates success).
+    virtual int closeMotors() = 0;
+
+    // Command amplifier reference voltages [V] (0 indicates success).
+    virtual int writeVoltages(double a_voltA, double a_voltB) = 0;
+};
+
+
+//===========================================================================
+/*!
+    \class      cForceBackend
+
+    \brief
+    Reads the 6-axis force/torque sensor under the finger.
+*/
+//===========================================================================
+class cForceBackend
+{
+  public:
+    virtual ~cForceBackend() {}
+
+    // Load calibration and start acquisition (0 indicates success, negative values as in cForceSensor).
+    virtual int initialize(const std::string& a_calibrationFile, const std::string& a_device) = 0;
+
+    // Stop acquisition (0 indicates success).
+    virtual int stop() = 0;
+
+    // Tare the sensor at its current load (0 indicates success).
+    virtual int bias() = 0;
+
+    // Read one force/torque record (Fx, Fy, Fz [N], Tx, Ty, Tz [Nm]) (0 indicates success).
+    virtual int readFT(double a_ft[6]) = 0;
+
+    // Units of the force and torque readings.
+    virtual std::string getForceUnits() = 0;
+    virtual std::string getTorqueUnits() = 0;
+};
+
+
+// create the encoder and motor backends for the NeuroTouch (NOTE: both point to the same object when simulated)
+bool createNeuroTouchBackends(int a_type, cEncoderBackend*& a_encoders, cMotorBackend*& a_motors);
+
+// create the force/torque sensor backend (NOTE: a simulated sensor reads force from a_simulatedMotors, if given)
+cForceBackend* createForceBackend(int a_type, cMotorBackend* a_simulatedMotors = 0);
+
+#endif  // CHARDWAREINTERFACE_H
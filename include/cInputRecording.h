@@ -0,0 +1,157 @@
+//===========================================================================
+/*!
+    \file       cInputRecording.h
+
+    \brief
+    Capture of raw BCI input datagrams (Emotiv OSC packets and BCI2000
+    state datagrams) with their arrival times, for replaying sessions
+    offline.
+*/
+//===========================================================================
+#ifndef CINPUTRECORDING_H
+#define CINPUTRECORDING_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define INPUT_MAGIC          "HBCIRAW"    // first 8 bytes of every recording (including terminator)
+#define INPUT_VERSION        1
+#define INPUT_MAX_DATAGRAM   (64 * 1024)  // largest datagram recorded [bytes]
+#define INPUT_CHUNK_BYTES    (64 * 1024)  // datagrams are written to the file in chunks of this size
+
+// datagram sources (stored in the file, so they must never be renumbered)
+#define INPUT_OSC      0   // Emotiv, through "Mind your OSCs"
+#define INPUT_BCI2000  1   // g.MOBIlab+, through the BCI2000 AppConnector
+
+
+//===========================================================================
+/*!
+    \class      cInputRecorder
+
+    \brief
+    cInputRecorder appends datagrams exactly as they came off a socket,
+    each with its source and arrival time, to a recording file. Datagrams
+    are collected in an INPUT_CHUNK_BYTES buffer and written a chunk at
+    a time, so most calls are a copy.
+
+    File layout (all integers little-endian):
+
+        char[8]   magic "HBCIRAW"
+        uint32    version, BCI the session was recorded from (EMOTIV or GTEC)
+        per datagram: int64 arrival time since the recording started [nsec],
+                      uint8 source, uint32 length, bytes
+*/
+//===========================================================================
+class cInputRecorder
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cInputRecorder (not recording).
+    cInputRecorder(void);
+
+    //! Destructor of cInputRecorder (closes the file).
+    ~cInputRecorder(void);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Start recording to a file (a_bci is stored for the replayer; returns false if the file cannot be created).
+    bool open(const char* a_filename, int a_bci);
+
+    // Record one datagram that arrived at a_arrivalNs (getMonotonicTimeNs) [nsec] (one thread at a time).
+    void record(int a_source, const char* a_data, size_t a_length, long long a_arrivalNs);
+
+    // Write out anything buffered and close the file.
+    void close(void);
+
+    // Whether a recording is in progress.
+    bool isOpen(void) const { return m_file != NULL; }
+
+    // Datagrams and payload bytes recorded so far.
+    unsigned long getDatagrams(void) const { return m_datagrams; }
+    unsigned long long getBytes(void) const { return m_bytes; }
+
+  private:
+
+    // Write the buffered datagrams to the file.
+    void writeBuffer(void);
+
+    FILE* m_file;
+    long long m_startNs;          // arrival times are stored relative to this [nsec]
+    unsigned char* m_buffer;      // INPUT_CHUNK_BYTES
+    size_t m_used;
+    unsigned long m_datagrams;
+    unsigned long long m_bytes;
+
+    // not copyable
+    cInputRecorder(const cInputRecorder&);
+    cInputRecorder& operator=(const cInputRecorder&);
+};
+
+
+//===========================================================================
+/*!
+    \class      cInputReplayer
+
+    \brief
+    cInputReplayer reads back a recording made by cInputRecorder, one
+    datagram at a time. Pacing is left to the caller, which compares
+    getTime() with its own clock.
+*/
+//===========================================================================
+class cInputReplayer
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cInputReplayer (no file open).
+    cInputReplayer(void);
+
+    //! Destructor of cInputReplayer (closes the file).
+    ~cInputReplayer(void);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Open a recording and read its header (returns false, with a message, if it is not a recording this version can read).
+    bool open(const char* a_filename);
+
+    // Read the next datagram (returns false at the end of the recording, or at a datagram cut short).
+    bool next(void);
+
+    // Close the file.
+    void close(void);
+
+    // BCI the session was recorded from (EMOTIV or GTEC).
+    int getBci(void) const { return m_bci; }
+
+    // The datagram read by the last next(): source, arrival time since the recording started [nsec], and bytes.
+    int getSource(void) const { return m_source; }
+    long long getTime(void) const { return m_timeNs; }
+    const char* getData(void) const { return m_data; }
+    size_t getLength(void) const { return m_length; }
+
+  private:
+
+    FILE* m_file;
+    int m_bci;
+    int m_source;
+    long long m_timeNs;
+    char* m_data;                 // INPUT_MAX_DATAGRAM
+    size_t m_length;
+
+    // not copyable
+    cInputReplayer(const cInputReplayer&);
+    cInputReplayer& operator=(const cInputReplayer&);
+};
+
+#endif  // CINPUTRECORDING_H
@@ -0,0 +1,120 @@
+//===========================================================================
+/*!
+    \file       cInputSwitch.h
+
+    \brief
+    Input sources (BCI, PHANTOM) that can be stopped and switched while
+    the simulation runs, each on a thread that lives as long as the
+    simulation does.
+*/
+//===========================================================================
+#ifndef CINPUTSWITCH_H
+#define CINPUTSWITCH_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#define INPUT_MODES     3     // input modes a source can be registered for (AUTO, BCI, PHANTOM)
+#define INPUT_NONE      -1    // nothing selected
+#define INPUT_RETRY_MS  2500  // wait before opening a source again after it failed to open [msec]
+
+
+//===========================================================================
+/*!
+    \class      cInputSource
+
+    \brief
+    cInputSource is a device or socket that produces input. open(), run()
+    and close() are called in turn on the thread hosting the source;
+    interrupt() is called from another thread to make run() return, in
+    the manner of oscpack's AsynchronousBreak().
+*/
+//===========================================================================
+class cInputSource
+{
+  public:
+
+    virtual ~cInputSource(void) {}
+
+    // Acquire the device or socket (returns false to be retried after INPUT_RETRY_MS).
+    virtual bool open(void) = 0;
+
+    // Receive input until interrupted (may also return on its own, e.g., at the end of a replay).
+    virtual void run(void) = 0;
+
+    // Make run() return soon (any thread; may be called more than once, and just before or after run()).
+    virtual void interrupt(void) = 0;
+
+    // Release what open() acquired.
+    virtual void close(void) = 0;
+};
+
+
+//===========================================================================
+/*!
+    \class      cInputSwitch
+
+    \brief
+    cInputSwitch runs whichever input source is selected. Each source is
+    hosted by a thread that calls host() once and stays in it until
+    shutdown(), idling while its source is not selected, so switching
+    sources never creates or destroys threads.
+
+    select() interrupts the running source and waits for its thread to
+    close it, then wakes the thread of the new source, which opens and
+    runs it. A mode with no source registered (AUTO) needs no thread.
+*/
+//===========================================================================
+class cInputSwitch
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cInputSwitch (no sources, nothing selected).
+    cInputSwitch(void);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Register the source for an input mode (only while that mode is not selected).
+    void setSource(int a_input, cInputSource* a_source);
+
+    // Stop the selected source and start the one for a_input (returns how long the old source took to stop [nsec]).
+    long long select(int a_input);
+
+    // Stop the selected source and release every host thread.
+    void shutdown(void);
+
+    // Host the source for a_input (call from its thread; returns after shutdown()).
+    void host(int a_input);
+
+    // Selected input mode, and switches made so far.
+    int getSelected(void) const { return m_selected; }
+    unsigned long getSwitches(void) const { return m_switches; }
+
+  private:
+
+    // host thread state of each mode
+    enum { IDLE, OPENING, RUNNING, CLOSING };
+
+    cInputSource* m_sources[INPUT_MODES];
+    int m_states[INPUT_MODES];
+    unsigned long m_selections[INPUT_MODES];  // times each mode has been selected (a source that ended on its own waits for the next)
+    std::atomic<int> m_selected;
+    bool m_shutdown;
+    std::atomic<unsigned long> m_switches;
+
+    std::mutex m_lock;                  // guards everything above (NOTE: interrupt() is only called under it, so never before open() or after close())
+    std::condition_variable m_changed;  // selection or a host state changed
+
+    // not copyable
+    cInputSwitch(const cInputSwitch&);
+    cInputSwitch& operator=(const cInputSwitch&);
+};
+
+#endif  // CINPUTSWITCH_H
@@ -0,0 +1,99 @@
+//===========================================================================
+/*!
+    \file       cLatencyHistogram.h
+
+    \brief
+    Low-overhead log-linear histogram for timing measurements.
+*/
+//===========================================================================
+#ifndef CLATENCYHISTOGRAM_H
+#define CLATENCYHISTOGRAM_H
+
+#include <stdio.h>
+#include <atomic>
+
+// sub-buckets per power of two (2^6 = 64, so each bucket spans < 1.6% of its value)
+#define HIST_SUB_BITS    6
+#define HIST_SUB_COUNT   (1 << HIST_SUB_BITS)
+// largest power of two tracked (2^36 nsec ~ 69 sec); larger values land in the last bucket
+#define HIST_MAX_EXP     36
+#define HIST_NUM_BUCKETS (HIST_SUB_COUNT * (HIST_MAX_EXP - HIST_SUB_BITS + 2))
+
+
+// summary statistics pulled from a histogram (all times in [nsec])
+typedef struct {
+
+    unsigned long long count;
+    long long min;
+    long long p50;
+    long long p99;
+    long long p999;
+    long long max;
+    double mean;
+    unsigned long long overThreshold;  // samples above the threshold given to setThreshold()
+
+} latency_summary;
+
+
+//===========================================================================
+/*!
+    \class      cLatencyHistogram
+
+    \brief
+    cLatencyHistogram records durations [nsec] into logarithmically-sized
+    buckets (in the style of an HDR histogram), so p50/p99/p99.9 can be
+    reported with bounded relative error and a fixed memory footprint.
+
+    record() is wait-free and meant to be called by a single thread (e.g.,
+    the haptic loop). Any other thread may call getSummary() at any time
+    without stalling the recorder; the summary may lag by a sample or two.
+*/
+//===========================================================================
+class cLatencyHistogram
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cLatencyHistogram.
+    cLatencyHistogram(void);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Record one duration [nsec] (single recording thread only).
+    void record(long long a_valueNs);
+
+    // Count samples above a_thresholdNs separately (e.g., missed deadlines).
+    void setThreshold(long long a_thresholdNs);
+
+    // Compute summary statistics (safe to call from any thread).
+    void getSummary(latency_summary& a_summary) const;
+
+    // Write a one-line summary to a file (e.g., stdout or a session log).
+    void print(FILE* a_file, const char* a_name) const;
+
+    // Clear all samples (only while the recording thread is idle).
+    void reset(void);
+
+  private:
+
+    // Bucket index for a value.
+    static int bucketIndex(long long a_valueNs);
+
+    // Largest value that maps to a bucket.
+    static long long bucketUpperBound(int a_index);
+
+    std::atomic<unsigned long> m_buckets[HIST_NUM_BUCKETS];
+    std::atomic<unsigned long long> m_count;
+    std::atomic<unsigned long long> m_overThreshold;
+    std::atomic<long long> m_sum;
+    std::atomic<long long> m_min;
+    std::atomic<long long> m_max;
+    long long m_thresholdNs;
+};
+
+#endif  // CLATENCYHISTOGRAM_H
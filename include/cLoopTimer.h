@@ -0,0 +1,104 @@
+//===========================================================================
+/*!
+    \file       cLoopTimer.h
+
+    \brief
+    Deadline-based periodic scheduler for the device/experiment thread loops.
+*/
+//===========================================================================
+#ifndef CLOOPTIMER_H
+#define CLOOPTIMER_H
+
+#include <atomic>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// current time from a monotonic clock [nsec] (not tied to wall-clock time)
+long long getMonotonicTimeNs(void);
+
+// CPU time consumed so far by the calling thread [nsec]
+long long getThreadCpuTimeNs(void);
+
+
+//===========================================================================
+/*!
+    \class      cLoopTimer
+
+    \brief
+    cLoopTimer paces a thread loop at a fixed rate. Instead of polling a
+    timer in a tight while loop, waitForNextPeriod() sleeps until an
+    absolute deadline (so timing errors do not accumulate) and only
+    spin-waits for the last few microseconds to get a precise wake-up.
+
+    The thread calling waitForNextPeriod() also keeps a running measure
+    of its own CPU use, which can be read from any thread via getCpuLoad().
+*/
+//===========================================================================
+class cLoopTimer
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cLoopTimer (defaults to a 1 msec period).
+    cLoopTimer(void);
+
+    //! Destructor of cLoopTimer.
+    ~cLoopTimer(void);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Set the loop period [sec] (takes effect at the next deadline).
+    void setPeriodSeconds(double a_period);
+
+    // Get the loop period [sec].
+    double getPeriodSeconds(void) const;
+
+    // Set how long before each deadline to stop sleeping and spin instead [usec].
+    void setSpinThresholdMicroseconds(double a_spin);
+
+    // (Re)start the schedule, with the first deadline one period from now.
+    void start(void);
+
+    // Block until the next deadline (returns false if the deadline had already been missed).
+    bool waitForNextPeriod(void);
+
+    // Block until an absolute time from getMonotonicTimeNs() [nsec], outside the periodic schedule (returns false if it had already passed).
+    bool waitUntil(long long a_deadlineNs);
+
+    // Fraction of one core used by the looping thread over the last report interval (0 to 1).
+    double getCpuLoad(void) const;
+
+    // Number of deadlines that had already passed when waitForNextPeriod() was called.
+    unsigned long getMissedDeadlines(void) const;
+
+  private:
+
+    // Sleep (without spinning) until shortly before a_deadlineNs.
+    void sleepUntil(long long a_deadlineNs);
+
+    // Update the CPU load measurement (called from the looping thread).
+    void updateCpuLoad(long long a_nowNs);
+
+    std::atomic<long long> m_periodNs;          // loop period [nsec]
+    long long m_spinNs;                         // spin-wait window before each deadline [nsec]
+    long long m_nextDeadlineNs;                 // next absolute wake-up time [nsec]
+    bool m_started;                             // whether a schedule is in progress
+
+    long long m_reportStartNs;                  // start of the current CPU load interval [nsec]
+    long long m_reportStartCpuNs;               // thread CPU time at start of the interval [nsec]
+    std::atomic<double> m_cpuLoad;              // most recent CPU load measurement
+    std::atomic<unsigned long> m_missedDeadlines;
+
+#ifdef _WIN32
+    HANDLE m_waitableTimer;                     // high-resolution timer used for sleeping
+#endif
+};
+
+#endif  // CLOOPTIMER_H
@@ -0,0 +1,103 @@
+//===========================================================================
+/*!
+    \file       cMailbox.h
+
+    \brief
+    Wait-free, single-writer/single-reader "latest value" mailbox.
+*/
+//===========================================================================
+#ifndef CMAILBOX_H
+#define CMAILBOX_H
+
+#include <atomic>
+
+// assumed cache line size (keeps the three slots on separate lines)
+#define MAILBOX_CACHE_LINE 64
+
+
+//===========================================================================
+/*!
+    \class      cMailbox
+
+    \brief
+    cMailbox passes the most recent value of type T from exactly one writer
+    thread to exactly one reader thread (a triple buffer). Unlike cSeqLock,
+    neither side ever retries or waits: write() fills a slot the reader
+    cannot be using and swaps it in with one atomic exchange, and read()
+    swaps in the newest complete slot the same way. Values the reader
+    never got to are simply overwritten.
+*/
+//===========================================================================
+template <typename T>
+class cMailbox
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cMailbox (every slot starts value-initialized, with nothing new to read).
+    cMailbox() : m_back(0), m_writes(0), m_middle(1), m_front(2), m_reads(0)
+    {
+        for (int i = 0; i < 3; i++) m_slots[i].value = T();
+    }
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Publish a new value (writer thread only; never waits).
+    void write(const T& a_value)
+    {
+        m_slots[m_back].value = a_value;
+        unsigned int previous = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel);
+        m_back = previous & INDEX;
+        m_writes.store(m_writes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Copy out the latest value (reader thread only; never waits). Returns true if it is newer than the last read.
+    bool read(T& a_value)
+    {
+        bool fresh = (m_middle.load(std::memory_order_relaxed) & FRESH) != 0;
+        if (fresh) m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+        a_value = m_slots[m_front].value;
+        if (fresh) m_reads.store(m_reads.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return fresh;
+    }
+
+    // Number of values written, and number the reader actually picked up (any thread; diagnostic).
+    unsigned long getWriteCount() const { return m_writes.load(std::memory_order_relaxed); }
+    unsigned long getFreshReadCount() const { return m_reads.load(std::memory_order_relaxed); }
+
+  private:
+
+    static const unsigned int INDEX = 3;   // slot index bits of m_middle
+    static const unsigned int FRESH = 4;   // set when the middle slot holds a value the reader has not seen
+
+    struct slot {
+        T value;
+        char padding[MAILBOX_CACHE_LINE];
+    };
+
+    slot m_slots[3];
+
+    // writer side
+    unsigned int m_back;                   // slot being written
+    std::atomic<unsigned long> m_writes;
+    char m_padding0[MAILBOX_CACHE_LINE];
+
+    std::atomic<unsigned int> m_middle;    // slot handed between the two sides, plus FRESH
+    char m_padding1[MAILBOX_CACHE_LINE];
+
+    // reader side
+    unsigned int m_front;                  // slot being read
+    std::atomic<unsigned long> m_reads;
+    char m_padding2[MAILBOX_CACHE_LINE];
+
+    // not copyable
+    cMailbox(const cMailbox&);
+    cMailbox& operator=(const cMailbox&);
+};
+
+#endif  // CMAILBOX_H
@@ -17,19 +17,29 @@
 //---------------------------------------------------------------------------
 //#include "devices/CGenericHapticDevice.h"
 
+#include "cHardwareInterface.h"
+
+#ifdef SENSORAY_ACTIVE
 extern "C"
 {
 #include "Win626.h"
 }
+#include "APP626.h"
+#endif
 
+#ifdef _WIN32
 #include "windows.h"
-#include "APP626.h"
+#endif
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#ifdef QUAD04_ACTIVE
 #include "cbw.h"
+#endif
+#ifdef NIDAQ_ACTIVE
 #include "NIDAQcommands.h"
 #include "NIDAQmx.h"
+#endif
 //---------------------------------------------------------------------------
 
 //===========================================================================
@@ -143,8 +153,8 @@ class cNeuroTouch
     // CONSTRUCTOR & DESTRUCTOR:
     //-----------------------------------------------------------------------
 
-    //! Constructor of cNeuroTouch.
-    cNeuroTouch(unsigned int a_deviceNumber = 0);
+    //! Constructor of cNeuroTouch (a_backend is HW_HARDWARE or HW_SIMULATED).
+    cNeuroTouch(unsigned int a_deviceNumber = 0, int a_backend = HW_HARDWARE);
 
     //! Destructor of cNeuroTouch.
     virtual ~cNeuroTouch();
@@ -153,6 +163,14 @@ class cNeuroTouch
     // METHODS:
     //-----------------------------------------------------------------------
 
+    // Select real or simulated boards (must be called before open()).
+    void setBackend(int a_backend) { m_backend = a_backend; }
+    int getBackend() const { return m_backend; }
+
+    // Backends in use (NULL until open() has been called).
+    cEncoderBackend* getEncoderBackend() { return m_encoders; }
+    cMotorBackend* getMotorBackend() { return m_motors; }
+
     // Open connection to haptic device (0 indicates success).
     int open();
 
@@ -186,6 +204,11 @@ class cNeuroTouch
     // Device ID number.
     int m_deviceID;
 
+    // Board backends (HW_HARDWARE or HW_SIMULATED).
+    int m_backend;
+    cEncoderBackend* m_encoders;
+    cMotorBackend* m_motors;
+
 };
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,137 @@
+//===========================================================================
+/*!
+    \file       cRingBuffer.h
+
+    \brief
+    Fixed-capacity, lock-free single-producer/single-consumer queue.
+*/
+//===========================================================================
+#ifndef CRINGBUFFER_H
+#define CRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+
+// assumed cache line size (keeps the producer's and consumer's indices from sharing a line)
+#define RING_CACHE_LINE 64
+
+
+//===========================================================================
+/*!
+    \class      cRingBuffer
+
+    \brief
+    cRingBuffer passes records of type T from exactly one producer thread
+    to exactly one consumer thread. All storage is allocated once, by
+    allocate(), before either thread starts; push() and pop() never
+    allocate, lock, or wait. When the ring is full, push() drops the
+    record and counts it rather than blocking the producer.
+
+    Each side keeps a private copy of the other side's index and only
+    re-reads the shared one when the copy says the ring is full (producer)
+    or empty (consumer), so in steady state a push or pop touches no
+    cache line written by the other thread.
+*/
+//===========================================================================
+template <typename T>
+class cRingBuffer
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cRingBuffer (no storage until allocate() is called).
+    cRingBuffer() : m_records(NULL), m_capacity(0), m_mask(0), m_head(0), m_cachedTail(0), m_dropped(0), m_tail(0), m_cachedHead(0) {}
+
+    //! Destructor of cRingBuffer.
+    ~cRingBuffer() { delete[] m_records; }
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Allocate room for at least a_capacity records (rounded up to a power of two); not thread-safe, call before use.
+    void allocate(size_t a_capacity)
+    {
+        size_t capacity = 1;
+        while (capacity < a_capacity) capacity <<= 1;
+        delete[] m_records;
+        m_records = new T[capacity]();  // value-initialized, so every page is touched now rather than by the first pushes
+        m_capacity = capacity;
+        m_mask = capacity - 1;
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+        m_cachedHead = 0;
+        m_cachedTail = 0;
+        m_dropped.store(0, std::memory_order_relaxed);
+    }
+
+    // Append a record (producer only; returns false and counts a drop if the ring is full).
+    bool push(const T& a_record)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail >= m_capacity) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail >= m_capacity) {
+                m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        m_records[head & m_mask] = a_record;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Remove the oldest record (consumer only; returns false if the ring is empty).
+    bool pop(T& a_record)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_cachedHead) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead) return false;
+        }
+        a_record = m_records[tail & m_mask];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Number of records waiting (approximate if called while either side is active).
+    size_t size(void) const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+
+    // Number of records the ring can hold.
+    size_t capacity(void) const { return m_capacity; }
+
+    // Total records pushed (including any later popped).
+    size_t getPushed(void) const { return m_head.load(std::memory_order_acquire); }
+
+    // Total records popped.
+    size_t getPopped(void) const { return m_tail.load(std::memory_order_acquire); }
+
+    // Number of records dropped because the ring was full.
+    unsigned long getDropped(void) const { return m_dropped.load(std::memory_order_relaxed); }
+
+  private:
+
+    // no copying (the ring owns its storage)
+    cRingBuffer(const cRingBuffer&);
+    cRingBuffer& operator=(const cRingBuffer&);
+
+    T* m_records;
+    size_t m_capacity;
+    size_t m_mask;
+    char m_padding0[RING_CACHE_LINE];
+
+    // producer side
+    std::atomic<size_t> m_head;
+    size_t m_cachedTail;
+    std::atomic<unsigned long> m_dropped;
+    char m_padding1[RING_CACHE_LINE];
+
+    // consumer side
+    std::atomic<size_t> m_tail;
+    size_t m_cachedHead;
+};
+
+#endif  // CRINGBUFFER_H
@@ -0,0 +1,112 @@
+//===========================================================================
+/*!
+    \file       cSeqLock.h
+
+    \brief
+    Single-writer sequence lock for sharing small, trivially-copyable
+    structures between threads without blocking the writer.
+*/
+//===========================================================================
+#ifndef CSEQLOCK_H
+#define CSEQLOCK_H
+
+#include <atomic>
+#include <cstring>
+#include <cstddef>
+
+
+//===========================================================================
+/*!
+    \class      cSeqLock
+
+    \brief
+    cSeqLock holds one value of type T that is written by exactly one thread
+    and read by any number of threads. The writer never waits; a reader that
+    overlaps a write simply retries, so it always returns a consistent copy.
+
+    The value is stored as an array of atomic words (rather than as a plain T)
+    so that concurrent reads and writes are well-defined. T must be
+    trivially copyable (plain structs of numbers).
+*/
+//===========================================================================
+template <typename T>
+class cSeqLock
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cSeqLock (value starts zeroed).
+    cSeqLock() : m_sequence(0), m_retries(0)
+    {
+        for (size_t i = 0; i < NUM_WORDS; i++) m_words[i].store(0, std::memory_order_relaxed);
+    }
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Publish a new value (must only ever be called from one thread).
+    void write(const T& a_value)
+    {
+        unsigned long long buffer[NUM_WORDS];
+        buffer[NUM_WORDS - 1] = 0;
+        memcpy(buffer, &a_value, sizeof(T));
+
+        // odd sequence number marks a write in progress
+        unsigned long seq = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < NUM_WORDS; i++) m_words[i].store(buffer[i], std::memory_order_relaxed);
+
+        m_sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Attempt one read (false if it overlapped a write and must be retried).
+    bool tryRead(T& a_value) const
+    {
+        unsigned long long buffer[NUM_WORDS];
+
+        unsigned long seqBefore = m_sequence.load(std::memory_order_acquire);
+        if (seqBefore & 1) return false;
+
+        for (size_t i = 0; i < NUM_WORDS; i++) buffer[i] = m_words[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        unsigned long seqAfter = m_sequence.load(std::memory_order_relaxed);
+        if (seqBefore != seqAfter) return false;
+
+        memcpy(&a_value, buffer, sizeof(T));
+        return true;
+    }
+
+    // Read a consistent copy of the value (retries while the writer is active).
+    void read(T& a_value) const
+    {
+        while (!tryRead(a_value)) m_retries.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Number of writes published so far.
+    unsigned long getWriteCount() const { return m_sequence.load(std::memory_order_relaxed) / 2; }
+
+    // Number of reads that overlapped a write (i.e., would have been torn without the lock).
+    unsigned long long getRetryCount() const { return m_retries.load(std::memory_order_relaxed); }
+
+  private:
+
+    static const size_t NUM_WORDS = (sizeof(T) + sizeof(unsigned long long) - 1) / sizeof(unsigned long long);
+
+    std::atomic<unsigned long> m_sequence;              // even = stable, odd = write in progress
+    std::atomic<unsigned long long> m_words[NUM_WORDS]; // value of type T, split into words
+    char m_padding[64];                                 // keeps reader-side counter off the writer's cache line
+    mutable std::atomic<unsigned long long> m_retries;  // diagnostic count of collided reads
+
+    // not copyable
+    cSeqLock(const cSeqLock&);
+    cSeqLock& operator=(const cSeqLock&);
+};
+
+#endif  // CSEQLOCK_H
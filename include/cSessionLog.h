@@ -0,0 +1,223 @@
+//===========================================================================
+/*!
+    \file       cSessionLog.h
+
+    \brief
+    Compact binary session log: a self-describing header (field names,
+    types, and units) followed by fixed-size little-endian records,
+    either streamed through stdio or written into a preallocated,
+    memory-mapped file.
+*/
+//===========================================================================
+#ifndef CSESSIONLOG_H
+#define CSESSIONLOG_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <atomic>
+
+#define LOG_MAGIC        "HBCILOG"    // first 8 bytes of every log (including terminator)
+#define LOG_VERSION      2            // (version 1 had no record count)
+#define LOG_MAX_FIELDS   64           // most fields per record
+#define LOG_NAME_LENGTH  32           // longest field name (including terminator)
+#define LOG_UNIT_LENGTH  16           // longest unit (including terminator)
+#define LOG_INFO_LENGTH  256          // longest session description (including terminator)
+#define LOG_CHUNK_BYTES  (64 * 1024)  // records are written to the file in chunks of this size
+#define LOG_COUNT_UNKNOWN 0xFFFFFFFFFFFFFFFFULL  // record count of a streamed log that was not closed (read to end of file)
+
+// field types (stored in the header, so they must never be renumbered)
+#define LOG_INT32   1
+#define LOG_BOOL    2   // one byte, 0 or 1
+#define LOG_FLOAT32 3
+#define LOG_FLOAT64 4
+
+// description of one field of a record
+typedef struct {
+
+    char name[LOG_NAME_LENGTH];
+    char unit[LOG_UNIT_LENGTH];   // empty if dimensionless
+    int type;                     // LOG_*
+    size_t size;                  // bytes in a record
+    size_t recordOffset;          // position in a (packed) record
+    size_t sourceOffset;          // position in the struct passed to append() (writer only)
+
+} log_field;
+
+// Size of one value of a field type [bytes] (0 if the type is unknown).
+size_t logTypeSize(int a_type);
+
+
+//===========================================================================
+/*!
+    \class      cSessionLogWriter
+
+    \brief
+    cSessionLogWriter packs structs into fixed-size records described by
+    a schema (one addField() per struct member, in file order). The
+    schema must be complete before open(); it is written as the file's
+    header so readers need no knowledge of the struct.
+
+    A streamed log (the default) writes records in LOG_CHUNK_BYTES chunks
+    and fills in the record count when it is closed. A mapped log is
+    preallocated for a fixed number of records and mapped into memory,
+    so append() is a plain copy with no system calls; the record count in
+    the header is updated after every record, so another process can
+    read the file while it is being written. sync() makes a mapped log
+    durable, and close() trims it to the records actually written.
+
+    File layout (all integers little-endian):
+
+        char[8]   magic "HBCILOG"
+        uint32    version, header size, record size, number of fields
+        uint64    number of records (LOG_COUNT_UNKNOWN while streaming)
+        per field: uint8 type, uint8 name length, uint8 unit length, name, unit
+        uint16    info length, info (free-text session description)
+        records
+*/
+//===========================================================================
+class cSessionLogWriter
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR & DESTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cSessionLogWriter (empty schema, no file).
+    cSessionLogWriter(void);
+
+    //! Destructor of cSessionLogWriter (closes the file).
+    ~cSessionLogWriter(void);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Append a field to the schema (a_sourceOffset = offsetof the member in the struct passed to append()).
+    bool addField(const char* a_name, const char* a_unit, int a_type, size_t a_sourceOffset);
+
+    // Create a log file and write its header, preallocating and mapping room for a_mappedRecords if nonzero (returns false if it cannot be created).
+    bool open(const char* a_filename, const char* a_info, size_t a_mappedRecords = 0);
+
+    // Pack one struct into a record (streamed: written once a chunk fills; mapped: dropped and counted if the file is full).
+    void append(const void* a_source);
+
+    // Write any buffered records and flush the file (mapped: same as sync()).
+    void flush(void);
+
+    // Write a mapped log's records to disk (blocks until done; safe to call from another thread, even while the log is closed; no effect on a streamed log).
+    void sync(void);
+
+    // Flush and close the file (the schema is kept for the next open()).
+    void close(void);
+
+    bool isOpen(void) const { return m_file != NULL || m_mapping != NULL; }
+    bool isMapped(void) const { return m_mapping != NULL; }
+    size_t getRecordSize(void) const { return m_recordSize; }
+    unsigned long getRecordsWritten(void) const { return m_records.load(); }
+    unsigned long getRecordsDropped(void) const { return m_dropped; }
+
+  private:
+
+    // no copying (the writer owns its file and chunk)
+    cSessionLogWriter(const cSessionLogWriter&);
+    cSessionLogWriter& operator=(const cSessionLogWriter&);
+
+    // Build the header in the chunk (returns its size).
+    size_t buildHeader(const char* a_info);
+
+    // Create, size, and map a file for a_records records after the header in the chunk.
+    bool openMapped(const char* a_filename, size_t a_headerSize, size_t a_records);
+
+    // Unmap a mapped log, trimming it to the records written.
+    void closeMapped(void);
+
+    // Write the mapped records to disk (caller holds m_syncBusy).
+    void syncMapping(void);
+
+    // Pack one struct into a record.
+    void pack(unsigned char* a_record, const unsigned char* a_source) const;
+
+    log_field m_fields[LOG_MAX_FIELDS];
+    int m_numFields;
+    size_t m_recordSize;
+
+    // streamed log
+    FILE* m_file;
+    unsigned char* m_chunk;
+    size_t m_chunkUsed;
+
+    // mapped log
+    unsigned char* m_mapping;
+    size_t m_headerSize;
+    size_t m_capacity;       // [records]
+    unsigned long m_dropped;
+#ifdef _WIN32
+    void* m_fileHandle;
+    void* m_mapHandle;
+#else
+    int m_fd;
+#endif
+
+    std::atomic<unsigned long> m_records;  // (read by sync())
+    std::atomic<bool> m_syncBusy;          // held while syncing or unmapping
+};
+
+
+//===========================================================================
+/*!
+    \class      cSessionLogReader
+
+    \brief
+    cSessionLogReader reads the schema from a log's header, then returns
+    one record at a time with values looked up by field index. Only the
+    records counted in the header when the log was opened are read, so a
+    log that is still being written reads as a consistent prefix.
+*/
+//===========================================================================
+class cSessionLogReader
+{
+  public:
+
+    //! Constructor of cSessionLogReader (no file).
+    cSessionLogReader(void);
+
+    //! Destructor of cSessionLogReader (closes the file).
+    ~cSessionLogReader(void);
+
+    // Open a log and read its header (returns false, with a message, if it is not a readable log).
+    bool open(const char* a_filename);
+
+    // Read the next record (returns false at end of file or on a truncated record).
+    bool readRecord(void);
+
+    void close(void);
+
+    int getNumFields(void) const { return m_numFields; }
+    const log_field& getField(int a_index) const { return m_fields[a_index]; }
+    const char* getInfo(void) const { return m_info; }
+    unsigned long long getRecordCount(void) const { return m_count; }  // (LOG_COUNT_UNKNOWN if not recorded)
+    size_t getRecordSize(void) const { return m_recordSize; }
+
+    // Values of the current record.
+    bool isInteger(int a_index) const { return m_fields[a_index].type == LOG_INT32 || m_fields[a_index].type == LOG_BOOL; }
+    long getInteger(int a_index) const;
+    double getDouble(int a_index) const;
+
+  private:
+
+    cSessionLogReader(const cSessionLogReader&);
+    cSessionLogReader& operator=(const cSessionLogReader&);
+
+    log_field m_fields[LOG_MAX_FIELDS];
+    int m_numFields;
+    size_t m_recordSize;
+    char m_info[LOG_INFO_LENGTH];
+    unsigned long long m_count;
+    unsigned long long m_read;
+
+    FILE* m_file;
+    unsigned char* m_record;
+};
+
+#endif  // CSESSIONLOG_H
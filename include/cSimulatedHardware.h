@@ -0,0 +1,131 @@
+//===========================================================================
+/*!
+    \file       cSimulatedHardware.h
+
+    \brief
+    Software models of the NeuroTouch and force/torque sensor, for running
+    the full pipeline (and benchmarks/regression runs) without hardware.
+*/
+//===========================================================================
+#ifndef CSIMULATEDHARDWARE_H
+#define CSIMULATEDHARDWARE_H
+
+#include <random>
+#include <atomic>
+#include "cHardwareInterface.h"
+
+// longest DAC latency that can be modeled [ticks]
+#define SIM_MAX_DELAY_TICKS 64
+
+
+//===========================================================================
+/*!
+    \class      cSimulatedNeuroTouch
+
+    \brief
+    cSimulatedNeuroTouch models both NeuroTouch motors from amplifier input
+    to encoder output:
+
+    - reference voltages take effect after a configurable DAC latency,
+    - each capstan joint is a mass-spring-damper (the spring being the
+      finger pad's skin) driven by the amplifier's current-mode torque,
+    - angles are quantized to the encoder's resolution.
+
+    The model advances by one time step on every writeVoltages() call
+    (i.e., once per haptic tick), not with the wall clock, so it stays
+    stable and repeatable when the loops are run faster than real time.
+*/
+//===========================================================================
+class cSimulatedNeuroTouch : public cEncoderBackend, public cMotorBackend
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cSimulatedNeuroTouch (a_timeStep = model time per tick [sec]).
+    cSimulatedNeuroTouch(double a_timeStep = 0.001);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // encoder and motor backends
+    int openEncoders();
+    int closeEncoders();
+    int zeroEncoders();
+    int readEncoders(float& a_degA, float& a_degB);
+    int openMotors();
+    int closeMotors();
+    int writeVoltages(double a_voltA, double a_voltB);
+
+    // Model parameters.
+    void setTimeStep(double a_timeStep);
+    void setDacLatency(double a_latency);  // [sec]
+    void setJacobianTranspose(const float a_jacobianTranspose[2][2]);
+
+    // End-effector force currently held by the skin [N] (what a sensor under the finger would see).
+    void getContactForce(double& a_forceX, double& a_forceY) const;
+
+  private:
+
+    double m_timeStep;          // model time per tick [sec]
+    int m_delayTicks;           // DAC latency [ticks]
+    double m_delayLine[SIM_MAX_DELAY_TICKS][2];
+    int m_delayIndex;
+
+    double m_angle[2];          // capstan angles [rad]
+    double m_velocity[2];       // capstan angular velocities [rad/s]
+    double m_zero[2];           // encoder zero [rad]
+    double m_forceMap[2][2];    // inverse Jacobian transpose (capstan torque [mNm] -> end-effector force [N])
+
+    std::atomic<double> m_contactForce[2];  // read by the force sensor model (possibly from another thread)
+};
+
+
+//===========================================================================
+/*!
+    \class      cSimulatedForceSensor
+
+    \brief
+    cSimulatedForceSensor models the ATI sensor as the contact force of a
+    cSimulatedNeuroTouch (if one is given) plus a constant offset, slow
+    drift, and white noise, so taring and filtering can be exercised.
+*/
+//===========================================================================
+class cSimulatedForceSensor : public cForceBackend
+{
+  public:
+
+    //! Constructor of cSimulatedForceSensor (a_plant may be NULL for noise only).
+    cSimulatedForceSensor(cSimulatedNeuroTouch* a_plant);
+
+    int initialize(const std::string& a_calibrationFile, const std::string& a_device);
+    int stop();
+    int bias();
+    int readFT(double a_ft[6]);
+    std::string getForceUnits();
+    std::string getTorqueUnits();
+
+    // Noise and drift parameters.
+    void setNoise(double a_forceStdDev, double a_torqueStdDev);  // [N], [Nm]
+    void setDrift(double a_forceDriftPerRead);                     // [N/read]
+
+  private:
+
+    // Raw (untared) reading.
+    void rawReading(double a_ft[6]);
+
+    cSimulatedNeuroTouch* m_plant;
+    std::mt19937 m_generator;
+    std::normal_distribution<double> m_unitNoise;
+    double m_forceNoise;
+    double m_torqueNoise;
+    double m_drift;
+    double m_driftAccum;
+    double m_offset[6];
+    double m_bias[6];
+};
+
+#endif  // CSIMULATEDHARDWARE_H
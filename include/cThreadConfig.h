@@ -0,0 +1,101 @@
+//===========================================================================
+/*!
+    \file       cThreadConfig.h
+
+    \brief
+    Per-thread CPU affinity and scheduling settings (read from a config
+    file) plus process-wide memory locking for the real-time loops.
+*/
+//===========================================================================
+#ifndef CTHREADCONFIG_H
+#define CTHREADCONFIG_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <atomic>
+
+#define TC_MAX_THREADS  16  // most threads that can be configured
+#define TC_NAME_LENGTH  32  // longest thread name (including terminator)
+
+// scheduling policies
+#define TC_POLICY_OTHER 0   // time-shared (priority ignored)
+#define TC_POLICY_FIFO  1   // real-time, run until blocked (SCHED_FIFO)
+#define TC_POLICY_RR    2   // real-time, round-robin among equal priorities (SCHED_RR)
+
+// settings for one thread
+typedef struct {
+
+    char name[TC_NAME_LENGTH];
+    int cpu;               // core to pin to (-1 = any)
+    int policy;            // TC_POLICY_*
+    int priority;          // 1-99 for real-time policies
+
+} thread_settings;
+
+
+//===========================================================================
+/*!
+    \class      cThreadConfig
+
+    \brief
+    cThreadConfig holds the requested affinity, policy, and priority for
+    each named thread loop. Each thread calls apply() with its own name
+    when it starts; the settings the OS actually granted are read back and
+    kept so report() can show requested vs. actual for every thread.
+
+    Config files have one thread per line ('#' starts a comment):
+
+        # name       cpu   policy   priority
+        neurotouch   1     fifo     80
+        experiment   -1    other    0
+*/
+//===========================================================================
+class cThreadConfig
+{
+  public:
+
+    //-----------------------------------------------------------------------
+    // CONSTRUCTOR:
+    //-----------------------------------------------------------------------
+
+    //! Constructor of cThreadConfig (no threads configured).
+    cThreadConfig(void);
+
+    //-----------------------------------------------------------------------
+    // METHODS:
+    //-----------------------------------------------------------------------
+
+    // Set the settings used for a thread unless the config file overrides them.
+    void setDefault(const char* a_name, int a_cpu, int a_policy, int a_priority);
+
+    // Read settings from a file (returns false if it cannot be read; defaults are kept).
+    bool load(const char* a_filename);
+
+    // Apply the settings for a_name to the calling thread and prefault its stack (returns false if any setting was refused).
+    bool apply(const char* a_name);
+
+    // Lock all current and future pages in RAM and prefault a_heapBytes of heap (returns false if locking was refused).
+    bool lockMemory(size_t a_heapBytes);
+
+    // Write requested vs. actual settings for every thread that has called apply().
+    void report(FILE* a_file) const;
+
+  private:
+
+    // Index of a thread's settings (-1 if not configured).
+    int find(const char* a_name) const;
+
+    // Read back the calling thread's actual settings.
+    void readActual(thread_settings& a_actual) const;
+
+    thread_settings m_requested[TC_MAX_THREADS];
+    thread_settings m_actual[TC_MAX_THREADS];
+    std::atomic<bool> m_applied[TC_MAX_THREADS];  // each entry is written only by the thread it describes
+    std::atomic<bool> m_ok[TC_MAX_THREADS];
+    int m_numThreads;
+
+    bool m_memoryLocked;
+    size_t m_heapPrefaulted;
+};
+
+#endif  // CTHREADCONFIG_H
@@ -3,6 +3,9 @@
 #define DATA_H
 
 #include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -15,6 +18,17 @@
 void linkSharedData(shared_data& sharedData);
 void setup(void);
 void saveOneTimeStep(void);
+void updateRecorder(void);
+void updateWriter(void);
+void updateDiagLog(void);
 void recordTrial(void);
+void describeSaveData(cSessionLogWriter& log);
+void writeTrial(const trial_buffer& trial, cSessionLogWriter& log);
+bool flushTrialData(void);
+bool closeSessionLog(void);
+void printRecorderStats(FILE* file);
+void benchmarkSampleStorage(FILE* file);
+void benchmarkLogFormat(FILE* file);
+void benchmarkSeqLock(FILE* file);
 
 #endif  // DATA_H
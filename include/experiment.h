@@ -3,7 +3,9 @@
 #define EXPERIMENT_H
 
 #include <cstdlib>
+#ifdef _WIN32
 #include <conio.h>
+#endif
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
@@ -11,6 +13,8 @@
 #include <string>
 #include "chai3d.h"
 #include "data.h"
+#include "NeuroTouch.h"
+#include "BCI.h"
 #include "shared_Data.h"
 
 void linkSharedDataToExperiment(shared_data& sharedData);
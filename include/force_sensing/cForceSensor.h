@@ -1,7 +1,7 @@
 #ifndef CFORCESENSOR_H
 #define CFORCESENSOR_H
 
-#include "cATIForceSensor.h"
+#include "cHardwareInterface.h"
 #include <string>
 
 class cForceSensor
@@ -9,6 +9,10 @@ class cForceSensor
 public:
     cForceSensor(void);
     ~cForceSensor(void);
+
+    // select the real ATI sensor or a simulated one (NOTE: call before Initialize_Force_Sensor; a simulated
+    // sensor reads contact force from a_simulatedMotors, if given)
+    void Set_Backend(int a_type, cMotorBackend* a_simulatedMotors = NULL);
 	int Initialize_Force_Sensor(std::string a_Device);
     int Zero_Force_Sensor(void);
     int Stop_Force_Sensor(void);
@@ -24,9 +28,9 @@ public:
 protected:
 
 private:
-    double m_Frequency;
-    int m_AveragingSize;
-    cATIForceSensor* FTSensor;
+    int m_BackendType;
+    cMotorBackend* m_SimulatedMotors;
+    cForceBackend* FTSensor;
     double m_FTData[6];
     std::string m_CalibrationFileLocation;
     
@@ -16,6 +16,18 @@
 #include "NIDAQmx.h"
 #include "cForceSensor.h"
 #include "cATIForceSensor.h"
+#include "cSeqLock.h"
+#include "cMailbox.h"
+#include "cLoopTimer.h"
+#include "cLatencyHistogram.h"
+#include "cThreadConfig.h"
+#include "cRingBuffer.h"
+#include "cSessionLog.h"
+#include "cBCI2000Parser.h"
+#include "cBCI2000Commands.h"
+#include "cInputRecording.h"
+#include "cInputSwitch.h"
+#include "cDiagLog.h"
 using namespace chai3d;
 using namespace std;
 
@@ -33,6 +45,13 @@ using namespace std;
 #define GTEC      1
 #define REC_SOCK  "192.168.1.195:20320"  // "IP address:port" defining UDP socket receiving state data into BrainGate desktop
 #define SEND_SOCK "192.168.1.235:20321"  // "IP address:port" defining UDP socket sending state data from g.MOBIlab+
+#define WAKE_SOCK "127.0.0.1:20322"      // loopback "IP address:port" used to wake the BCI thread when g.MOBIlab+ input is switched off
+// input sources traced from sample arrival to DAQ write (see input_tag)
+#define TRACE_NONE    -1
+#define TRACE_EMOTIV   0
+#define TRACE_GTEC     1
+#define TRACE_PHANTOM  2
+#define TRACE_SOURCES  3
 // force sensing
 #define FS_CALIB "C:\CalibrationFiles\FT13574.cal"
 #define FS_INIT  "Dev1/ai0:5"
@@ -58,8 +77,27 @@ using namespace std;
 #define TARGET_SIZE 0.04  // target radius
 #define TARGET_DIST 0.18  // distance of target from center
 #define CURSOR_SIZE 0.02  // cursor radius
+// hardware (NOTE: HW_HARDWARE/HW_SIMULATED are defined in cHardwareInterface.h)
+#define MAX_SPEEDUP 100.0  // fastest the loops may run relative to real time (simulated hardware only)
 // thread timing
-#define LOOP_TIME 0.001  // for regulating thread loop rates (sec)
+#define LOOP_TIME 0.001                      // for regulating thread loop rates (sec)
+#define NEUROTOUCH_LOOP_TIME LOOP_TIME       // haptic loop (must stay at 1 kHz)
+#define CURSOR_LOOP_TIME     0.005           // cursor model (BCI data arrives at ~16-50 Hz; the haptic loop predicts in between)
+#define RECORDER_LOOP_TIME   0.01            // draining saved samples from the experiment loop
+#define WRITER_LOOP_TIME     0.05            // writing completed trials to file
+#define DIAG_LOOP_TIME       0.05            // printing diagnostics messages logged by the other loops
+// trial timing
+#define TRIAL_TIME 20                        // max time per trial or washout [sec] (also sizes the sample ring)
+#define TRIAL_BUFFERS 4                      // trial buffers shared by the recorder and writer (bounds the writer's backlog)
+
+#define LOG_CLOSE_NONE          0            // session log in use by the recorder and writer (see closeSessionLog)
+#define LOG_CLOSE_REQUESTED     1            // recorder to stop appending, once it has drained what was saved before the request
+#define LOG_CLOSE_RECORDER_DONE 2            // writer to write what the recorder handed off, then close the log
+// thread configuration
+#define THREAD_CONFIG "threads.cfg"           // per-thread CPU/policy/priority (see cThreadConfig.h)
+#define HEAP_PREFAULT (32 * 1024 * 1024)      // heap locked and touched at start-up [bytes]
+#define PHANTOM_LOOP_TIME    LOOP_TIME
+#define EXPERIMENT_LOOP_TIME LOOP_TIME
 
 
 // data to save (NOTE: see below for any comments on meaning of variables)
@@ -88,12 +126,105 @@ typedef struct {
     
 } save_data;
 
+// samples of one trial (NOTE: preallocated; passed between the recorder and writer threads by pointer)
+typedef vector<save_data> trial_buffer;
+
+// haptic state published once per NeuroTouch tick (NOTE: other threads should read these values through shared_data::hapticState)
+typedef struct {
+    
+    double cursorPos;
+    double cursorVel;
+    double eeForceDesX;
+    double eeForceDesY;
+    float motorAPos;
+    float motorBPos;
+    double force[3];
+    unsigned long cursorResets;  // cursor resets reflected in this state (see resetCursor)
+    
+} haptic_state;
+
+// where a value came from, for end-to-end latency: the input source and the arrival time of the newest sample it depends on
+typedef struct {
+    
+    int source;             // TRACE_EMOTIV, TRACE_GTEC, TRACE_PHANTOM, or TRACE_NONE (e.g., autonomous cursor)
+    long long timeNs;       // arrival time (getMonotonicTimeNs) [nsec] (0 = nothing has arrived yet)
+    
+} input_tag;
+
+// latest g.MOBIlab+ data, published by the BCI thread whenever new data arrives
+typedef struct {
+    
+    float controlSig;
+    long long timeNs;       // arrival time (getMonotonicTimeNs) [nsec]
+    unsigned long count;    // number of samples published so far
+    
+} bci_sample;
+
+// latest PHANTOM state, published by the PHANTOM thread every PHANTOM_LOOP_TIME
+typedef struct {
+    
+    double pos;             // just in X [mm]
+    double vel;
+    long long timeNs;       // when pos/vel were read (getMonotonicTimeNs) [nsec] (0 = nothing read yet)
+    
+} phantom_sample;
+
+// cursor state published by the cursor model at CURSOR_LOOP_TIME
+typedef struct {
+    
+    double pos;
+    double vel;
+    long long timeNs;       // when this state was computed (getMonotonicTimeNs) [nsec]
+    unsigned long resets;   // cursor resets applied so far
+    input_tag input;        // newest input sample behind this state
+    
+} cursor_sample;
+
+// per-tick timing of the NeuroTouch loop (NOTE: each histogram is recorded by the NeuroTouch thread only)
+typedef struct {
+    
+    cLatencyHistogram period;        // time between successive ticks
+    cLatencyHistogram tick;          // total work per tick (over threshold = missed deadline)
+    cLatencyHistogram predictCursor;
+    cLatencyHistogram getPosition;
+    cLatencyHistogram computeForce;
+    cLatencyHistogram setForce;
+    
+} loop_timing;
+
+// end-to-end latency of one input source, from sample arrival to the DAQ write of the force it produced (NOTE: recorded by the NeuroTouch thread only)
+typedef struct {
+    
+    cLatencyHistogram latency;    // arrival to the first DAQ write reflecting the sample
+    cLatencyHistogram age;        // age of the newest sample at every DAQ write (how stale the force on the finger is)
+    
+} input_trace;
+
+// timing of g.MOBIlab+ data from socket to cursor model
+typedef struct {
+    
+    cLatencyHistogram interval;   // time between control signal updates (BCI thread)
+    cLatencyHistogram parse;      // from the BCI thread waking on new data to publishing it (BCI thread)
+    cLatencyHistogram staleness;  // age of the control signal each time the cursor model uses it (cursor thread)
+    
+} bci_timing;
+
 // data to share between all threads
 typedef struct {
     
     // simulation state
     bool simulationRunning;
     bool simulationFinished;  // dictated by NeuroTouch device
+    int hardware;             // HW_HARDWARE or HW_SIMULATED (set from the command line)
+    bool headless;            // run without graphics or set-up prompts
+    double speedup;           // loop rate relative to real time (1 unless simulated)
+    double runTime;           // how long a headless run lasts [sec] (0 = until killed)
+    bool mappedLog;           // preallocate and memory-map the session log (samples then go straight from the recorder thread to the file)
+    const char* recordFile;   // where raw BCI input is recorded (NULL = not recording)
+    const char* replayFile;   // recorded BCI input replayed in place of the live BCI (NULL = live input)
+    double replaySpeed;       // replay rate relative to real time (0 = as fast as possible)
+    int oscJitterMs;          // hold Emotiv OSC bundles until their time tag plus this [msec] (-1 = dispatch them on arrival)
+    bool oscDropLate;         // drop bundles whose time has passed when they arrive (instead of dispatching them at once)
     
     // device pointers
     cHapticDeviceHandler* p_phantomHandler;  // handler for the PHANTOM
@@ -103,42 +234,49 @@ typedef struct {
     // device frequency counters
     cFrequencyCounter phantomFreqCounter;     // counter to measure rate reading from PHANTOM device [Hz]
     cFrequencyCounter neurotouchFreqCounter;  // counter to measure rate reading from/commanding to NeuroTouch [Hz]
+    loop_timing neurotouchTiming;             // latency/jitter histograms for the NeuroTouch loop
+    input_trace inputTrace[TRACE_SOURCES];    // end-to-end latency per input source (see input_tag)
     
-    // PHANTOM state
-    double phantomPos;  // just in X [mm]
-    double phantomVel;
+    // PHANTOM state (position, velocity, and read time published together, so a sample is never tagged with a newer time than its data)
+    cMailbox<phantom_sample> phantomSample;  // written only by the PHANTOM thread, read only by the cursor thread
     
     // OSC processing
     OSC_Listener listener;  // "hears" messages passed through "Mind your OSCs" port
+    cInputRecorder inputRecorder;  // raw datagrams from the BCI sockets, with arrival times (BCI thread only)
     
-    // UDP sockets and TCP streams (for g.MOBIlab+)
-    receiving_udpsocket recSocket;
+    // UDP sockets and TCP stream (for g.MOBIlab+)
+    receiving_udpsocket recSocket;  // (BCI thread, opened and closed with BCI input)
     sockstream recStream;
-    sending_udpsocket sendSocket;
-    sockstream sendStream;
+    sending_udpsocket sendSocket;   // (experiment thread only, opened once by flushToGTec)
     
-    // BCI state (cognitive powers for Emotiv, map/control signal for g.MOBIlab+)
+    // BCI state (cognitive powers for Emotiv, BCI2000 states/control signal for g.MOBIlab+)
     float cogRight;
     float cogLeft;
     float cogNeut;
-    map<string, float> state;
+    cBCI2000Parser state;  // states registered in initBCI (NOTE: only touched by the BCI thread once it starts)
+    cBCI2000Commands gtecCommands;  // state updates for BCI2000, sent together once per experiment tick (see writeToGTec)
     float controlSig;  // just in X
     
     // NeuroTouch state
     float motorAPos;  // [deg] (NOTE: will need kinematics to convert to Cartesian ee positions (post-processing))
     float motorBPos;
     
+    // multi-rate pipeline (BCI thread -> cursor model -> haptic loop)
+    cMailbox<bci_sample> bciSample;               // written only by the BCI thread, read only by the cursor thread
+    cMailbox<cursor_sample> cursorSample;         // written only by the cursor thread, read only by the haptic loop
+    bci_timing bciTiming;
+    std::atomic<unsigned long> cursorResetRequests;
+    
     // control
     int opMode;
     int input;
+    cInputSwitch inputSwitch;  // runs the BCI or PHANTOM source matching input (see cInputSwitch)
     int bci;
     int controller;			 // default for safety
 	cPrecisionClock* time;   // running time for autonomous cursor control
     double autoFreq;         // frequency of autonomous cursor movement [Hz] (variable with keyboard input)
-    double cursorPos;
-    double cursorPosOneAgo;
+    double cursorPos;        // cursor state rendered in the current haptic tick (predicted from cursorSample)
     double cursorVel;
-    double cursorVelOneAgo;
     double eeForceDesX;      // desired, not actual, end-effector force [N]
     double eeForceDesY;
     
@@ -147,6 +285,9 @@ typedef struct {
     cForceSensor g_ForceSensor;
     double force[3];
     
+    // consistent snapshot of cursor, motor, and force state (written only by the NeuroTouch thread)
+    cSeqLock<haptic_state> hapticState;
+    
     // graphics
     int targetSide;
     string message;
@@ -160,13 +301,28 @@ typedef struct {
     bool trialSuccess;
     
     // data storage
-    vector<save_data> trialData;  // for one trial of experiment
-    FILE* outputFile;              // output file for entire experiment (all blocks/trials)
+    cRingBuffer<save_data> trialRing;           // samples saved by the experiment thread, drained by the recorder thread
+    cRingBuffer<size_t> trialEnds;              // sample counts at which trials ended (experiment -> recorder)
+    cRingBuffer<trial_buffer*> writerQueue;     // completed trials (recorder -> writer)
+    cRingBuffer<trial_buffer*> freeBuffers;     // emptied trial buffers (writer -> recorder)
+    std::atomic<unsigned long> trialsRecorded;  // trials ended by the experiment thread
+    std::atomic<unsigned long> trialsWritten;   // trials written to file by the writer thread
+    std::atomic<unsigned long> writerStalls;    // times the recorder had to wait for an empty buffer (back-pressure)
+    std::atomic<unsigned long> maxWriterBacklog;
+    cSessionLogWriter outputLog;   // binary log for entire experiment (all blocks/trials; see sessionLogToText for the text format)
+    std::atomic<int> logClose;     // LOG_CLOSE_* (the writer thread closes outputLog, so neither thread is using it then)
+    
+	// timers to regulate thread loop rates (each loop sleeps until its next deadline)
+	cLoopTimer m_phantomLoopTimer;
+	cLoopTimer m_cursorLoopTimer;
+	cLoopTimer m_neurotouchLoopTimer;
+	cLoopTimer m_expLoopTimer;
+	cLoopTimer m_recorderLoopTimer;
+	cLoopTimer m_writerLoopTimer;
+	cLoopTimer m_diagLoopTimer;
     
-	// timers to regulate thread loop rates
-	cPrecisionClock m_phantomLoopTimer;
-	cPrecisionClock m_neurotouchLoopTimer;
-	cPrecisionClock m_expLoopTimer;
+    // CPU pinning, real-time scheduling, and memory locking for each thread
+    cThreadConfig threadConfig;
 
 } shared_data;
 
@@ -1,96 +1,298 @@
 
 #include "BCI.h"
+#include "OscBundleScheduler.h"
+#include <sstream>
+#include <math.h>
 using namespace std;
 
 
+static const char* controlSigState = "Signal(1,0)";  // Y control signal (the one changing in BCI2000 CursorTask)
+static const int waitTimeout = 100;                    // longest the BCI thread blocks on the socket before checking for shutdown [msec]
+static const int benchmarkRepeats = 20;                // passes over the traffic timed by benchmarkGTecParser
+static const int benchmarkBlocks = 10000;              // blocks of synthetic traffic if no recording is given
+static const size_t benchmarkChunk = 512;              // bytes handed to the parser at a time (splits lines across chunks)
+static const long long replayWait = 10000000;          // longest the replay sleeps between checks for being switched off [nsec]
+
+static int controlSigSlot = -1;    // where the parser stores controlSigState
+static char datagram[64 * 1024];   // raw bytes received from BCI2000 (parsed in place)
+static std::atomic<cInputRecorder*> recorder(NULL);  // where BCI datagrams are recorded (NULL = not recording)
+static bool sendOpened = false;    // whether flushToGTec has opened the send socket (experiment thread only)
+
 static shared_data* p_sharedData;  // structure for sharing data between threads
 
 
-// point p_sharedData to sharedData, which is the data shared between all threads
-void linkSharedDataToBCI(shared_data& sharedData) {
+// publish the Y control signal if the datagrams just parsed updated it (before = its update count beforehand)
+static void publishControlSig(bci_sample& sample, unsigned long before, long long arrived) {
     
-    p_sharedData = &sharedData;
+    if (p_sharedData->state.getUpdates(controlSigSlot) == before) return;
+    if (sample.count > 0) p_sharedData->bciTiming.interval.record(arrived - sample.timeNs);
+    sample.controlSig = p_sharedData->state.getValue(controlSigSlot);
+    sample.timeNs = arrived;
+    (sample.count)++;
+    p_sharedData->bciSample.write(sample);
+    p_sharedData->bciTiming.parse.record(getMonotonicTimeNs() - arrived);
     
 }
 
-// initialize BCI state (plus any associated) data and (if necessary) open a connection with the g.MOBIlab+
-void initBCI(void) {
 
-	// reset BCI state
-    p_sharedData->state.clear();
-    p_sharedData->cogRight = 0;
-	p_sharedData->cogLeft = 0;
-	p_sharedData->cogNeut = 0;
+// records each Emotiv datagram as it comes off the socket, then passes it on (NOTE: ahead of any jitter buffer, so held and dropped bundles are recorded at arrival too)
+class cOscRecordingTap : public PacketListener
+{
+  public:
+    cOscRecordingTap(void) : m_next(NULL) {}
     
-    // reset the kinematic variables controlled by the BCI state
-    p_sharedData->cursorPos = 0;
-	p_sharedData->cursorPosOneAgo = 0;
-	p_sharedData->cursorVel = 0;
-	p_sharedData->cursorVelOneAgo = 0;
-    
-    if (p_sharedData->bci == GTEC) {
-        bool sending = false;
-        bool receiving = false;
+    void setNext(PacketListener* a_next) { m_next = a_next; }
+    virtual void ProcessPacket(const char* data, int size, const IpEndpointName& remoteEndpoint) {
+        cInputRecorder* active = recorder.load();
+        if (active != NULL) active->record(INPUT_OSC, data, size, getMonotonicTimeNs());
+        m_next->ProcessPacket(data, size, remoteEndpoint);
+    }
+    
+  private:
+    PacketListener* m_next;
+};
+
+
+// Emotiv, through "Mind your OSCs" (oscpack runs its own receive loop, which AsynchronousBreak ends)
+class cEmotivInput : public cInputSource
+{
+  public:
+    cEmotivInput(void) : m_socket(NULL), m_scheduler(NULL) {}
+    
+    bool open(void) {
+        try {
+            m_socket = new UdpReceiveSocket(IpEndpointName(IpEndpointName::ANY_ADDRESS, PORT));
+        }
+        catch (std::exception& e) {
+            printf("\nUNABLE TO LISTEN ON PORT %d: %s", PORT, e.what());
+            m_socket = NULL;
+            return false;
+        }
         
-        // if not already done, open the sockets and streams
+        // packets are recorded first, then reach the listener (through the jitter buffer, if any) (NOTE: the buffer is made on first use and kept, so its counts cover the whole run)
+        m_tap.setNext(&(p_sharedData->listener));
+        if (p_sharedData->oscJitterMs >= 0) {
+            if (m_scheduler == NULL) m_scheduler = new osc::BundleScheduler(&(p_sharedData->listener), &m_mux);
+            m_scheduler->SetPlayoutDelay(p_sharedData->oscJitterMs);
+            m_scheduler->SetLatePolicy(p_sharedData->oscDropLate ? osc::BundleScheduler::DROP_LATE : osc::BundleScheduler::DELIVER_LATE);
+            m_scheduler->Synchronize();
+            m_tap.setNext(m_scheduler);
+        }
+        m_mux.AttachSocketListener(m_socket, &m_tap);
+        printf("\nLISTENING FOR EMOTIV...\n");
+        return true;
+    }
+    void run(void) { m_mux.Run(); }
+    void interrupt(void) { m_mux.AsynchronousBreak(); }
+    void close(void) {
+        if (m_scheduler != NULL) m_scheduler->Clear();  // (held bundles would be stale by the next open)
+        m_mux.DetachSocketListener(m_socket, &m_tap);
+        delete m_socket;
+        m_socket = NULL;
+    }
+    
+    // jitter buffer (NULL if bundles have always been dispatched on arrival)
+    const osc::BundleScheduler* getScheduler(void) const { return m_scheduler; }
+    
+  private:
+    SocketReceiveMultiplexer m_mux;  // (kept across opens: a break sent after a run ended does not carry over to the next)
+    UdpReceiveSocket* m_socket;
+    cOscRecordingTap m_tap;
+    osc::BundleScheduler* m_scheduler;
+};
+
+
+// g.MOBIlab+, through the BCI2000 AppConnector (blocks on the socket; interrupt() sends a datagram to a loopback socket waited on alongside it)
+class cGTecInput : public cInputSource
+{
+  public:
+    cGTecInput(void) : m_stop(false) {}
+    
+    bool open(void) {
+        
+        // open the receiving sockets and stream (NOTE: the send socket belongs to the experiment thread; see flushToGTec)
+        m_stop = false;
         if (!p_sharedData->recSocket.is_open()) p_sharedData->recSocket.open(REC_SOCK);
         if (!p_sharedData->recStream.is_open()) p_sharedData->recStream.open(p_sharedData->recSocket);
-		if (!p_sharedData->sendSocket.is_open()) p_sharedData->sendSocket.open(SEND_SOCK);
-        if (!p_sharedData->sendStream.is_open()) p_sharedData->sendStream.open(p_sharedData->sendSocket);
+        if (!m_wake.is_open()) m_wake.open(WAKE_SOCK);
+        if (!m_waker.is_open()) m_waker.open(WAKE_SOCK);
         
-        // check that the connection with g.MOBIlab+ is established
-        if (!p_sharedData->recStream.is_open()) {
-            receiving = false;
-            printf("\nUNABLE TO RECEIVE DATA...");
-        } else {
-            receiving = true;
-            printf("\nRECEIVING DATA...");
-        }
-        if (!p_sharedData->sendStream.is_open()) {
-            sending = false;
-            printf("\nUNABLE TO SEND DATA...\n");
-        } else {
-            sending = true;
-            printf("\nSENDING DATA...\n");
+        // check that the connection with g.MOBIlab+ is established (if not, the input switch tries again shortly)
+        bool receiving = p_sharedData->recStream.is_open();
+        printf(receiving ? "\nRECEIVING DATA...\n" : "\nUNABLE TO RECEIVE DATA...\n");
+        if (!m_wake.is_open() || !m_waker.is_open()) printf("\nUNABLE TO OPEN WAKE SOCKET %s...\n", WAKE_SOCK);
+        if (receiving && m_wake.is_open() && m_waker.is_open()) return true;
+        close();
+        return false;
+        
+    }
+    
+    // block on the g.MOBIlab+ stream, publishing a timestamped sample whenever BCI2000 sends new state
+    void run(void) {
+        
+        bci_sample sample;
+        sample.controlSig = 0;
+        sample.timeNs = 0;
+        sample.count = 0;
+        
+        // (built once, since streamsock::wait_for_read(timeout) builds a new set on every call)
+        streamsock::set_of_instances sockets;
+        sockets.insert(&(p_sharedData->recSocket));
+        sockets.insert(&m_wake);
+        
+        while (!m_stop) {
+            if (!streamsock::wait_for_read(sockets, waitTimeout) || m_stop) continue;
+            long long arrived = getMonotonicTimeNs();
+            
+            // publish the Y control signal whenever BCI2000 sends it
+            unsigned long before = p_sharedData->state.getUpdates(controlSigSlot);
+            if (readFromGTec(p_sharedData->state, p_sharedData->recSocket)) publishControlSig(sample, before, arrived);
         }
         
-        // keep trying to initialize until the connection is established
-        while (!sending || !receiving) {
-            cSleepMs(2500);
-            initBCI();
+    }
+    
+    void interrupt(void) {
+        m_stop = true;
+        char wake = 0;
+        m_waker.write(&wake, 1);
+    }
+    
+    void close(void) {
+        p_sharedData->recStream.close();
+        p_sharedData->recStream.clear();
+        p_sharedData->recSocket.close();
+        m_wake.close();
+        m_waker.close();
+    }
+    
+  private:
+    std::atomic<bool> m_stop;
+    receiving_udpsocket m_wake;   // (left unread: once it is readable the loop is on its way out)
+    sending_udpsocket m_waker;
+};
+
+
+// recorded input, fed through the same listener/parser as live input at replaySpeed times real time (or as fast as possible)
+class cReplayInput : public cInputSource
+{
+  public:
+    cReplayInput(void) : m_stop(false) {}
+    
+    bool open(void) {
+        m_stop = false;
+        return m_replay.open(p_sharedData->replayFile);
+    }
+    
+    // (returns at the end of the recording; selecting BCI again replays it from the start)
+    void run(void) {
+        
+        bci_sample sample;
+        sample.controlSig = 0;
+        sample.timeNs = 0;
+        sample.count = 0;
+        
+        cLoopTimer pacer;
+        unsigned long datagrams = 0;
+        unsigned long long bytes = 0;
+        long long start = getMonotonicTimeNs();
+        while (!m_stop && m_replay.next()) {
+            
+            // wait until the datagram is due (in slices, so a long pause in the recording cannot hold up a switch or shutdown)
+            if (p_sharedData->replaySpeed > 0) {
+                long long due = start + (long long)(m_replay.getTime() / p_sharedData->replaySpeed);
+                while (!m_stop && getMonotonicTimeNs() + replayWait < due) pacer.waitUntil(getMonotonicTimeNs() + replayWait);
+                if (m_stop) break;
+                pacer.waitUntil(due);
+            }
+            
+            // (a datagram's arrival is when it is replayed, so the latency histograms measure this run)
+            long long arrived = getMonotonicTimeNs();
+            if (m_replay.getSource() == INPUT_OSC) {
+                p_sharedData->listener.ProcessPacket(m_replay.getData(), (int)m_replay.getLength(), IpEndpointName());
+            }
+            else if (m_replay.getSource() == INPUT_BCI2000) {
+                unsigned long before = p_sharedData->state.getUpdates(controlSigSlot);
+                p_sharedData->state.parse(m_replay.getData(), m_replay.getLength());
+                publishControlSig(sample, before, arrived);
+            }
+            datagrams++;
+            bytes += m_replay.getLength();
         }
+        
+        double elapsed = (getMonotonicTimeNs() - start) * 1.0e-9;
+        printf("\nReplayed %lu datagrams (%.1f MB) from %s in %.3f sec (%.1f MB/s, %.0f datagrams/s)\n", datagrams, bytes * 1.0e-6,
+               p_sharedData->replayFile, elapsed, (elapsed > 0) ? bytes * 1.0e-6 / elapsed : 0.0, (elapsed > 0) ? datagrams / elapsed : 0.0);
+        
+    }
+    
+    void interrupt(void) { m_stop = true; }
+    void close(void) { m_replay.close(); }
+    
+  private:
+    std::atomic<bool> m_stop;
+    cInputReplayer m_replay;
+};
+
+
+static cEmotivInput emotivInput;
+static cGTecInput gtecInput;
+static cReplayInput replayInput;
+
+
+// point p_sharedData to sharedData, which is the data shared between all threads, and register the BCI as an input source
+void linkSharedDataToBCI(shared_data& sharedData) {
+    
+    p_sharedData = &sharedData;
+    
+    // (a replay stands in for the BCI it was recorded from)
+    if (sharedData.replayFile != NULL)  sharedData.inputSwitch.setSource(BCI, &replayInput);
+    else if (sharedData.bci == EMOTIV)  sharedData.inputSwitch.setSource(BCI, &emotivInput);
+    else if (sharedData.bci == GTEC)    sharedData.inputSwitch.setSource(BCI, &gtecInput);
+    
+}
+
+// initialize BCI state (plus any associated) data, before the input switch selects BCI
+void initBCI(void) {
+
+	// reset BCI state (and register the g.MOBIlab+ states we use, so parsing never allocates)
+    p_sharedData->state.reset();
+    controlSigSlot = p_sharedData->state.registerState(controlSigState);
+    p_sharedData->cogRight = 0;
+	p_sharedData->cogLeft = 0;
+	p_sharedData->cogNeut = 0;
+    
+    // reset the kinematic variables controlled by the BCI state
+    resetCursor();
+    
+    // record raw input if asked (NOTE: the sockets themselves are opened by the BCI thread, once the input switch selects BCI)
+    if (p_sharedData->recordFile != NULL && !p_sharedData->inputRecorder.isOpen() && p_sharedData->inputRecorder.open(p_sharedData->recordFile, p_sharedData->bci)) {
+        recorder = &(p_sharedData->inputRecorder);
     }
     
 }
 
-// update state of BCI (NOTE: automatically done for the g.MOBIlab+ since sockets/streams already open)
+// host the BCI input source, running it whenever the input switch selects BCI (NOTE: each BCI is read at the rate its data arrives, not at the haptic rate)
 void updateBCI(void) {
     
-	// plug in the socket to start listening to the Emotiv
-	if (p_sharedData->bci == EMOTIV) {
-		UdpListeningReceiveSocket socket(IpEndpointName(IpEndpointName::ANY_ADDRESS, PORT), &(p_sharedData->listener));
-		socket.RunUntilSigInt();
-	}
-
+    p_sharedData->threadConfig.apply("bci");
+    diagLog.attachThread();
+    p_sharedData->inputSwitch.host(BCI);
+    
 }
 
-// update map holding state of g.MOBIlab+
-bool readFromGTec(map<string, float> &state, sockstream &recStream) {
+// update registered states of g.MOBIlab+ from every datagram waiting on the socket (NOTE: read straight from the socket, bypassing recStream, and parsed in place)
+bool readFromGTec(cBCI2000Parser &state, streamsock &recSocket) {
     
 	int count = 0;
     
     // read state data while available
-    while (recStream.rdbuf()->in_avail()) {
-		string label;
-        float value;
-        recStream >> label >> value;
-		// ignore and clear ensure correct handling of toggle between RESUME & SUSPEND in BCI2000 app
-		recStream.ignore();
-        if (!recStream) recStream.clear();
-        state[label] = value;
-        count++;
+    while (recSocket.can_read()) {
+        size_t length = recSocket.read(datagram, sizeof(datagram));
+        if (length == 0) break;  // (socket closed)
+        cInputRecorder* active = recorder.load();
+        if (active != NULL) active->record(INPUT_BCI2000, datagram, length, getMonotonicTimeNs());
+        count += state.parse(datagram, length);
     }
-    recStream.clear();
     
     // if we read and recorded data, return true
     if (count > 0) return true;
@@ -98,23 +300,129 @@ bool readFromGTec(map<string, float> &state, sockstream &recStream) {
     
 }
 
-// overwrite a desired state of g.MOBIlab+
-void writeToGTec(string state, short value, sockstream &sendStream) {
+// queue an update of a g.MOBIlab+ state (NOTE: nothing is sent until flushToGTec, and setting the state again before then just replaces the value)
+bool writeToGTec(const char* state, int value) {
+    
+    return p_sharedData->gtecCommands.set(state, value);
+    
+}
+
+// send every queued state update to g.MOBIlab+ in one datagram (NOTE: called once per experiment tick; queue and flush from the experiment thread only,
+// which also owns the send socket: it is opened here once, on first use, and left open, so the BCI thread never closes it under a send)
+size_t flushToGTec(void) {
     
-    sendStream << state << ' ' << value << endl;
+    if (p_sharedData->gtecCommands.getPending() > 0 && !sendOpened) {
+        sendOpened = true;
+        p_sharedData->sendSocket.open(SEND_SOCK);
+        printf(p_sharedData->sendSocket.is_open() ? "\nSENDING DATA...\n" : "\nUNABLE TO SEND DATA...\n");
+    }
+    return p_sharedData->gtecCommands.flush(p_sharedData->sendSocket);
     
 }
 
-// if necessary, close the connection with g.MOBIlab+ (NOTE: because the Emotiv socket is only locally declared in the update function above (does not work to declare it in "shared_Data.h"), there is no way to break it)
+// write how often Emotiv states arrived, or g.MOBIlab+ timing, including how stale the control signal was when the cursor model used it
+void printBCITiming(FILE* file) {
+    
+    if (p_sharedData->bci == EMOTIV) {
+        emo_state state;
+        p_sharedData->listener.getEmoState(state);
+        fprintf(file, "Emotiv cognitive states (%lu received, %.1f per second lately, %llu reads retried over an update)\n",
+                state.sequence, p_sharedData->listener.getUpdateRate(), p_sharedData->listener.getTornReads());
+        const osc::BundleScheduler* scheduler = emotivInput.getScheduler();
+        if (scheduler != NULL) {
+            fprintf(file, "  jitter buffer (%d msec): %lu packets passed through, %lu bundles held (%lu released, %lu released early when full, %lu discarded), arriving up to %.1f msec ahead\n",
+                    p_sharedData->oscJitterMs, scheduler->Passed(), scheduler->Held(), scheduler->Released(), scheduler->Overflowed(), scheduler->Discarded(), scheduler->MaxLead() * 1.0e-6);
+            fprintf(file, "  %lu bundles late (up to %.1f msec), %lu of them dropped\n", scheduler->Late(), scheduler->MaxLateness() * 1.0e-6, scheduler->Dropped());
+        }
+        return;
+    }
+    if (p_sharedData->bci != GTEC) return;
+    fprintf(file, "g.MOBIlab+ timing (%lu control signals received, %lu used by the cursor model)\n",
+            p_sharedData->bciSample.getWriteCount(), p_sharedData->bciSample.getFreshReadCount());
+    p_sharedData->bciTiming.interval.print(file, "interval");
+    p_sharedData->bciTiming.parse.print(file, "parse");
+    p_sharedData->bciTiming.staleness.print(file, "staleness");
+    if (p_sharedData->gtecCommands.getQueued() > 0) {
+        fprintf(file, "  %lu state updates queued, %lu replaced before sending, %lu datagrams sent\n", p_sharedData->gtecCommands.getQueued(),
+                p_sharedData->gtecCommands.getCollapsed(), p_sharedData->gtecCommands.getDatagrams());
+    }
+    
+}
+
+// finish any recording (NOTE: call once the input switch has stopped BCI input, which closes the sockets on the BCI thread)
 void closeBCI(void) {
     
-    if (p_sharedData->bci == GTEC) {
-        p_sharedData->recStream.close();
-        p_sharedData->recStream.clear();
-        p_sharedData->recSocket.close();
-        p_sharedData->sendStream.close();
-        p_sharedData->sendStream.clear();
-        p_sharedData->sendStream.close();
+    recorder = NULL;
+    if (p_sharedData->inputRecorder.isOpen()) {
+        printf("\nRecorded %lu BCI datagrams to %s\n", p_sharedData->inputRecorder.getDatagrams(), p_sharedData->recordFile);
+        p_sharedData->inputRecorder.close();
+    }
+    
+}
+
+// time parsing BCI2000 state traffic with the old stream/map reader and cBCI2000Parser, and write a summary to a file (synthetic traffic if trafficFile is NULL)
+void benchmarkGTecParser(FILE* file, const char* trafficFile) {
+    
+    // traffic: a raw capture of the AppConnector stream, or blocks of the states BCI2000 CursorTask sends
+    string traffic;
+    if (trafficFile != NULL) {
+        ifstream in(trafficFile, ios::binary);
+        if (!in) {
+            fprintf(file, "Unable to read %s\n", trafficFile);
+            return;
+        }
+        ostringstream contents;
+        contents << in.rdbuf();
+        traffic = contents.str();
     }
+    else {
+        char line[64];
+        for (int block = 0; block < benchmarkBlocks; block++) {
+            sprintf(line, "Running 1\nRecording 1\nSourceTime %d\nStimulusTime %d\n", (block * 50) % 65536, (block * 50 + 3) % 65536);
+            traffic += line;
+            sprintf(line, "TargetCode %d\nResultCode 0\nFeedback 1\n", 1 + block % 2);
+            traffic += line;
+            sprintf(line, "CursorPosX %d\nCursorPosY %d\n", 2048 + block % 300, 2048 - block % 500);
+            traffic += line;
+            sprintf(line, "Signal(0,0) %g\n%s %g\n", 0.125 * sin(0.01 * block), controlSigState, -37.5 * cos(0.013 * block));
+            traffic += line;
+        }
+    }
+    
+    // before: iostream extraction into a map, then a lookup by name
+    map<string, float> state;
+    float oldValue = 0;
+    unsigned long oldLines = 0;
+    long long t0 = getMonotonicTimeNs();
+    for (int repeat = 0; repeat < benchmarkRepeats; repeat++) {
+        istringstream stream(traffic);
+        string label;
+        float value;
+        while (stream >> label >> value) {
+            state[label] = value;
+            oldLines++;
+        }
+        oldValue = state[controlSigState];
+    }
+    long long oldNs = getMonotonicTimeNs() - t0;
+    
+    // after: in-place scan into registered slots (fed in chunks, as datagrams would arrive)
+    cBCI2000Parser parser;
+    int slot = parser.registerState(controlSigState);
+    t0 = getMonotonicTimeNs();
+    for (int repeat = 0; repeat < benchmarkRepeats; repeat++) {
+        for (size_t offset = 0; offset < traffic.size(); offset += benchmarkChunk) {
+            size_t length = traffic.size() - offset;
+            if (length > benchmarkChunk) length = benchmarkChunk;
+            parser.parse(traffic.data() + offset, length);
+        }
+    }
+    long long newNs = getMonotonicTimeNs() - t0;
+    
+    double bytes = (double)traffic.size() * benchmarkRepeats;
+    fprintf(file, "BCI2000 state parsing, %lu bytes (%s) x %d:\n", (unsigned long)traffic.size(), (trafficFile != NULL) ? trafficFile : "synthetic", benchmarkRepeats);
+    fprintf(file, "  %-10s %8.1f MB/s  %6.1f nsec/line\n", "stream/map", bytes / (oldNs * 1.0e-3), (double)oldNs / oldLines);
+    fprintf(file, "  %-10s %8.1f MB/s  %6.1f nsec/line\n", "parser", bytes / (newNs * 1.0e-3), (double)newNs / parser.getLines());
+    fprintf(file, "  last %s: %g (stream/map), %g (parser)\n", controlSigState, oldValue, parser.getValue(slot));
     
 }
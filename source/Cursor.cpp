@@ -0,0 +1,175 @@
+#include "Cursor.h"
+using namespace std;
+
+
+static const double mCursor = 5000.0;           // mass of cursor (scales cognitive "force" on cursor)
+static const double gTecScalar = 0.0001;        // to scale control signal output from BCI2000 module
+static const double phantomScalar = 2;          // to scale PHANTOM workspace to graphics workspace
+static const double A = 0.15;                   // amplitude of autonomous cursor movement
+static const double pi = 3.14159;               // for conversion to radians/sec
+static const double maxPos = 0.2;               // to limit cursor movement
+static const double maxStep = 0.1;              // longest integration step (e.g., after the thread was starved) [sec]
+static const double maxExtrapolation = 0.02;    // furthest the haptic loop predicts past the latest cursor state [sec]
+static const int resetTimeout = 100;            // how long resetCursor waits for the haptic loop [msec]
+
+static shared_data* p_sharedData;  // structure for sharing data between threads
+
+// cursor model state (NOTE: only touched by the cursor thread; other threads see it through shared_data::cursorSample)
+static double cursorPos = 0;
+static double cursorVel = 0;
+static unsigned long resetsApplied = 0;
+static input_tag input = {TRACE_NONE, 0};  // newest input sample the cursor state depends on
+static cursor_sample sample;
+
+
+// initialize cursor model loop timer
+void initCursor(void) {
+    
+	p_sharedData->m_cursorLoopTimer.setPeriodSeconds(CURSOR_LOOP_TIME / p_sharedData->speedup);
+	p_sharedData->m_cursorLoopTimer.start();
+    
+}
+
+// point p_sharedData to sharedData, which is the data shared between all threads
+void linkSharedDataToCursor(shared_data& sharedData) {
+    
+    p_sharedData = &sharedData;
+    
+}
+
+// cursor loop (NOTE: runs slower than the haptic loop, which predicts the cursor between updates)
+void updateCursor(void) {
+    
+    p_sharedData->threadConfig.apply("cursor");
+    long long lastTime = getMonotonicTimeNs();
+    
+    while (p_sharedData->simulationRunning) {
+        
+        // sleep until the next update is due
+        p_sharedData->m_cursorLoopTimer.waitForNextPeriod();
+        
+        // integrate over the time that actually passed (in simulation time, if running faster than real time)
+        long long now = getMonotonicTimeNs();
+        double dt = p_sharedData->speedup * (double)(now - lastTime) * 1.0e-9;
+        lastTime = now;
+        if (dt > maxStep) dt = maxStep;
+        stepCursor(dt);
+        
+        // publish timestamped cursor state
+        sample.pos = cursorPos;
+        sample.vel = cursorVel;
+        sample.timeNs = now;
+        sample.resets = resetsApplied;
+        sample.input = input;
+        p_sharedData->cursorSample.write(sample);
+    }
+    
+}
+
+// advance position and velocity of cursor by dt [sec] based on designated input
+void stepCursor(double dt) {
+    
+    // apply any pending reset before integrating
+    unsigned long requested = p_sharedData->cursorResetRequests.load();
+    if (requested != resetsApplied) {
+        cursorPos = 0;
+        cursorVel = 0;
+        resetsApplied = requested;
+    }
+    
+    if (p_sharedData->input == BCI) {
+        
+        if (p_sharedData->bci == EMOTIV) {
+
+            // query the Emotiv listener
+            input.source = TRACE_EMOTIV;
+            p_sharedData->listener.queryEmoState(p_sharedData->cogRight, p_sharedData->cogLeft, p_sharedData->cogNeut, input.timeNs);
+            
+            // sum of cognitive powers (right, left, neutral) = "force" on cursor along X
+            double cursorForce = p_sharedData->cogRight - p_sharedData->cogLeft;
+            double cursorAcc = cursorForce / mCursor;
+            
+            // integrate (via Euler) acceleration to get new cursor velocity
+            cursorVel = cursorVel + cursorAcc * dt;
+        }
+        
+        else if (p_sharedData->bci == GTEC) {
+
+			// latest Y control signal (the one changing in BCI2000 CursorTask) from the BCI thread, which scales to X cursor velocity
+            bci_sample bci;
+            p_sharedData->bciSample.read(bci);
+            p_sharedData->controlSig = bci.controlSig;
+            cursorVel = gTecScalar * p_sharedData->controlSig;
+            if (bci.count > 0) p_sharedData->bciTiming.staleness.record(getMonotonicTimeNs() - bci.timeNs);
+            input.source = TRACE_GTEC;
+            input.timeNs = (bci.count > 0) ? bci.timeNs : 0;
+        }
+		
+        // integrate (via Euler) velocity to get new cursor position
+        cursorPos = cursorPos + cursorVel * dt;
+        
+    } else if (p_sharedData->input == PHANTOM) {
+        
+        // scale the latest PHANTOM state from the PHANTOM thread for graphics workspace
+        phantom_sample phantom;
+        p_sharedData->phantomSample.read(phantom);
+        cursorVel = phantomScalar * phantom.vel;
+        cursorPos = phantomScalar * phantom.pos;
+        input.source = TRACE_PHANTOM;
+        input.timeNs = phantom.timeNs;
+        
+    } else {
+        
+        // autonomous, sinusoidal input (i.e., cursor moves on its own)
+        cursorPos = A * sin(2.0 * pi * p_sharedData->autoFreq * p_sharedData->time->getCurrentTimeSeconds());
+        cursorVel = (A * 2.0 * pi * p_sharedData->autoFreq) * cos(2.0 * pi * p_sharedData->autoFreq * p_sharedData->time->getCurrentTimeSeconds());
+        input.source = TRACE_NONE;
+        input.timeNs = 0;
+    }
+
+	// limit cursor movement if necessary
+	if (cursorPos > maxPos) {
+		cursorPos = maxPos;
+		cursorVel = 0;
+	}
+	if (cursorPos < -maxPos) {
+		cursorPos = -maxPos;
+		cursorVel = 0;
+	}
+    
+}
+
+// return cursor to center (NOTE: if the simulation is running, waits until the haptic loop renders the reset so callers never see the old position)
+void resetCursor(void) {
+    
+    unsigned long request = ++(p_sharedData->cursorResetRequests);
+    if (!p_sharedData->simulationRunning) return;
+    
+    haptic_state haptic;
+    for (int i = 0; i < resetTimeout; i++) {
+        p_sharedData->hapticState.read(haptic);
+        if ((long)(haptic.cursorResets - request) >= 0) return;
+        cSleepMs(1);
+    }
+    
+}
+
+// cursor state at time nowNs [nsec], extrapolated from the latest published state, and the input behind it (called by the haptic loop)
+void predictCursor(long long nowNs, double& pos, double& vel, unsigned long& resets, input_tag& input) {
+    
+    cursor_sample latest;
+    p_sharedData->cursorSample.read(latest);
+    
+    // constant-velocity prediction, bounded so a stalled cursor thread cannot run the cursor away
+    double ahead = p_sharedData->speedup * (double)(nowNs - latest.timeNs) * 1.0e-9;
+    if (ahead < 0) ahead = 0;
+    if (ahead > maxExtrapolation) ahead = maxExtrapolation;
+    
+    pos = latest.pos + latest.vel * ahead;
+    vel = latest.vel;
+    if (pos > maxPos)  pos = maxPos;
+    if (pos < -maxPos) pos = -maxPos;
+    resets = latest.resets;
+    input = latest.input;
+    
+}
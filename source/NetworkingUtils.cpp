@@ -27,6 +27,9 @@
 	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
+// Win32 implementation (see NetworkingUtilsLinux.cpp for Linux)
+#ifdef _WIN32
+
 #include "NetworkingUtils.h"
 
 #include <winsock2.h>   // this must come first to prevent errors with MSVC7
@@ -86,3 +89,5 @@ unsigned long GetHostByName( const char *name )
 
     return result;
 }
+
+#endif /* _WIN32 */
@@ -3,17 +3,12 @@
 using namespace std;
 
 
-static const double mCursor = 5000.0;    // mass of cursor (scales cognitive "force" on cursor)
-static const double gTecScalar = 0.0001; // to scale control signal output from BCI2000 module
-static const double dt = 0.02;           // time between graphic updates [sec]
-static const double phantomScalar = 2;   // to scale PHANTOM workspace to graphics workspace
-static const double A = 0.15;            // amplitude of autonomous cursor movement
-static const double pi = 3.14159;        // for conversion to radians/sec
-static const double maxPos = 0.2;		 // to limit cursor movement
 static const double Kpos = 2.5;          // position-based control gain
 static const double Kvel = 1.5;          // velocity-based control gain
+static const char* traceNames[TRACE_SOURCES] = {"Emotiv", "g.MOBIlab+", "PHANTOM"};  // indexed by TRACE_*
 
 static shared_data* p_sharedData;  // structure for sharing data between threads
+static haptic_state snapshot;      // staging copy of haptic state, published once per tick
 
 
 // initialize NeuroTouch
@@ -23,15 +18,19 @@ void initNeuroTouch(void) {
 	p_sharedData->p_NeuroTouch->initADC();
     p_sharedData->p_NeuroTouch->setForce(0,0);
     
-    // prompt user to "zero" device
-    printf("\nMove the skin-stretch tactor to home, then press any key to continue.\n");
-    while (true) {
-        if (_kbhit()) break;
+    // prompt user to "zero" device (NOTE: the simulated device starts at home)
+#ifdef _WIN32
+    if (p_sharedData->hardware == HW_HARDWARE && !p_sharedData->headless) {
+        printf("\nMove the skin-stretch tactor to home, then press any key to continue.\n");
+        while (true) {
+            if (_kbhit()) break;
+        }
     }
+#endif
     p_sharedData->p_NeuroTouch->zeroEncoders();
     
     // initialize device loop timer
-	p_sharedData->m_neurotouchLoopTimer.setTimeoutPeriodSeconds(LOOP_TIME);
+	p_sharedData->m_neurotouchLoopTimer.setPeriodSeconds(NEUROTOUCH_LOOP_TIME / p_sharedData->speedup);
 	p_sharedData->m_neurotouchLoopTimer.start();
     
 }
@@ -46,31 +45,61 @@ void linkSharedDataToNeuroTouch(shared_data& sharedData) {
 // haptic loop (NOTE: as the primary haptic device, NeuroTouch governs the start and end of simulation)
 void updateNeuroTouch(void) {
 
-    // initialize frequency counter
+    p_sharedData->threadConfig.apply("neurotouch");
+    diagLog.attachThread();
+
+    long long lastTickStart = 0;  // for measuring loop period [nsec]
+    long long t0, t1, t2, t3, t4;  // timestamps between stages of one tick [nsec]
+    loop_timing& timing = p_sharedData->neurotouchTiming;
+    input_tag input;               // input sample behind this tick's cursor state
+    long long lastInputNs = 0;     // arrival time of the last input sample traced [nsec]
+
+    // initialize frequency counter and timing histograms
     p_sharedData->neurotouchFreqCounter.reset();
+    long long periodNs = (long long)(p_sharedData->m_neurotouchLoopTimer.getPeriodSeconds() * 1.0e9);
+    timing.period.setThreshold(periodNs + periodNs / 2);
+    timing.tick.setThreshold(periodNs);
     
     // start simulation
     p_sharedData->simulationRunning = true;
     while(p_sharedData->simulationRunning) {
         
-        // only update state of device if timer has expired
-		if (p_sharedData->m_neurotouchLoopTimer.timeoutOccurred()) {
-            
-			p_sharedData->m_neurotouchLoopTimer.stop();
-
-			// update cursor and device states
-			updateCursor();
-			p_sharedData->p_NeuroTouch->getPosition(p_sharedData->motorAPos, p_sharedData->motorBPos);
+        // sleep until the next tick is due
+        p_sharedData->m_neurotouchLoopTimer.waitForNextPeriod();
+        t0 = getMonotonicTimeNs();
+        if (lastTickStart != 0) timing.period.record(t0 - lastTickStart);
+        lastTickStart = t0;
+
+        // predict cursor state for this tick (the cursor model updates at its own, slower rate) and update device state
+        predictCursor(t0, p_sharedData->cursorPos, p_sharedData->cursorVel, snapshot.cursorResets, input);
+        t1 = getMonotonicTimeNs();
+        p_sharedData->p_NeuroTouch->getPosition(p_sharedData->motorAPos, p_sharedData->motorBPos);
+        t2 = getMonotonicTimeNs();
         
-			// compute desired end-effector force and command this force to the device
-			computeForce();
-			p_sharedData->p_NeuroTouch->setForce(p_sharedData->eeForceDesX, p_sharedData->eeForceDesY);
+        // compute desired end-effector force and command this force to the device
+        computeForce();
+        t3 = getMonotonicTimeNs();
+        p_sharedData->p_NeuroTouch->setForce(p_sharedData->eeForceDesX, p_sharedData->eeForceDesY);
+        t4 = getMonotonicTimeNs();
         
-			// update frequency counter
-			p_sharedData->neurotouchFreqCounter.signal(1);
-
-			p_sharedData->m_neurotouchLoopTimer.start(true);
-		}
+        // publish a consistent snapshot of this tick for the other threads
+        publishHapticState();
+        
+        // update frequency counter and timing histograms
+        p_sharedData->neurotouchFreqCounter.signal(1);
+        timing.predictCursor.record(t1 - t0);
+        timing.getPosition.record(t2 - t1);
+        timing.computeForce.record(t3 - t2);
+        timing.setForce.record(t4 - t3);
+        timing.tick.record(t4 - t0);
+        
+        // end-to-end latency, from the arrival of the input behind this force to its DAQ write
+        if (input.source != TRACE_NONE && input.timeNs != 0) {
+            input_trace& trace = p_sharedData->inputTrace[input.source];
+            if (input.timeNs != lastInputNs) trace.latency.record(t4 - input.timeNs);
+            trace.age.record(t4 - input.timeNs);
+            lastInputNs = input.timeNs;
+        }
 
     }
 
@@ -79,67 +108,6 @@ void updateNeuroTouch(void) {
     
 }
 
-// update position and velocity of cursor on screen based on designated input
-void updateCursor(void) {
-    
-    // save old cursor state
-    p_sharedData->cursorPosOneAgo = p_sharedData->cursorPos;
-    p_sharedData->cursorVelOneAgo = p_sharedData->cursorVel;
-    
-    if (p_sharedData->input == BCI) {
-        
-        if (p_sharedData->bci == EMOTIV) {
-
-            // query the Emotiv listener
-            p_sharedData->listener.queryEmoState(p_sharedData->cogRight, p_sharedData->cogLeft, p_sharedData->cogNeut);
-            
-            // sum of cognitive powers (right, left, neutral) = "force" on cursor along X
-            double cursorForce = p_sharedData->cogRight - p_sharedData->cogLeft;
-            double cursorAcc = cursorForce / mCursor;
-            
-            // integrate (via Euler) acceleration to get new cursor velocity
-            p_sharedData->cursorVel = p_sharedData->cursorVelOneAgo + cursorAcc * dt;
-        }
-        
-        else if (p_sharedData->bci == GTEC) {
-
-			// update g.MOBIlab+ state map (and simultaneously check for success)
-			if (!readFromGTec(p_sharedData->state, p_sharedData->recStream)) printf("\nUNABLE TO UPDATE STATE FROM BCI2000");
-
-			// query the map for the Y control signal (the one changing in BCI2000 CursorTask), which scales to X cursor velocity
-            p_sharedData->controlSig = p_sharedData->state["Signal(1,0)"];
-            p_sharedData->cursorVel = gTecScalar * p_sharedData->controlSig;
-			printf("\nv = %f\n", p_sharedData->cursorVel);
-        }
-		
-        // integrate (via Euler) velocity to get new cursor position
-        p_sharedData->cursorPos = p_sharedData->cursorPosOneAgo + p_sharedData->cursorVel * dt;
-        
-    } else if (p_sharedData->input == PHANTOM) {
-        
-        // scale PHANTOM state for graphics workspace
-        p_sharedData->cursorVel = phantomScalar * p_sharedData->phantomVel;
-        p_sharedData->cursorPos = phantomScalar * p_sharedData->phantomPos;
-        
-    } else {
-        
-        // autonomous, sinusoidal input (i.e., cursor moves on its own)
-        p_sharedData->cursorPos = A * sin(2.0 * pi * p_sharedData->autoFreq * p_sharedData->time->getCurrentTimeSeconds());
-        p_sharedData->cursorVel = (A * 2.0 * pi * p_sharedData->autoFreq) * cos(2.0 * pi * p_sharedData->autoFreq * p_sharedData->time->getCurrentTimeSeconds());
-    }
-
-	// limit cursor movement if necessary
-	if (p_sharedData->cursorPos > maxPos) {
-		p_sharedData->cursorPos = maxPos;
-		p_sharedData->cursorVel = 0;
-	}
-	if (p_sharedData->cursorPos < -maxPos) {
-		p_sharedData->cursorPos = -maxPos;
-		p_sharedData->cursorVel = 0;
-	}
-	 
-}
-
 // compute desired force at end effector (NOTE: add Y-force when extending task to 2 dimensions) and (if sensing) measure finger force
 void computeForce(void) {
     
@@ -190,6 +158,49 @@ void computeForce(void) {
     
 }
 
+// copy this tick's cursor, motor, and force state into the shared snapshot (never blocks)
+void publishHapticState(void) {
+    
+    snapshot.cursorPos = p_sharedData->cursorPos;
+    snapshot.cursorVel = p_sharedData->cursorVel;
+    snapshot.eeForceDesX = p_sharedData->eeForceDesX;
+    snapshot.eeForceDesY = p_sharedData->eeForceDesY;
+    snapshot.motorAPos = p_sharedData->motorAPos;
+    snapshot.motorBPos = p_sharedData->motorBPos;
+    for (int i=0; i<3; i++) snapshot.force[i] = p_sharedData->force[i];
+    p_sharedData->hapticState.write(snapshot);
+    
+}
+
+// write a summary of the NeuroTouch loop timing (period, per-stage latencies, missed deadlines)
+void printNeuroTouchTiming(FILE* file) {
+    
+    loop_timing& timing = p_sharedData->neurotouchTiming;
+    fprintf(file, "NeuroTouch loop timing (target period %.3f msec, %lu deadlines missed by scheduler)\n",
+            1000.0 * p_sharedData->m_neurotouchLoopTimer.getPeriodSeconds(), p_sharedData->m_neurotouchLoopTimer.getMissedDeadlines());
+    timing.period.print(file, "period");
+    timing.tick.print(file, "tick");
+    timing.predictCursor.print(file, "predictCursor");
+    timing.getPosition.print(file, "getPosition");
+    timing.computeForce.print(file, "computeForce");
+    timing.setForce.print(file, "setForce");
+    
+}
+
+// write a summary of end-to-end latency for each input source used (sample arrival to DAQ write)
+void printInputLatency(FILE* file) {
+    
+    for (int i = 0; i < TRACE_SOURCES; i++) {
+        latency_summary summary;
+        p_sharedData->inputTrace[i].age.getSummary(summary);
+        if (summary.count == 0) continue;
+        fprintf(file, "%s input to DAQ write (latency: first write after each sample; age: every write)\n", traceNames[i]);
+        p_sharedData->inputTrace[i].latency.print(file, "latency");
+        p_sharedData->inputTrace[i].age.print(file, "age");
+    }
+    
+}
+
 // safely close NeuroTouch
 void closeNeuroTouch(void) {
     
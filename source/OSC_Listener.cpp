@@ -4,15 +4,19 @@
 
 using namespace std;
 // Required Library inclusion to work with oscpack library
+#ifdef _WIN32
 #pragma comment(lib, "ws2_32.lib")
 #pragma comment(lib, "winmm.lib")
+#endif
 
 #include <iostream>
 #include <cstring>
 
 #include <cstdio>
 #include <cassert>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <stdio.h>
 #include <queue>
 #include "OscReceivedElements.h"
@@ -20,7 +24,9 @@ using namespace std;
 #include "UdpSocket.h"
 #include "cNeuroTouch.h"
 #include "shared_Data.h"
+#ifdef _WIN32
 #include <conio.h>
+#endif
 
 
 #define MAIN
@@ -29,30 +35,93 @@ using namespace std;
 //Port definition: should be the same port number that Mind Your OSCs is broadcasting on
 #define PORT 7400
 
-// DEBUG FLAG
-//#define DEBUG_PRINTF
+// (debug messages are DIAG_DEBUG; build with DIAG_MIN_LEVEL=DIAG_LEVEL_DEBUG to see them)
 //#define TEST_EPOC_FORCE
 
-// Module Level Defines
-static float CogLeft = 0; // initialize cognitive power left to zero
-static float CogRight = 0; // initialize cognitive power right to zero
-static float CogNeutral = 0; // initialize cognitive power neutral to zero
-static int Rx_FLAG = 0;
-
 cNeuroTouch device;
 
 OSC_Listener::OSC_Listener(void)
 {
+	m_packetTimeNs = 0;
+	memset(&m_latest, 0, sizeof(m_latest)); // cognitive powers start at zero, nothing received
+	memset(&m_recent, 0, sizeof(m_recent));
 
+	RegisterMessageFunction("/COG/LEFT", &OSC_Listener::ProcessCogLeft);
+	RegisterMessageFunction("/COG/RIGHT", &OSC_Listener::ProcessCogRight);
+	RegisterMessageFunction("/COG/NEUTRAL", &OSC_Listener::ProcessCogNeutral);
 }
 
 
 void OSC_Listener::queryEmoState(float& Cog_Right, float& Cog_Left, float& Cog_Neutral){
-	Cog_Right = CogRight;
-	Cog_Left  = CogLeft;
-	Cog_Neutral = CogNeutral;
+	long long arrival;
+	queryEmoState(Cog_Right, Cog_Left, Cog_Neutral, arrival);
+}
 
+// same, plus when the packet they came from arrived (getMonotonicTimeNs; 0 if none yet) for end-to-end latency
+void OSC_Listener::queryEmoState(float& Cog_Right, float& Cog_Left, float& Cog_Neutral, long long& Arrival_Ns){
+	emo_state state;
+	m_state.read(state);
+	Cog_Right = state.cogRight;
+	Cog_Left  = state.cogLeft;
+	Cog_Neutral = state.cogNeutral;
+	Arrival_Ns = state.timeNs;
+}
+
+// latest state as one consistent copy (false if nothing has been received yet)
+bool OSC_Listener::getEmoState(emo_state& State) const
+{
+	m_state.read(State);
+	return State.sequence > 0;
+}
+
+// recent states, oldest first (gaps or repeats in their sequence numbers are missed or duplicated updates)
+void OSC_Listener::getEmoHistory(emo_history& History) const
+{
+	m_history.read(History);
+}
+
+// states per second over the history window (0 until two have arrived)
+double OSC_Listener::getUpdateRate(void) const
+{
+	emo_history history;
+	m_history.read(history);
+	if (history.count < 2) return 0.0;
+	const emo_state& first = history.states[0];
+	const emo_state& last = history.states[history.count - 1];
+	if (last.timeNs <= first.timeNs) return 0.0;
+	return (double)(last.sequence - first.sequence) * 1.0e9 / (double)(last.timeNs - first.timeNs);
+}
+
+// reads of the latest state that overlapped an update and were retried
+unsigned long long OSC_Listener::getTornReads(void) const
+{
+	return m_state.getRetryCount() + m_history.getRetryCount();
+}
+
+// publish a new state as a whole: numbered, stamped with its packet's arrival, and added to the history
+void OSC_Listener::publishEmoState(float Cog_Right, float Cog_Left, float Cog_Neutral)
+{
+	m_latest.cogRight = Cog_Right;
+	m_latest.cogLeft = Cog_Left;
+	m_latest.cogNeutral = Cog_Neutral;
+	m_latest.sequence++;
+	m_latest.timeNs = m_packetTimeNs;
+	m_state.write(m_latest);
+
+	if (m_recent.count == EMO_HISTORY) {
+		memmove(&m_recent.states[0], &m_recent.states[1], (EMO_HISTORY - 1) * sizeof(emo_state));
+		m_recent.count--;
+	}
+	m_recent.states[m_recent.count++] = m_latest;
+	m_history.write(m_recent);
+}
 
+// stamp each packet as it arrives, before any of its messages are processed
+void OSC_Listener::ProcessPacket( const char *data, int size, 
+				const IpEndpointName& remoteEndpoint )
+{
+	m_packetTimeNs = getMonotonicTimeNs();
+	osc::OscPacketListener::ProcessPacket(data, size, remoteEndpoint);
 }
 
 
@@ -68,65 +137,17 @@ OSC_Listener::~OSC_Listener(void)
 				const IpEndpointName& remoteEndpoint )
     {
 		//printf("PROCESS\n\n");
-        (void) remoteEndpoint; // suppress unused parameter warning
 
         try{
             
-            // If a message is recieved, decode it
-            if( std::strcmp( m.AddressPattern(), "/COG/LEFT" ) == 0 ){ // if the adress matches COG LEFT
-                
-				// Recieve the argument of the stream and store it into args
-                osc::ReceivedMessageArgumentStream args = m.ArgumentStream(); 
-            
-				// store the recieved message (cognitive magnitude) into a variable
-                args >> CogLeft >>  osc::EndMessage;
-				CogRight = 0;
-				CogNeutral = 0;
-                
-				#ifdef DEBUG_PRINTF
-                std::cout << "Recieved /COG/LEFT pattern with contents:     "
-                    << CogLeft <<"\n\n";
-				#endif
-            
-			}else if( std::strcmp( m.AddressPattern(), "/COG/RIGHT" ) == 0 ){ // else if the address matches COG RIGHT
-				
-				// Recieve the argument of the stream and store it into args
-                osc::ReceivedMessageArgumentStream args = m.ArgumentStream(); 
-            
-				// store the recieved message (cognitive magnitude) into a variable
-                args >> CogRight >>  osc::EndMessage;
-				CogLeft = 0;
-				CogNeutral = 0;
-                
-				#ifdef DEBUG_PRINTF
-                std::cout << "Recieved /COG/RIGHT pattern with contents:     "
-                    << CogRight <<"\n\n";
-				#endif
-
-			}else if( std::strcmp( m.AddressPattern(), "/COG/NEUTRAL" ) == 0 ){ // else if the address matches COG Neutral
-				
-				// Recieve the argument of the stream and store it into args
-                osc::ReceivedMessageArgumentStream args = m.ArgumentStream(); 
-            
-				// store the recieved message (cognitive magnitude) into a variable
-                args >> CogNeutral >>  osc::EndMessage;
-				CogRight = 0;
-				CogLeft = 0;
-                
-				#ifdef DEBUG_PRINTF
-                std::cout << "Recieved /COG/NEUTRAL pattern with contents:     "
-                    << CogNeutral <<"\n\n";
-				#endif
-            
-            }
-
-
+            // If a message is recieved, decode it with the handler registered for its address (if any)
+            osc::MessageMappingOscPacketListener<OSC_Listener>::ProcessMessage(m, remoteEndpoint);
 
         }catch( osc::Exception& e ){ // catch any errors
             // any parsing errors such as unexpected argument types, or 
             // missing arguments get thrown as exceptions.
-            std::cout << "error while parsing message: "
-                << m.AddressPattern() << ": " << e.what() << "\n";
+            // (NOTE: oscpack's exception texts are string literals, so they can be logged by pointer; the address pattern lives in the packet buffer, so it cannot)
+            DIAG_WARN("error while parsing OSC message: %s", e.what());
         }
 
 
@@ -136,12 +157,48 @@ OSC_Listener::~OSC_Listener(void)
 		// Set forces to the NeutoTouch, make instance of neurotouch
 		
 		static float Force_desired = 0;
-		if( abs(CogRight) > abs(CogLeft)) Force_desired = CogRight;
-		else Force_desired = -1*CogLeft;
+		if( abs(m_latest.cogRight) > abs(m_latest.cogLeft)) Force_desired = m_latest.cogRight;
+		else Force_desired = -1*m_latest.cogLeft;
 		device.setForce(-1*Force_desired,0);
 		printf("Force Desired: %f\n\n", Force_desired);
 
 #endif
 
 
-    }
\ No newline at end of file
+    }
+
+// the cognitive magnitude a /COG message carries (throws, like the argument stream did, unless it is exactly one float)
+static float cogPower(const osc::ReceivedMessage& m)
+{
+	if (m.ArgumentCount() > 1) throw osc::ExcessArgumentException();
+	return m.Float(0);
+}
+
+// Handlers for each cognitive power: store the recieved message (cognitive magnitude) into a variable
+// (the other two powers are zeroed; all three are published together, once the whole message has parsed)
+    void OSC_Listener::ProcessCogLeft( const osc::ReceivedMessage& m, 
+				const IpEndpointName& remoteEndpoint )
+    {
+        (void) remoteEndpoint;
+        float value = cogPower(m);
+		publishEmoState(0, value, 0);
+        DIAG_DEBUG("Recieved /COG/LEFT pattern with contents: %f", value);
+    }
+
+    void OSC_Listener::ProcessCogRight( const osc::ReceivedMessage& m, 
+				const IpEndpointName& remoteEndpoint )
+    {
+        (void) remoteEndpoint;
+        float value = cogPower(m);
+		publishEmoState(value, 0, 0);
+        DIAG_DEBUG("Recieved /COG/RIGHT pattern with contents: %f", value);
+    }
+
+    void OSC_Listener::ProcessCogNeutral( const osc::ReceivedMessage& m, 
+				const IpEndpointName& remoteEndpoint )
+    {
+        (void) remoteEndpoint;
+        float value = cogPower(m);
+		publishEmoState(0, 0, value);
+        DIAG_DEBUG("Recieved /COG/NEUTRAL pattern with contents: %f", value);
+    }
@@ -0,0 +1,254 @@
+#include "OscAddressPattern.h"
+
+#include <string.h>
+
+
+namespace osc{
+
+static void SetBit( unsigned char *set, unsigned char c )
+{
+    set[c >> 3] |= (unsigned char)(1 << (c & 7));
+}
+
+
+AddressPattern::AddressPattern( const char *pattern )
+    : source_( pattern )
+{
+    const char *p = pattern;
+    while( *p != '\0' ){
+        Token token;
+        token.start = 0;
+        token.length = 0;
+
+        switch( *p ){
+        case '?':
+            token.type = ANY_CHAR;
+            ++p;
+            break;
+
+        case '*':
+            token.type = ANY_RUN;
+            while( *p == '*' )  // (a run of stars matches the same as one)
+                ++p;
+            break;
+
+        case '[':{
+            token.type = CHAR_CLASS;
+            memset( token.set, 0, sizeof(token.set) );
+            ++p;
+            bool negate = (*p == '!');
+            if( negate )
+                ++p;
+            while( *p != ']' ){
+                if( *p == '\0' )
+                    throw MalformedAddressPatternException( "unterminated [ in address pattern" );
+                unsigned char first = (unsigned char)*p;
+                if( p[1] == '-' && p[2] != ']' && p[2] != '\0' ){
+                    unsigned char last = (unsigned char)p[2];
+                    for( int c = first; c <= last; ++c )
+                        SetBit( token.set, (unsigned char)c );
+                    p += 3;
+                }else{
+                    SetBit( token.set, first );
+                    ++p;
+                }
+            }
+            ++p;
+            if( negate ){
+                for( int i = 0; i < 32; ++i )
+                    token.set[i] = (unsigned char)~token.set[i];
+                token.set[0] &= (unsigned char)~1;  // (never the terminator)
+            }
+            token.set['/' >> 3] &= (unsigned char)~(1 << ('/' & 7));
+            break;
+        }
+
+        case '{':{
+            token.type = ALTERNATIVES;
+            token.start = (int)alternatives_.size();
+            ++p;
+            for( ;; ){
+                Alternative alternative;
+                alternative.start = (int)text_.size();
+                while( *p != ',' && *p != '}' ){
+                    if( *p == '\0' )
+                        throw MalformedAddressPatternException( "unterminated { in address pattern" );
+                    text_ += *p++;
+                }
+                alternative.length = (int)text_.size() - alternative.start;
+                alternatives_.push_back( alternative );
+                if( *p++ == '}' )
+                    break;
+            }
+            token.length = (int)alternatives_.size() - token.start;
+            break;
+        }
+
+        default:
+            // a run of ordinary characters
+            token.type = LITERAL;
+            token.start = (int)text_.size();
+            while( *p != '\0' && strchr( "?*[{", *p ) == 0 )
+                text_ += *p++;
+            token.length = (int)text_.size() - token.start;
+            break;
+        }
+
+        tokens_.push_back( token );
+    }
+}
+
+
+bool AddressPattern::IsPattern( const char *address )
+{
+    return strpbrk( address, "?*[{" ) != 0;
+}
+
+
+bool AddressPattern::Match( const char *address ) const
+{
+    return MatchFrom( 0, address );
+}
+
+
+// whether address starts with text_[start, start + length)
+bool AddressPattern::MatchText( int start, int length, const char *address ) const
+{
+    const char *text = text_.data() + start;
+    for( int i = 0; i < length; ++i ){
+        if( address[i] != text[i] )  // (stops at the terminator, which text never contains)
+            return false;
+    }
+    return true;
+}
+
+
+bool AddressPattern::MatchFrom( int token, const char *address ) const
+{
+    const char *p = address;
+    for( int t = token; t < (int)tokens_.size(); ++t ){
+        const Token& k = tokens_[t];
+        switch( k.type ){
+        case LITERAL:
+            if( !MatchText( k.start, k.length, p ) )
+                return false;
+            p += k.length;
+            break;
+
+        case ANY_CHAR:
+            if( *p == '\0' || *p == '/' )
+                return false;
+            ++p;
+            break;
+
+        case CHAR_CLASS:{
+            unsigned char c = (unsigned char)*p;
+            if( (k.set[c >> 3] & (1 << (c & 7))) == 0 )
+                return false;
+            ++p;
+            break;
+        }
+
+        case ALTERNATIVES:
+            for( int i = k.start; i < k.start + k.length; ++i ){
+                const Alternative& a = alternatives_[i];
+                if( MatchText( a.start, a.length, p ) && MatchFrom( t + 1, p + a.length ) )
+                    return true;
+            }
+            return false;
+
+        case ANY_RUN:
+            // shortest run first, up to the end of this part of the address
+            for( ;; ){
+                if( MatchFrom( t + 1, p ) )
+                    return true;
+                if( *p == '\0' || *p == '/' )
+                    return false;
+                ++p;
+            }
+        }
+    }
+    return *p == '\0';
+}
+
+
+AddressMatchCache::AddressMatchCache()
+    : size_( 0 )
+{
+    Clear();
+}
+
+
+// FNV-1a, measuring the address on the way
+unsigned int AddressMatchCache::Hash( const char *address, int& length )
+{
+    unsigned int hash = 2166136261u;
+    const char *p = address;
+    for( ; *p != '\0'; ++p ){
+        hash ^= (unsigned char)*p;
+        hash *= 16777619u;
+    }
+    length = (int)(p - address);
+    return hash;
+}
+
+
+bool AddressMatchCache::Find( const char *address, const int *&ids, int& count ) const
+{
+    int length;
+    unsigned int hash = Hash( address, length );
+    unsigned int mask = OSC_MATCH_CACHE_SIZE - 1;
+    for( unsigned int slot = hash & mask; entries_[slot].keyStart != -1; slot = (slot + 1) & mask ){
+        const Entry& e = entries_[slot];
+        if( e.hash == hash && e.keyLength == length
+                && memcmp( keys_.data() + e.keyStart, address, length ) == 0 ){
+            ids = (e.idsCount > 0) ? &ids_[e.idsStart] : 0;
+            count = e.idsCount;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+const int *AddressMatchCache::Insert( const char *address, const int *ids, int count )
+{
+    if( size_ >= OSC_MATCH_CACHE_SIZE / 2 )
+        Clear();
+
+    int length;
+    unsigned int hash = Hash( address, length );
+    unsigned int mask = OSC_MATCH_CACHE_SIZE - 1;
+    unsigned int slot = hash & mask;
+    while( entries_[slot].keyStart != -1 )
+        slot = (slot + 1) & mask;
+
+    Entry& e = entries_[slot];
+    e.hash = hash;
+    e.keyStart = (int)keys_.size();
+    e.keyLength = length;
+    e.idsStart = (int)ids_.size();
+    e.idsCount = count;
+    keys_.append( address, length );
+    ids_.insert( ids_.end(), ids, ids + count );
+    ++size_;
+
+    return (count > 0) ? &ids_[e.idsStart] : 0;
+}
+
+
+void AddressMatchCache::Clear()
+{
+    Entry empty;
+    empty.hash = 0;
+    empty.keyStart = -1;
+    empty.keyLength = 0;
+    empty.idsStart = 0;
+    empty.idsCount = 0;
+    entries_.assign( OSC_MATCH_CACHE_SIZE, empty );
+    keys_.clear();
+    ids_.clear();
+    size_ = 0;
+}
+
+} // namespace osc
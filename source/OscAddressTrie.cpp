@@ -0,0 +1,103 @@
+#include "OscAddressTrie.h"
+
+#include <string.h>
+
+
+namespace osc{
+
+AddressTrie::AddressTrie()
+    : size_( 0 )
+{
+    AddNode( 0, 0, -1, -1, -1 );
+}
+
+
+int AddressTrie::AddNode( int labelStart, int labelLength, int id, int firstChild, int nextSibling )
+{
+    Node n;
+    n.first = (labelLength > 0) ? labels_[labelStart] : '\0';
+    n.labelStart = labelStart;
+    n.labelLength = labelLength;
+    n.id = id;
+    n.firstChild = firstChild;
+    n.nextSibling = nextSibling;
+    nodes_.push_back( n );
+    return (int)nodes_.size() - 1;
+}
+
+
+void AddressTrie::Add( const char *address, int id )
+{
+    int node = 0;
+    const char *p = address;
+    while( *p != '\0' ){
+        int child = nodes_[node].firstChild;
+        while( child != -1 && nodes_[child].first != *p )
+            child = nodes_[child].nextSibling;
+
+        if( child == -1 ){
+            // the rest of the address becomes a new leaf
+            int length = (int)strlen( p );
+            int start = (int)labels_.size();
+            labels_.append( p, length );
+            int leaf = AddNode( start, length, id, -1, nodes_[node].firstChild );
+            nodes_[node].firstChild = leaf;
+            ++size_;
+            return;
+        }
+
+        // length of the run the address shares with the child's label
+        int shared = 1;
+        while( shared < nodes_[child].labelLength
+                && labels_[nodes_[child].labelStart + shared] == p[shared] )
+            ++shared;
+
+        if( shared < nodes_[child].labelLength ){
+            // split the edge: the child keeps the shared run, and a new node takes over
+            // the rest of its label along with its id and children
+            Node old = nodes_[child];
+            int tail = AddNode( old.labelStart + shared, old.labelLength - shared,
+                    old.id, old.firstChild, -1 );
+            nodes_[child].labelLength = shared;
+            nodes_[child].id = -1;
+            nodes_[child].firstChild = tail;
+        }
+
+        node = child;
+        p += shared;
+    }
+
+    if( nodes_[node].id == -1 )
+        ++size_;
+    nodes_[node].id = id;
+}
+
+
+int AddressTrie::Find( const char *address ) const
+{
+    const Node *nodes = &nodes_[0];
+    const char *labels = labels_.data();
+    int node = 0;
+    const char *p = address;
+    while( *p != '\0' ){
+        int child = nodes[node].firstChild;
+        while( child != -1 && nodes[child].first != *p )
+            child = nodes[child].nextSibling;
+        if( child == -1 )
+            return -1;
+
+        // (stops at the address's terminator, since labels never contain one)
+        const char *label = labels + nodes[child].labelStart;
+        int length = nodes[child].labelLength;
+        for( int i = 1; i < length; ++i ){
+            if( p[i] != label[i] )
+                return -1;
+        }
+
+        node = child;
+        p += length;
+    }
+    return nodes[node].id;
+}
+
+} // namespace osc
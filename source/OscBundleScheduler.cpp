@@ -0,0 +1,190 @@
+#include "OscBundleScheduler.h"
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "UdpSocket.h"
+
+
+namespace osc{
+
+static const uint64 immediateTimeTag = 1;                  // OSC's "now"
+static const long long ntpToUnixSeconds = 2208988800LL;   // 1900 to 1970
+static const long long releaseSlackNs = 1000000;           // a timer releases whatever is due within this much of it (timers are whole msec)
+static const int bundleHeaderSize = 16;                    // "#bundle\0" and the time tag
+
+static long long MonotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static long long WallNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch() ).count();
+}
+
+
+BundleScheduler::BundleScheduler( PacketListener *listener, SocketReceiveMultiplexer *multiplexer )
+    : listener_( listener )
+    , multiplexer_( multiplexer )
+    , playoutDelayNs_( 0 )
+    , clockOffsetNs_( 0 )
+    , latePolicy_( DELIVER_LATE )
+    , wallMinusMonotonicNs_( 0 )
+    , sequence_( 0 )
+    , armedNs_( 0 )
+    , passed_( 0 ), held_( 0 ), released_( 0 ), late_( 0 ), dropped_( 0 ), overflowed_( 0 ), discarded_( 0 )
+    , maxLeadNs_( 0 ), maxLatenessNs_( 0 )
+{
+    queue_.reserve( OSC_MAX_HELD_BUNDLES );
+    Synchronize();
+}
+
+
+BundleScheduler::~BundleScheduler()
+{
+    if( armedNs_ != 0 )
+        multiplexer_->CancelTimerListener( this );
+}
+
+
+void BundleScheduler::Synchronize()
+{
+    // (the wall clock sampled between two monotonic readings, against their midpoint)
+    long long before = MonotonicNs();
+    long long wall = WallNs();
+    long long after = MonotonicNs();
+    wallMinusMonotonicNs_ = wall - (before + (after - before) / 2);
+}
+
+
+// release time of a bundle with this tag, on the monotonic clock
+long long BundleScheduler::DueNs( uint64 timeTag ) const
+{
+    long long seconds = (long long)(timeTag >> 32) - ntpToUnixSeconds;
+    long long fraction = (long long)(((timeTag & 0xFFFFFFFFULL) * 1000000000ULL) >> 32);
+    long long senderNs = seconds * 1000000000LL + fraction;
+    return senderNs - clockOffsetNs_ - wallMinusMonotonicNs_ + playoutDelayNs_;
+}
+
+
+void BundleScheduler::ProcessPacket( const char *data, int size, 
+        const IpEndpointName& remoteEndpoint )
+{
+    // messages, and anything too short to be a bundle, go straight through
+    // (malformed bundles too: the listener reports those as it always has)
+    if( size < bundleHeaderSize || memcmp( data, "#bundle", 8 ) != 0 ){
+        ++passed_;
+        listener_->ProcessPacket( data, size, remoteEndpoint );
+        return;
+    }
+
+    uint64 timeTag = 0;
+    for( int i = 8; i < bundleHeaderSize; ++i )
+        timeTag = (timeTag << 8) | (unsigned char)data[i];
+    if( timeTag == immediateTimeTag ){
+        ++passed_;
+        listener_->ProcessPacket( data, size, remoteEndpoint );
+        return;
+    }
+
+    long long nowNs = MonotonicNs();
+    long long dueNs = DueNs( timeTag );
+    if( dueNs <= nowNs ){
+        ++late_;
+        maxLatenessNs_ = std::max( maxLatenessNs_, nowNs - dueNs );
+        if( latePolicy_ == DROP_LATE ){
+            ++dropped_;
+        }else{
+            listener_->ProcessPacket( data, size, remoteEndpoint );
+        }
+        return;
+    }
+
+    maxLeadNs_ = std::max( maxLeadNs_, dueNs - nowNs );
+    Hold( data, size, remoteEndpoint, dueNs );
+    Arm( nowNs );
+}
+
+
+void BundleScheduler::Hold( const char *data, int size, const IpEndpointName& from, long long dueNs )
+{
+    if( (int)queue_.size() >= OSC_MAX_HELD_BUNDLES ){
+        ++overflowed_;
+        ReleaseFirst();
+    }
+
+    HeldBundle h;
+    h.dueNs = dueNs;
+    h.sequence = sequence_++;
+    if( freeBuffers_.empty() ){
+        h.buffer = (int)buffers_.size();
+        buffers_.push_back( std::vector<char>() );
+    }else{
+        h.buffer = freeBuffers_.back();
+        freeBuffers_.pop_back();
+    }
+    buffers_[h.buffer].assign( data, data + size );
+    h.size = size;
+    h.from = from;
+
+    queue_.push_back( h );
+    std::push_heap( queue_.begin(), queue_.end(), Later() );
+    ++held_;
+}
+
+
+// hand the earliest bundle to the listener (its buffer is only reused once the listener has returned)
+void BundleScheduler::ReleaseFirst()
+{
+    std::pop_heap( queue_.begin(), queue_.end(), Later() );
+    HeldBundle h = queue_.back();
+    queue_.pop_back();
+
+    ++released_;
+    listener_->ProcessPacket( &buffers_[h.buffer][0], h.size, h.from );
+    freeBuffers_.push_back( h.buffer );
+}
+
+
+// set the timer for the earliest bundle held, unless it is already set for that
+void BundleScheduler::Arm( long long nowNs )
+{
+    if( queue_.empty() || queue_.front().dueNs == armedNs_ )
+        return;
+
+    if( armedNs_ != 0 )
+        multiplexer_->CancelTimerListener( this );
+    armedNs_ = queue_.front().dueNs;
+    long long delayNs = armedNs_ - nowNs;
+    int delayMs = (delayNs > 0) ? (int)((delayNs + 999999) / 1000000) : 0;
+    multiplexer_->AttachOneShotTimerListener( delayMs, this );
+}
+
+
+void BundleScheduler::TimerExpired()
+{
+    armedNs_ = 0;
+    long long nowNs = MonotonicNs();
+    while( !queue_.empty() && queue_.front().dueNs <= nowNs + releaseSlackNs )
+        ReleaseFirst();
+    Arm( nowNs );
+}
+
+
+void BundleScheduler::Clear()
+{
+    if( armedNs_ != 0 )
+        multiplexer_->CancelTimerListener( this );
+    armedNs_ = 0;
+
+    discarded_ += (unsigned long)queue_.size();
+    for( size_t i = 0; i < queue_.size(); ++i )
+        freeBuffers_.push_back( queue_[i].buffer );
+    queue_.clear();
+}
+
+} // namespace osc
@@ -557,6 +557,7 @@ void ReceivedMessage::Init( const char *message, unsigned long size )
         typeTagsBegin_ = 0;
         typeTagsEnd_ = 0;
         arguments_ = 0;
+        indexedCount_ = 0;
             
     }else{
         if( *typeTagsBegin_ != ',' )
@@ -567,6 +568,7 @@ void ReceivedMessage::Init( const char *message, unsigned long size )
             typeTagsBegin_ = 0;
             typeTagsEnd_ = 0;
             arguments_ = 0;
+            indexedCount_ = 0;
 
         }else{
             // check that all arguments are present and well formed
@@ -580,8 +582,15 @@ void ReceivedMessage::Init( const char *message, unsigned long size )
             
             const char *typeTag = typeTagsBegin_;
             const char *argument = arguments_;
+            unsigned long index = 0;
+            unsigned long indexed = 0;
                         
             do{
+                // index the argument's position on the way
+                if( indexed == index && index < OSC_INDEXED_ARGUMENTS && argument - arguments_ <= 0xFFFF )
+                    argumentOffsets_[indexed++] = static_cast<unsigned short>(argument - arguments_);
+                ++index;
+
                 switch( *typeTag ){
                     case TRUE_TYPE_TAG:
                     case FALSE_TYPE_TAG:
@@ -628,12 +637,12 @@ void ReceivedMessage::Init( const char *message, unsigned long size )
                     case BLOB_TYPE_TAG:
                         {
                             if( argument + 4 > end )
-                                MalformedMessageException( "arguments exceed message size" );
+                                throw MalformedMessageException( "arguments exceed message size" );
                                 
                             uint32 blobSize = ToUInt32( argument );
                             argument = argument + 4 + RoundUp4( blobSize );
                             if( argument > end )
-                                MalformedMessageException( "arguments exceed message size" );
+                                throw MalformedMessageException( "arguments exceed message size" );
                         }
                         break;
                         
@@ -648,10 +657,25 @@ void ReceivedMessage::Init( const char *message, unsigned long size )
 
             }while( *++typeTag != '\0' );
             typeTagsEnd_ = typeTag;
+            indexedCount_ = indexed;
         }
     }
 }
 
+
+// an argument past the indexed ones, found by stepping on from the last of those
+ReceivedMessageArgument ReceivedMessage::UnindexedArgument( unsigned long index ) const
+{
+    if( index >= ArgumentCount() )
+        throw MissingArgumentException();
+
+    unsigned long last = indexedCount_ - 1;
+    ReceivedMessageArgumentIterator i( typeTagsBegin_ + last, arguments_ + argumentOffsets_[last] );
+    for( unsigned long n = last; n < index; ++n )
+        ++i;
+    return *i;
+}
+
 //------------------------------------------------------------------------------
 
 ReceivedBundle::ReceivedBundle( const ReceivedPacket& packet )
@@ -10,7 +10,57 @@ cVector3d vel;  // temporary variable for PHANTOM velocity (only need X)
 static shared_data* p_sharedData;  // structure for sharing data between threads
 
 
-// initialize the PHANTOM device
+// the PHANTOM, polled at PHANTOM_LOOP_TIME until switched off
+class cPhantomInput : public cInputSource
+{
+  public:
+    cPhantomInput(void) : m_stop(false) {}
+
+    bool open(void) {
+        m_stop = false;
+        initPhantom();
+        return true;
+    }
+
+    // get PHANTOM state and update shared data
+    void run(void) {
+
+        // initialize frequency counter
+        p_sharedData->phantomFreqCounter.reset();
+        phantom_sample sample;
+
+        while (!m_stop) {
+
+            // sleep until the next update is due
+            p_sharedData->m_phantomLoopTimer.waitForNextPeriod();
+
+            // get PHANTOM position and velocity vectors
+            p_sharedData->p_Phantom->getPosition(pos);
+            p_sharedData->p_Phantom->getLinearVelocity(vel);
+
+            // publish X elements from vectors, with when they were read
+            sample.pos = pos.y();
+            sample.vel = vel.y();
+            sample.timeNs = getMonotonicTimeNs();
+            p_sharedData->phantomSample.write(sample);
+
+            // update frequency counter
+            p_sharedData->phantomFreqCounter.signal(1);
+        }
+
+    }
+
+    void interrupt(void) { m_stop = true; }
+    void close(void) { closePhantom(); }
+
+  private:
+    std::atomic<bool> m_stop;
+};
+
+static cPhantomInput phantomInput;
+
+
+// initialize the PHANTOM device (NOTE: called by the PHANTOM thread when the input switch selects PHANTOM)
 void initPhantom(void) {
     
     // open and calibrate the PHANTOM
@@ -18,52 +68,28 @@ void initPhantom(void) {
     p_sharedData->p_Phantom->calibrate();
     
     // initialize device loop timer
-	p_sharedData->m_phantomLoopTimer.setTimeoutPeriodSeconds(LOOP_TIME);
+	p_sharedData->m_phantomLoopTimer.setPeriodSeconds(PHANTOM_LOOP_TIME / p_sharedData->speedup);
 	p_sharedData->m_phantomLoopTimer.start();
     
 }
 
-// point p_sharedData to sharedData, which is the data shared between all threads
+// point p_sharedData to sharedData, which is the data shared between all threads, and register the PHANTOM as an input source
 void linkSharedDataToPhantom(shared_data& sharedData) {
     
     p_sharedData = &sharedData;
+    sharedData.inputSwitch.setSource(PHANTOM, &phantomInput);
     
 }
 
-// get PHANTOM state and update shared data
+// host the PHANTOM input source, running it whenever the input switch selects PHANTOM
 void updatePhantom(void) {
 
-    // initialize frequency counter
-    p_sharedData->phantomFreqCounter.reset();
-
-    while(p_sharedData->simulationRunning) {
-
-        if (p_sharedData->m_phantomLoopTimer.timeoutOccurred()) {
-            
-            p_sharedData->m_phantomLoopTimer.stop();
-
-            if (p_sharedData->input == PHANTOM) {
-    
-                // get PHANTOM position and velocity vectors
-                p_sharedData->p_Phantom->getPosition(pos);
-                p_sharedData->p_Phantom->getLinearVelocity(vel);
-    
-                // extract X elements from vectors
-                p_sharedData->phantomPos = pos.y();
-                p_sharedData->phantomVel = vel.y();
-                
-                // update frequency counter
-                p_sharedData->phantomFreqCounter.signal(1);
-            }
-            
-            p_sharedData->m_phantomLoopTimer.start(true);
-            Sleep(1);
-        }
-    }
+    p_sharedData->threadConfig.apply("phantom");
+    p_sharedData->inputSwitch.host(PHANTOM);
 
 }
 
-// safely close the PHANTOM device
+// safely close the PHANTOM device (NOTE: called by the PHANTOM thread when the input switch deselects PHANTOM)
 void closePhantom(void) {
     
     p_sharedData->p_Phantom->close();
@@ -0,0 +1,109 @@
+#include "TimerQueue.h"
+
+#include <algorithm>
+
+#include "TimerListener.h"
+
+
+TimerQueue::TimerQueue()
+    : firingListener_( 0 )
+    , firingPeriodic_( false )
+    , firingCancelled_( false )
+{
+}
+
+
+void TimerQueue::Schedule( double expiryMs, int periodMs, TimerListener *listener )
+{
+    ScheduledTimerCall call;
+    call.expiryMs = expiryMs;
+    call.periodMs = (periodMs > 0) ? periodMs : 0;
+    call.listener = listener;
+
+    // (a timer scheduled from a callback waits for the next pass, so a callback rescheduling itself cannot loop)
+    if( firingListener_ != 0 ){
+        rescheduled_.push_back( call );
+    }else{
+        heap_.push_back( call );
+        std::push_heap( heap_.begin(), heap_.end(), Later );
+    }
+}
+
+
+int TimerQueue::Cancel( TimerListener *listener, bool periodicOnly )
+{
+    int removed = 0;
+
+    // the timer being fired has already left the heap: make sure it is not rescheduled
+    if( firingListener_ == listener && (firingPeriodic_ || !periodicOnly) && !firingCancelled_ ){
+        firingCancelled_ = true;
+        ++removed;
+    }
+
+    for( std::vector< ScheduledTimerCall >::iterator i = rescheduled_.begin(); i != rescheduled_.end(); ){
+        if( i->listener == listener ){
+            i = rescheduled_.erase( i );
+            ++removed;
+        }else{
+            ++i;
+        }
+    }
+
+    size_t before = heap_.size();
+    for( size_t i = 0; i < heap_.size(); ){
+        if( heap_[i].listener == listener && (heap_[i].periodMs > 0 || !periodicOnly) ){
+            heap_[i] = heap_.back();
+            heap_.pop_back();
+        }else{
+            ++i;
+        }
+    }
+    if( heap_.size() != before ){
+        std::make_heap( heap_.begin(), heap_.end(), Later );
+        removed += (int)(before - heap_.size());
+    }
+
+    return removed;
+}
+
+
+void TimerQueue::CancelAllPeriodic()
+{
+    for( size_t i = 0; i < heap_.size(); ){
+        if( heap_[i].periodMs > 0 ){
+            heap_[i] = heap_.back();
+            heap_.pop_back();
+        }else{
+            ++i;
+        }
+    }
+    std::make_heap( heap_.begin(), heap_.end(), Later );
+    rescheduled_.clear();
+}
+
+
+void TimerQueue::Expire( double nowMs, volatile bool& breakFlag )
+{
+    while( !heap_.empty() && heap_.front().expiryMs <= nowMs && !breakFlag ){
+        std::pop_heap( heap_.begin(), heap_.end(), Later );
+        ScheduledTimerCall call = heap_.back();
+        heap_.pop_back();
+
+        firingListener_ = call.listener;
+        firingPeriodic_ = (call.periodMs > 0);
+        firingCancelled_ = false;
+        call.listener->TimerExpired();
+        firingListener_ = 0;
+
+        if( call.periodMs > 0 && !firingCancelled_ ){
+            call.expiryMs += call.periodMs;
+            rescheduled_.push_back( call );
+        }
+    }
+
+    for( std::vector< ScheduledTimerCall >::iterator i = rescheduled_.begin(); i != rescheduled_.end(); ++i ){
+        heap_.push_back( *i );
+        std::push_heap( heap_.begin(), heap_.end(), Later );
+    }
+    rescheduled_.clear();
+}
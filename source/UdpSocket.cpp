@@ -27,6 +27,9 @@
 	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
+// Win32 implementation (see UdpSocketLinux.cpp for Linux)
+#ifdef _WIN32
+
 #include "UdpSocket.h"
 
 #include <winsock2.h>   // this must come first to prevent errors with MSVC7
@@ -42,6 +45,7 @@
 #include "NetworkingUtils.h"
 #include "PacketListener.h"
 #include "TimerListener.h"
+#include "TimerQueue.h"
 
 
 typedef int socklen_t;
@@ -269,13 +273,6 @@ struct AttachedTimerListener{
 };
 
 
-static bool CompareScheduledTimerCalls( 
-		const std::pair< double, AttachedTimerListener > & lhs, const std::pair< double, AttachedTimerListener > & rhs )
-{
-	return lhs.first < rhs.first;
-}
-
-
 SocketReceiveMultiplexer *multiplexerInstanceToAbortWithSigInt_ = 0;
 
 extern "C" /*static*/ void InterruptSignalHandler( int );
@@ -290,10 +287,13 @@ class SocketReceiveMultiplexer::Implementation{
     NetworkInitializer networkInitializer_;
 
 	std::vector< std::pair< PacketListener*, UdpSocket* > > socketListeners_;
-	std::vector< AttachedTimerListener > timerListeners_;
+	std::vector< AttachedTimerListener > timerListeners_; // periodic timers, scheduled afresh by each Run()
+	TimerQueue timerQueue_;
+	bool running_;
 
 	volatile bool break_;
 	HANDLE breakEvent_;
+	int receiveBatch_;
 
 	double GetCurrentTimeMs() const
 	{
@@ -302,6 +302,8 @@ class SocketReceiveMultiplexer::Implementation{
 
 public:
     Implementation()
+		: running_( false )
+		, receiveBatch_( OSC_RECEIVE_BATCH )
 	{
 		breakEvent_ = CreateEvent( NULL, FALSE, FALSE, NULL );
 	}
@@ -329,12 +331,19 @@ public:
 
     void AttachPeriodicTimerListener( int periodMilliseconds, TimerListener *listener )
 	{
-		timerListeners_.push_back( AttachedTimerListener( periodMilliseconds, periodMilliseconds, listener ) );
+		AttachPeriodicTimerListener( periodMilliseconds, periodMilliseconds, listener );
 	}
 
 	void AttachPeriodicTimerListener( int initialDelayMilliseconds, int periodMilliseconds, TimerListener *listener )
 	{
 		timerListeners_.push_back( AttachedTimerListener( initialDelayMilliseconds, periodMilliseconds, listener ) );
+		if( running_ )
+			timerQueue_.Schedule( GetCurrentTimeMs() + initialDelayMilliseconds, periodMilliseconds, listener );
+	}
+
+	void AttachOneShotTimerListener( int delayMilliseconds, TimerListener *listener )
+	{
+		timerQueue_.Schedule( GetCurrentTimeMs() + delayMilliseconds, 0, listener );
 	}
 
     void DetachPeriodicTimerListener( TimerListener *listener )
@@ -349,6 +358,24 @@ public:
 		assert( i != timerListeners_.end() );
 
 		timerListeners_.erase( i );
+		timerQueue_.Cancel( listener, true );
+	}
+
+	void CancelTimerListener( TimerListener *listener )
+	{
+		std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
+		while( i != timerListeners_.end() ){
+			if( i->listener == listener )
+				i = timerListeners_.erase( i );
+			else
+				++i;
+		}
+		timerQueue_.Cancel( listener, false );
+	}
+
+	void SetReceiveBatch( int maxDatagrams )
+	{
+		receiveBatch_ = (maxDatagrams > 0) ? maxDatagrams : 1;
 	}
 
     void Run()
@@ -373,15 +400,13 @@ public:
 		events[ socketListeners_.size() ] = breakEvent_; // last event in the collection is the break event
 
 		
-		// configure the timer queue
+		// configure the timer queue (periodic timers start over; pending one-shot timers keep their expiry)
 		double currentTimeMs = GetCurrentTimeMs();
-
-		// expiry time ms, listener
-		std::vector< std::pair< double, AttachedTimerListener > > timerQueue_;
+		timerQueue_.CancelAllPeriodic();
 		for( std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
 				i != timerListeners_.end(); ++i )
-			timerQueue_.push_back( std::make_pair( currentTimeMs + i->initialDelayMs, *i ) );
-		std::sort( timerQueue_.begin(), timerQueue_.end(), CompareScheduledTimerCalls );
+			timerQueue_.Schedule( currentTimeMs + i->initialDelayMs, i->periodMs, i->listener );
+		running_ = true;
 
 		const int MAX_BUFFER_SIZE = 4098;
 		char *data = new char[ MAX_BUFFER_SIZE ];
@@ -392,10 +417,10 @@ public:
 			double currentTimeMs = GetCurrentTimeMs();
 
             DWORD waitTime = INFINITE;
-            if( !timerQueue_.empty() ){
+            if( !timerQueue_.Empty() ){
 
-                waitTime = (DWORD)( timerQueue_.front().first >= currentTimeMs
-                            ? timerQueue_.front().first - currentTimeMs
+                waitTime = (DWORD)( timerQueue_.NextExpiryMs() >= currentTimeMs
+                            ? timerQueue_.NextExpiryMs() - currentTimeMs
                             : 0 );
             }
 
@@ -404,9 +429,12 @@ public:
 				break;
 
 			if( waitResult != WAIT_TIMEOUT ){
-				for( int i = waitResult - WAIT_OBJECT_0; i < (int)socketListeners_.size(); ++i ){
-					int size = socketListeners_[i].second->ReceiveFrom( remoteEndpoint, data, MAX_BUFFER_SIZE );
-					if( size > 0 ){
+				for( int i = waitResult - WAIT_OBJECT_0; i < (int)socketListeners_.size() && !break_; ++i ){
+					// drain up to receiveBatch_ datagrams per wakeup (the socket is non-blocking, so an empty read ends the batch)
+					for( int n = 0; n < receiveBatch_; ++n ){
+						int size = socketListeners_[i].second->ReceiveFrom( remoteEndpoint, data, MAX_BUFFER_SIZE );
+						if( size <= 0 )
+							break;
 						socketListeners_[i].first->ProcessPacket( data, size, remoteEndpoint );
 						if( break_ )
 							break;
@@ -415,21 +443,9 @@ public:
 			}
 
 			// execute any expired timers
-			currentTimeMs = GetCurrentTimeMs();
-			bool resort = false;
-			for( std::vector< std::pair< double, AttachedTimerListener > >::iterator i = timerQueue_.begin();
-					i != timerQueue_.end() && i->first <= currentTimeMs; ++i ){
-
-				i->second.listener->TimerExpired();
-				if( break_ )
-					break;
-
-				i->first += i->second.periodMs;
-				resort = true;
-			}
-			if( resort )
-				std::sort( timerQueue_.begin(), timerQueue_.end(), CompareScheduledTimerCalls );
+			timerQueue_.Expire( GetCurrentTimeMs(), break_ );
 		}
+		running_ = false;
 
 		delete [] data;
 
@@ -494,6 +510,21 @@ void SocketReceiveMultiplexer::DetachPeriodicTimerListener( TimerListener *liste
 	impl_->DetachPeriodicTimerListener( listener );
 }
 
+void SocketReceiveMultiplexer::AttachOneShotTimerListener( int delayMilliseconds, TimerListener *listener )
+{
+	impl_->AttachOneShotTimerListener( delayMilliseconds, listener );
+}
+
+void SocketReceiveMultiplexer::CancelTimerListener( TimerListener *listener )
+{
+	impl_->CancelTimerListener( listener );
+}
+
+void SocketReceiveMultiplexer::SetReceiveBatch( int maxDatagrams )
+{
+	impl_->SetReceiveBatch( maxDatagrams );
+}
+
 void SocketReceiveMultiplexer::Run()
 {
 	impl_->Run();
@@ -519,3 +550,4 @@ void SocketReceiveMultiplexer::AsynchronousBreak()
 	impl_->AsynchronousBreak();
 }
 
+#endif /* _WIN32 */
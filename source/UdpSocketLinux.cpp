@@ -0,0 +1,622 @@
+/*
+	oscpack -- Open Sound Control packet manipulation library
+	http://www.audiomulch.com/~rossb/oscpack
+
+	Copyright (c) 2004-2005 Ross Bencina <rossb@audiomulch.com>
+
+	Permission is hereby granted, free of charge, to any person obtaining
+	a copy of this software and associated documentation files
+	(the "Software"), to deal in the Software without restriction,
+	including without limitation the rights to use, copy, modify, merge,
+	publish, distribute, sublicense, and/or sell copies of the Software,
+	and to permit persons to whom the Software is furnished to do so,
+	subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	Any person wishing to distribute modifications to the Software is
+	requested to send the modifications to the original developer so that
+	they can be incorporated into the canonical version.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+	MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+	ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+	CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+// Linux implementation (see UdpSocket.cpp for Win32): the multiplexer waits on an epoll set, so each
+// wakeup costs O(ready sockets) however many are attached, and AsynchronousBreak() wakes it through an eventfd.
+// A ready socket is drained with one recvmmsg call per wakeup, into buffers kept from one Run() to the next
+#ifdef __linux__
+
+#include "UdpSocket.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <assert.h>
+#include <signal.h>
+
+#include "NetworkingUtils.h"
+#include "PacketListener.h"
+#include "TimerListener.h"
+#include "TimerQueue.h"
+
+
+static void SockaddrFromIpEndpointName( struct sockaddr_in& sockAddr, const IpEndpointName& endpoint )
+{
+    memset( (char *)&sockAddr, 0, sizeof(sockAddr ) );
+    sockAddr.sin_family = AF_INET;
+
+	sockAddr.sin_addr.s_addr = 
+		(endpoint.address == IpEndpointName::ANY_ADDRESS)
+		? INADDR_ANY
+		: htonl( endpoint.address );
+
+	sockAddr.sin_port =
+		(endpoint.port == IpEndpointName::ANY_PORT)
+		? (short)0
+		: htons( (short)endpoint.port );
+}
+
+
+static IpEndpointName IpEndpointNameFromSockaddr( const struct sockaddr_in& sockAddr )
+{
+	return IpEndpointName( 
+		(sockAddr.sin_addr.s_addr == INADDR_ANY) 
+			? IpEndpointName::ANY_ADDRESS 
+			: ntohl( sockAddr.sin_addr.s_addr ),
+		(sockAddr.sin_port == 0)
+			? IpEndpointName::ANY_PORT
+			: ntohs( sockAddr.sin_port )
+		);
+}
+
+
+class UdpSocket::Implementation{
+	bool isBound_;
+	bool isConnected_;
+
+	int socket_;
+	struct sockaddr_in connectedAddr_;
+	struct sockaddr_in sendToAddr_;
+
+public:
+
+	Implementation()
+		: isBound_( false )
+		, isConnected_( false )
+		, socket_( -1 )
+	{
+		if( (socket_ = socket( AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0 )) == -1 ){
+            throw std::runtime_error("unable to create udp socket\n");
+        }
+
+		memset( &sendToAddr_, 0, sizeof(sendToAddr_) );
+        sendToAddr_.sin_family = AF_INET;
+	}
+
+	~Implementation()
+	{
+		if (socket_ != -1) close(socket_);
+	}
+
+	IpEndpointName LocalEndpointFor( const IpEndpointName& remoteEndpoint ) const
+	{
+		assert( isBound_ );
+
+		// first connect the socket to the remote server
+        
+        struct sockaddr_in connectSockAddr;
+		SockaddrFromIpEndpointName( connectSockAddr, remoteEndpoint );
+       
+        if (connect(socket_, (struct sockaddr *)&connectSockAddr, sizeof(connectSockAddr)) < 0) {
+            throw std::runtime_error("unable to connect udp socket\n");
+        }
+
+        // get the address
+
+        struct sockaddr_in sockAddr;
+        memset( (char *)&sockAddr, 0, sizeof(sockAddr ) );
+        socklen_t length = sizeof(sockAddr);
+        if (getsockname(socket_, (struct sockaddr *)&sockAddr, &length) < 0) {
+            throw std::runtime_error("unable to getsockname\n");
+        }
+        
+		if( isConnected_ ){
+			// reconnect to the connected address
+			
+			if (connect(socket_, (struct sockaddr *)&connectedAddr_, sizeof(connectedAddr_)) < 0) {
+				throw std::runtime_error("unable to connect udp socket\n");
+			}
+
+		}else{
+			// unconnect from the remote address (AF_UNSPEC dissolves the association)
+		
+			struct sockaddr_in unconnectSockAddr;
+			memset( (char *)&unconnectSockAddr, 0, sizeof(unconnectSockAddr ) );
+			unconnectSockAddr.sin_family = AF_UNSPEC;
+
+			if( connect(socket_, (struct sockaddr *)&unconnectSockAddr, sizeof(unconnectSockAddr)) < 0 
+					&& errno != EAFNOSUPPORT ){
+				throw std::runtime_error("unable to un-connect udp socket\n");
+			}
+		}
+
+		return IpEndpointNameFromSockaddr( sockAddr );
+	}
+
+	void Connect( const IpEndpointName& remoteEndpoint )
+	{
+		SockaddrFromIpEndpointName( connectedAddr_, remoteEndpoint );
+       
+        if (connect(socket_, (struct sockaddr *)&connectedAddr_, sizeof(connectedAddr_)) < 0) {
+            throw std::runtime_error("unable to connect udp socket\n");
+        }
+
+		isConnected_ = true;
+	}
+
+	void Send( const char *data, int size )
+	{
+		assert( isConnected_ );
+
+        send( socket_, data, size, 0 );
+	}
+
+    void SendTo( const IpEndpointName& remoteEndpoint, const char *data, int size )
+	{
+		sendToAddr_.sin_addr.s_addr = htonl( remoteEndpoint.address );
+        sendToAddr_.sin_port = htons( (short)remoteEndpoint.port );
+
+        sendto( socket_, data, size, 0, (sockaddr*)&sendToAddr_, sizeof(sendToAddr_) );
+	}
+
+	void Bind( const IpEndpointName& localEndpoint )
+	{
+		struct sockaddr_in bindSockAddr;
+		SockaddrFromIpEndpointName( bindSockAddr, localEndpoint );
+
+        if (bind(socket_, (struct sockaddr *)&bindSockAddr, sizeof(bindSockAddr)) < 0) {
+            throw std::runtime_error("unable to bind udp socket\n");
+        }
+
+		isBound_ = true;
+	}
+
+	bool IsBound() const { return isBound_; }
+
+    int ReceiveFrom( IpEndpointName& remoteEndpoint, char *data, int size )
+	{
+		assert( isBound_ );
+
+		struct sockaddr_in fromAddr;
+        socklen_t fromAddrLen = sizeof(fromAddr);
+             	 
+        int result = recvfrom(socket_, data, size, 0,
+                    (struct sockaddr *) &fromAddr, (socklen_t*)&fromAddrLen);
+		if( result < 0 )
+			return 0;
+
+		remoteEndpoint.address = ntohl(fromAddr.sin_addr.s_addr);
+		remoteEndpoint.port = ntohs(fromAddr.sin_port);
+
+		return result;
+	}
+
+	int Socket() { return socket_; }
+};
+
+UdpSocket::UdpSocket()
+{
+	impl_ = new Implementation();
+}
+
+UdpSocket::~UdpSocket()
+{
+	delete impl_;
+}
+
+IpEndpointName UdpSocket::LocalEndpointFor( const IpEndpointName& remoteEndpoint ) const
+{
+	return impl_->LocalEndpointFor( remoteEndpoint );
+}
+
+void UdpSocket::Connect( const IpEndpointName& remoteEndpoint )
+{
+	impl_->Connect( remoteEndpoint );
+}
+
+void UdpSocket::Send( const char *data, int size )
+{
+	impl_->Send( data, size );
+}
+
+void UdpSocket::SendTo( const IpEndpointName& remoteEndpoint, const char *data, int size )
+{
+	impl_->SendTo( remoteEndpoint, data, size );
+}
+
+void UdpSocket::Bind( const IpEndpointName& localEndpoint )
+{
+	impl_->Bind( localEndpoint );
+}
+
+bool UdpSocket::IsBound() const
+{
+	return impl_->IsBound();
+}
+
+int UdpSocket::ReceiveFrom( IpEndpointName& remoteEndpoint, char *data, int size )
+{
+	return impl_->ReceiveFrom( remoteEndpoint, data, size );
+}
+
+
+struct AttachedTimerListener{
+	AttachedTimerListener( int id, int p, TimerListener *tl )
+		: initialDelayMs( id )
+		, periodMs( p )
+		, listener( tl ) {}
+	int initialDelayMs;
+	int periodMs;
+	TimerListener *listener;
+};
+
+
+SocketReceiveMultiplexer *multiplexerInstanceToAbortWithSigInt_ = 0;
+
+extern "C" /*static*/ void InterruptSignalHandler( int );
+/*static*/ void InterruptSignalHandler( int )
+{
+	multiplexerInstanceToAbortWithSigInt_->AsynchronousBreak();
+	signal( SIGINT, SIG_DFL );
+}
+
+
+class SocketReceiveMultiplexer::Implementation{
+	static const int MAX_EVENTS = 64; // ready sockets handled per wakeup (more are picked up by the next epoll_wait)
+	static const uint64_t BREAK_EVENT = ~(uint64_t)0; // epoll data of the break eventfd (sockets are tagged with their index)
+	static const int MAX_BUFFER_SIZE = 4098;
+
+	std::vector< std::pair< PacketListener*, UdpSocket* > > socketListeners_;
+	std::vector< AttachedTimerListener > timerListeners_; // periodic timers, scheduled afresh by each Run()
+	TimerQueue timerQueue_;
+	bool running_;
+
+	volatile bool break_;
+	int epollFd_;
+	int breakFd_; // eventfd written by AsynchronousBreak() (safe from a signal handler)
+
+	// receive batch: receiveBatch_ buffers of MAX_BUFFER_SIZE, each with its message header and source address
+	int receiveBatch_;
+	std::vector<char> buffers_;
+	std::vector<struct mmsghdr> messages_;
+	std::vector<struct iovec> iovecs_;
+	std::vector<struct sockaddr_in> fromAddrs_;
+
+	double GetCurrentTimeMs() const
+	{
+		struct timespec ts;
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+	}
+
+public:
+    Implementation()
+		: running_( false )
+		, break_( false )
+		, receiveBatch_( OSC_RECEIVE_BATCH )
+	{
+		epollFd_ = epoll_create1( EPOLL_CLOEXEC );
+		breakFd_ = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+		if( epollFd_ == -1 || breakFd_ == -1 ){
+			if( epollFd_ != -1 ) close( epollFd_ );
+			if( breakFd_ != -1 ) close( breakFd_ );
+			throw std::runtime_error("unable to create epoll multiplexer\n");
+		}
+
+		struct epoll_event event;
+		memset( &event, 0, sizeof(event) );
+		event.events = EPOLLIN;
+		event.data.u64 = BREAK_EVENT;
+		if( epoll_ctl( epollFd_, EPOLL_CTL_ADD, breakFd_, &event ) == -1 ){
+			close( epollFd_ );
+			close( breakFd_ );
+			throw std::runtime_error("unable to create epoll multiplexer\n");
+		}
+	}
+
+    ~Implementation()
+	{
+		close( breakFd_ );
+		close( epollFd_ );
+	}
+
+    void AttachSocketListener( UdpSocket *socket, PacketListener *listener )
+	{
+		assert( std::find( socketListeners_.begin(), socketListeners_.end(), std::make_pair(listener, socket) ) == socketListeners_.end() );
+		// we don't check that the same socket has been added multiple times, even though this is an error
+		socketListeners_.push_back( std::make_pair( listener, socket ) );
+	}
+
+    void DetachSocketListener( UdpSocket *socket, PacketListener *listener )
+	{
+		std::vector< std::pair< PacketListener*, UdpSocket* > >::iterator i = 
+				std::find( socketListeners_.begin(), socketListeners_.end(), std::make_pair(listener, socket) );
+		assert( i != socketListeners_.end() );
+
+		socketListeners_.erase( i );
+	}
+
+    void AttachPeriodicTimerListener( int periodMilliseconds, TimerListener *listener )
+	{
+		AttachPeriodicTimerListener( periodMilliseconds, periodMilliseconds, listener );
+	}
+
+	void AttachPeriodicTimerListener( int initialDelayMilliseconds, int periodMilliseconds, TimerListener *listener )
+	{
+		timerListeners_.push_back( AttachedTimerListener( initialDelayMilliseconds, periodMilliseconds, listener ) );
+		if( running_ )
+			timerQueue_.Schedule( GetCurrentTimeMs() + initialDelayMilliseconds, periodMilliseconds, listener );
+	}
+
+	void AttachOneShotTimerListener( int delayMilliseconds, TimerListener *listener )
+	{
+		timerQueue_.Schedule( GetCurrentTimeMs() + delayMilliseconds, 0, listener );
+	}
+
+    void DetachPeriodicTimerListener( TimerListener *listener )
+	{
+		std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
+		while( i != timerListeners_.end() ){
+			if( i->listener == listener )
+				break;
+			++i;
+		}
+
+		assert( i != timerListeners_.end() );
+
+		timerListeners_.erase( i );
+		timerQueue_.Cancel( listener, true );
+	}
+
+	void CancelTimerListener( TimerListener *listener )
+	{
+		std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
+		while( i != timerListeners_.end() ){
+			if( i->listener == listener )
+				i = timerListeners_.erase( i );
+			else
+				++i;
+		}
+		timerQueue_.Cancel( listener, false );
+	}
+
+	void SetReceiveBatch( int maxDatagrams )
+	{
+		receiveBatch_ = (maxDatagrams > 0) ? maxDatagrams : 1;
+	}
+
+	// (re)build the receive batch if its size has changed since the last Run()
+	void PrepareBatch()
+	{
+		if( (int)messages_.size() == receiveBatch_ )
+			return;
+
+		buffers_.assign( (size_t)receiveBatch_ * MAX_BUFFER_SIZE, 0 );
+		messages_.assign( receiveBatch_, mmsghdr() );
+		iovecs_.assign( receiveBatch_, iovec() );
+		fromAddrs_.assign( receiveBatch_, sockaddr_in() );
+		for( int i = 0; i < receiveBatch_; ++i ){
+			iovecs_[i].iov_base = &buffers_[ (size_t)i * MAX_BUFFER_SIZE ];
+			iovecs_[i].iov_len = MAX_BUFFER_SIZE;
+			memset( &messages_[i], 0, sizeof(messages_[i]) );
+			messages_[i].msg_hdr.msg_iov = &iovecs_[i];
+			messages_[i].msg_hdr.msg_iovlen = 1;
+			messages_[i].msg_hdr.msg_name = &fromAddrs_[i];
+			messages_[i].msg_hdr.msg_namelen = sizeof(fromAddrs_[i]);
+		}
+	}
+
+	// read what is waiting on a ready socket (up to receiveBatch_ datagrams) and pass each to its listener in order
+	// (NOTE: a Break() from a listener drops the rest of the batch, as those datagrams are already read)
+	void Receive( std::pair< PacketListener*, UdpSocket* >& socketListener )
+	{
+		IpEndpointName remoteEndpoint;
+		int received = recvmmsg( socketListener.second->impl_->Socket(), &messages_[0], receiveBatch_, MSG_DONTWAIT, NULL );
+		for( int i = 0; i < received; ++i ){
+			remoteEndpoint.address = ntohl( fromAddrs_[i].sin_addr.s_addr );
+			remoteEndpoint.port = ntohs( fromAddrs_[i].sin_port );
+			messages_[i].msg_hdr.msg_namelen = sizeof(fromAddrs_[i]);  // (the kernel overwrites it)
+			if( break_ )
+				continue;
+			socketListener.first->ProcessPacket( (const char*)iovecs_[i].iov_base, (int)messages_[i].msg_len, remoteEndpoint );
+		}
+	}
+
+    void Run()
+	{
+		break_ = false;
+		PrepareBatch();
+
+		// register the sockets, each tagged with its index so a wakeup goes straight to its listener
+		// (level-triggered and non-blocking, like the Win32 WSAEventSelect version, so a spurious wakeup cannot block a read)
+		std::vector<int> flags( socketListeners_.size(), 0 );
+		for( int i = 0; i < (int)socketListeners_.size(); ++i ){
+			int socket = socketListeners_[i].second->impl_->Socket();
+			flags[i] = fcntl( socket, F_GETFL, 0 );
+			fcntl( socket, F_SETFL, flags[i] | O_NONBLOCK );
+
+			struct epoll_event event;
+			memset( &event, 0, sizeof(event) );
+			event.events = EPOLLIN;
+			event.data.u64 = (uint64_t)i;
+			if( epoll_ctl( epollFd_, EPOLL_CTL_ADD, socket, &event ) == -1 )
+				throw std::runtime_error("unable to add socket to epoll set\n");
+		}
+
+		
+		// configure the timer queue (periodic timers start over; pending one-shot timers keep their expiry)
+		double currentTimeMs = GetCurrentTimeMs();
+		timerQueue_.CancelAllPeriodic();
+		for( std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
+				i != timerListeners_.end(); ++i )
+			timerQueue_.Schedule( currentTimeMs + i->initialDelayMs, i->periodMs, i->listener );
+		running_ = true;
+
+		struct epoll_event events[ MAX_EVENTS ];
+
+		while( !break_ ){
+
+			double currentTimeMs = GetCurrentTimeMs();
+
+            int waitTime = -1; // (infinite)
+            if( !timerQueue_.Empty() ){
+
+                waitTime = (int)( timerQueue_.NextExpiryMs() >= currentTimeMs
+                            ? timerQueue_.NextExpiryMs() - currentTimeMs + 0.999 // (rounded up, so a timer is never woken for early)
+                            : 0 );
+            }
+
+			int numReady = epoll_wait( epollFd_, events, MAX_EVENTS, waitTime );
+			if( break_ )
+				break;
+
+			for( int i = 0; i < numReady; ++i ){
+				if( events[i].data.u64 == BREAK_EVENT ){
+					uint64_t count;
+					while( read( breakFd_, &count, sizeof(count) ) > 0 ) {} // (a break from before this Run(); nothing to do)
+					continue;
+				}
+
+				Receive( socketListeners_[ (size_t)events[i].data.u64 ] );
+				if( break_ )
+					break;
+			}
+
+			// execute any expired timers
+			timerQueue_.Expire( GetCurrentTimeMs(), break_ );
+		}
+		running_ = false;
+
+		// unregister the sockets and make them blocking again
+		for( int i = 0; i < (int)socketListeners_.size(); ++i ){
+			int socket = socketListeners_[i].second->impl_->Socket();
+			epoll_ctl( epollFd_, EPOLL_CTL_DEL, socket, NULL );
+			fcntl( socket, F_SETFL, flags[i] );
+		}
+
+		// clear the break that ended this run, so the eventfd does not wake the next one
+		uint64_t count;
+		while( read( breakFd_, &count, sizeof(count) ) > 0 ) {}
+	}
+
+    void Break()
+	{
+		break_ = true;
+	}
+
+    void AsynchronousBreak()
+	{
+		break_ = true;
+		uint64_t one = 1;
+		ssize_t written = write( breakFd_, &one, sizeof(one) );
+		(void) written; // (only fails if the counter is saturated, in which case the eventfd is readable anyway)
+	}
+};
+
+
+
+SocketReceiveMultiplexer::SocketReceiveMultiplexer()
+{
+	impl_ = new Implementation();
+}
+
+SocketReceiveMultiplexer::~SocketReceiveMultiplexer()
+{	
+	delete impl_;
+}
+
+void SocketReceiveMultiplexer::AttachSocketListener( UdpSocket *socket, PacketListener *listener )
+{
+	impl_->AttachSocketListener( socket, listener );
+}
+
+void SocketReceiveMultiplexer::DetachSocketListener( UdpSocket *socket, PacketListener *listener )
+{
+	impl_->DetachSocketListener( socket, listener );
+}
+
+void SocketReceiveMultiplexer::AttachPeriodicTimerListener( int periodMilliseconds, TimerListener *listener )
+{
+	impl_->AttachPeriodicTimerListener( periodMilliseconds, listener );
+}
+
+void SocketReceiveMultiplexer::AttachPeriodicTimerListener( int initialDelayMilliseconds, int periodMilliseconds, TimerListener *listener )
+{
+	impl_->AttachPeriodicTimerListener( initialDelayMilliseconds, periodMilliseconds, listener );
+}
+
+void SocketReceiveMultiplexer::DetachPeriodicTimerListener( TimerListener *listener )
+{
+	impl_->DetachPeriodicTimerListener( listener );
+}
+
+void SocketReceiveMultiplexer::AttachOneShotTimerListener( int delayMilliseconds, TimerListener *listener )
+{
+	impl_->AttachOneShotTimerListener( delayMilliseconds, listener );
+}
+
+void SocketReceiveMultiplexer::CancelTimerListener( TimerListener *listener )
+{
+	impl_->CancelTimerListener( listener );
+}
+
+void SocketReceiveMultiplexer::SetReceiveBatch( int maxDatagrams )
+{
+	impl_->SetReceiveBatch( maxDatagrams );
+}
+
+void SocketReceiveMultiplexer::Run()
+{
+	impl_->Run();
+}
+
+void SocketReceiveMultiplexer::RunUntilSigInt()
+{
+	assert( multiplexerInstanceToAbortWithSigInt_ == 0 ); /* at present we support only one multiplexer instance running until sig int */
+	multiplexerInstanceToAbortWithSigInt_ = this;
+	signal( SIGINT, InterruptSignalHandler );
+	impl_->Run();
+	signal( SIGINT, SIG_DFL );
+	multiplexerInstanceToAbortWithSigInt_ = 0;
+}
+
+void SocketReceiveMultiplexer::Break()
+{
+	impl_->Break();
+}
+
+void SocketReceiveMultiplexer::AsynchronousBreak()
+{
+	impl_->AsynchronousBreak();
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,311 @@
+#include "benchmarkOsc.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <map>
+#include <string.h>
+#include <math.h>
+#include "chai3d.h"
+#include "UdpSocket.h"
+#include "OSC_Listener.h"
+#include "OscOutboundPacketStream.h"
+#include "OscAddressTrie.h"
+#include "OscAddressPattern.h"
+#include "cLoopTimer.h"
+using namespace std;
+using namespace chai3d;
+
+
+static const int benchmarkPackets = 200000;            // OSC packets sent through each receive loop timed by benchmarkOscReceive
+static const unsigned long benchmarkWindow = 256;      // packets the benchmark sender lets get ahead of the receiver (so the socket never overflows)
+static const int benchmarkPort = 7401;                 // loopback port benchmarkOscReceive sends to
+static const long long benchmarkStall = 1000000000;    // benchmarkOscReceive gives up if the receiver falls silent this long [nsec]
+static const int benchmarkMessages = 1000000;          // synthetic OSC messages dispatched by benchmarkOscDispatch
+static const int benchmarkParses = 500000;             // times each kind of message is parsed by benchmarkOscParse
+
+static volatile double parseSink;  // (where benchmarkOscParse leaves what it read, so the reads are not optimized away)
+
+
+// the Emotiv listener, counting the packets it has processed (for benchmarkOscReceive)
+class cCountingListener : public OSC_Listener
+{
+  public:
+    cCountingListener(void) : m_packets(0) {}
+    
+    void ProcessPacket(const char *data, int size, const IpEndpointName& remoteEndpoint) {
+        OSC_Listener::ProcessPacket(data, size, remoteEndpoint);
+        m_packets.store(m_packets.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    unsigned long getPackets(void) const { return m_packets.load(std::memory_order_acquire); }
+    
+  private:
+    std::atomic<unsigned long> m_packets;
+};
+
+// send benchmarkPackets OSC packets over loopback to a receive loop reading batch datagrams per wakeup, and write its packet rate and CPU per packet
+static void timeOscReceive(FILE* file, const char* name, int batch) {
+    
+    cCountingListener listener;
+    UdpListeningReceiveSocket socket(IpEndpointName("127.0.0.1", benchmarkPort), &listener);
+    socket.SetReceiveBatch(batch);
+    UdpTransmitSocket sender(IpEndpointName("127.0.0.1", benchmarkPort));
+    char buffer[64];
+    osc::OutboundPacketStream packet(buffer, sizeof(buffer));
+    packet << osc::BeginMessage("/COG/LEFT") << 0.5f << osc::EndMessage;
+    
+    std::atomic<bool> finished(false);
+    long long cpuNs = 0;
+    std::thread receiver([&]() {
+        long long cpu0 = getThreadCpuTimeNs();
+        socket.Run();
+        cpuNs = getThreadCpuTimeNs() - cpu0;
+        finished = true;
+    });
+    
+    // keep at most benchmarkWindow packets in flight (giving up if the receiver stalls, e.g., on a lost packet)
+    long long t0 = getMonotonicTimeNs();
+    bool stalled = false;
+    for (unsigned long sent = 0; sent < (unsigned long)benchmarkPackets && !stalled; sent++) {
+        long long waitStart = getMonotonicTimeNs();
+        while (sent - listener.getPackets() >= benchmarkWindow && !stalled) {
+            std::this_thread::yield();
+            stalled = (getMonotonicTimeNs() - waitStart > benchmarkStall);
+        }
+        sender.Send(packet.Data(), packet.Size());
+    }
+    long long waitStart = getMonotonicTimeNs();
+    while (listener.getPackets() < (unsigned long)benchmarkPackets && getMonotonicTimeNs() - waitStart < benchmarkStall) std::this_thread::yield();
+    long long elapsed = getMonotonicTimeNs() - t0;
+    
+    // (repeated, since a break that lands before Run() starts is forgotten)
+    while (!finished) {
+        socket.AsynchronousBreak();
+        cSleepMs(1);
+    }
+    receiver.join();
+    
+    unsigned long received = listener.getPackets();
+    fprintf(file, "  %-16s %9.0f packets/s  %6.0f nsec CPU/packet", name, received / (elapsed * 1.0e-9), (received > 0) ? (double)cpuNs / received : 0.0);
+    if (received < (unsigned long)benchmarkPackets) fprintf(file, "  (%lu packets lost)", benchmarkPackets - received);
+    fprintf(file, "\n");
+    
+}
+
+// time the Emotiv receive loop reading one datagram per wakeup against draining OSC_RECEIVE_BATCH at a time, and write a summary to a file
+void benchmarkOscReceive(FILE* file) {
+    
+    char batchName[32];
+    sprintf(batchName, "batches of %d", OSC_RECEIVE_BATCH);
+    fprintf(file, "OSC receive loop, %d packets over loopback (at most %lu in flight), including OSC_Listener dispatch:\n", benchmarkPackets, benchmarkWindow);
+    try {
+        timeOscReceive(file, "one per wakeup", 1);
+        timeOscReceive(file, batchName, OSC_RECEIVE_BATCH);
+    }
+    catch (std::exception& e) {
+        fprintf(file, "  unable to open loopback port %d: %s", benchmarkPort, e.what());
+    }
+    
+}
+
+// addresses "Mind your OSCs" sends (the listener only handles the /COG ones), in the proportions of the synthetic traffic
+static const char* const oscAddresses[] = { "/COG/LEFT", "/COG/RIGHT", "/COG/NEUTRAL", "/COG/LEFT", "/COG/RIGHT", "/COG/NEUTRAL",
+                                            "/EXP/BLINK", "/EXP/SMILE", "/AFF/Excitement", "/AFF/Engaged/Bored" };
+static const int numOscAddresses = sizeof(oscAddresses) / sizeof(oscAddresses[0]);
+
+// before: the chain of comparisons OSC_Listener::ProcessMessage used (returns the handler, or -1)
+static int findOscHandlerStrcmp(const char* address) {
+    
+    if (strcmp(address, "/COG/LEFT") == 0) return 0;
+    else if (strcmp(address, "/COG/RIGHT") == 0) return 1;
+    else if (strcmp(address, "/COG/NEUTRAL") == 0) return 2;
+    return -1;
+    
+}
+
+// subscriptions to families of addresses, as a listener for every Emotiv channel would register them
+static const char* const oscPatterns[] = { "/COG/*", "/EXP/{SMILE,CLENCH}", "/AFF/*" };
+static const int numOscPatterns = sizeof(oscPatterns) / sizeof(oscPatterns[0]);
+
+// orders C strings by contents (the old MessageMappingOscPacketListener map)
+struct cStringLess {
+    bool operator()(const char* a, const char* b) const { return strcmp(a, b) < 0; }
+};
+
+// time looking up the handler for synthetic /COG traffic with a strcmp chain, a map and the address trie, matching
+// it against address patterns with and without the match cache, then full OSC_Listener dispatch, and write a summary to a file
+void benchmarkOscDispatch(FILE* file) {
+    
+    // one packet per address, parsed up front so only the lookup is timed
+    char buffers[numOscAddresses][64];
+    int sizes[numOscAddresses];
+    vector<osc::ReceivedMessage> messages;
+    for (int i = 0; i < numOscAddresses; i++) {
+        osc::OutboundPacketStream packet(buffers[i], sizeof(buffers[i]));
+        packet << osc::BeginMessage(oscAddresses[i]) << 0.25f * (i % 4) << osc::EndMessage;
+        sizes[i] = (int)packet.Size();
+        messages.push_back(osc::ReceivedMessage(osc::ReceivedPacket(packet.Data(), packet.Size())));
+    }
+    
+    map<const char*, int, cStringLess> oscMap;
+    osc::AddressTrie trie;
+    for (int handler = 0; handler < 3; handler++) {
+        oscMap[oscAddresses[handler]] = handler;
+        trie.Add(oscAddresses[handler], handler);
+    }
+    
+    // (each counts the messages handled, so every lookup is used and the three can be checked against each other)
+    unsigned long strcmpHandled = 0, mapHandled = 0, trieHandled = 0;
+    long long t0 = getMonotonicTimeNs();
+    for (int i = 0; i < benchmarkMessages; i++) {
+        if (findOscHandlerStrcmp(messages[i % numOscAddresses].AddressPattern()) >= 0) strcmpHandled++;
+    }
+    long long strcmpNs = getMonotonicTimeNs() - t0;
+    
+    t0 = getMonotonicTimeNs();
+    for (int i = 0; i < benchmarkMessages; i++) {
+        if (oscMap.find(messages[i % numOscAddresses].AddressPattern()) != oscMap.end()) mapHandled++;
+    }
+    long long mapNs = getMonotonicTimeNs() - t0;
+    
+    t0 = getMonotonicTimeNs();
+    for (int i = 0; i < benchmarkMessages; i++) {
+        if (trie.Find(messages[i % numOscAddresses].AddressPattern()) >= 0) trieHandled++;
+    }
+    long long trieNs = getMonotonicTimeNs() - t0;
+    
+    // patterns: compiled ones tried in turn on every message, then the cache of what each address matched
+    vector<osc::AddressPattern> patterns;
+    for (int i = 0; i < numOscPatterns; i++) patterns.push_back(osc::AddressPattern(oscPatterns[i]));
+    unsigned long patternHandled = 0, cacheHandled = 0;
+    t0 = getMonotonicTimeNs();
+    for (int i = 0; i < benchmarkMessages; i++) {
+        const char* address = messages[i % numOscAddresses].AddressPattern();
+        for (int j = 0; j < numOscPatterns; j++) {
+            if (patterns[j].Match(address)) patternHandled++;
+        }
+    }
+    long long patternNs = getMonotonicTimeNs() - t0;
+    
+    osc::AddressMatchCache cache;
+    vector<int> matched;
+    t0 = getMonotonicTimeNs();
+    for (int i = 0; i < benchmarkMessages; i++) {
+        const char* address = messages[i % numOscAddresses].AddressPattern();
+        const int* ids;
+        int count;
+        if (!cache.Find(address, ids, count)) {
+            matched.clear();
+            for (int j = 0; j < numOscPatterns; j++) {
+                if (patterns[j].Match(address)) matched.push_back(j);
+            }
+            count = (int)matched.size();
+            ids = cache.Insert(address, matched.empty() ? NULL : &matched[0], count);
+        }
+        cacheHandled += count;
+    }
+    long long cacheNs = getMonotonicTimeNs() - t0;
+    
+    // the listener itself, on whole packets (parsing, dispatch, and publishing each state)
+    OSC_Listener listener;
+    IpEndpointName from("127.0.0.1", benchmarkPort);
+    t0 = getMonotonicTimeNs();
+    for (int i = 0; i < benchmarkMessages; i++) {
+        listener.ProcessPacket(buffers[i % numOscAddresses], sizes[i % numOscAddresses], from);
+    }
+    long long listenerNs = getMonotonicTimeNs() - t0;
+    emo_state state;
+    listener.getEmoState(state);
+    
+    fprintf(file, "OSC address dispatch, %d messages (%d%% /COG):\n", benchmarkMessages, 600 / numOscAddresses);
+    fprintf(file, "  %-12s %6.1f nsec/message  (%lu handled)\n", "strcmp chain", (double)strcmpNs / benchmarkMessages, strcmpHandled);
+    fprintf(file, "  %-12s %6.1f nsec/message  (%lu handled)\n", "map", (double)mapNs / benchmarkMessages, mapHandled);
+    fprintf(file, "  %-12s %6.1f nsec/message  (%lu handled)\n", "trie", (double)trieNs / benchmarkMessages, trieHandled);
+    fprintf(file, "  %-12s %6.1f nsec/message  (%lu matched)\n", "patterns", (double)patternNs / benchmarkMessages, patternHandled);
+    fprintf(file, "  %-12s %6.1f nsec/message  (%lu matched)\n", "match cache", (double)cacheNs / benchmarkMessages, cacheHandled);
+    fprintf(file, "  %-12s %6.1f nsec/packet   (%lu states published)\n", "OSC_Listener", (double)listenerNs / benchmarkMessages, state.sequence);
+    
+}
+
+
+// build an OSC message of floats (plus a trailing int32 sequence number if withSequence) in buffer, and return its size
+static int buildTelemetry(char* buffer, size_t size, const char* address, int floats, bool withSequence) {
+    
+    osc::OutboundPacketStream packet(buffer, size);
+    packet << osc::BeginMessage(address);
+    for (int i = 0; i < floats; i++) packet << (float)(4000.0 + 10.0 * sin(0.1 * i));
+    if (withSequence) packet << (osc::int32)12345;
+    packet << osc::EndMessage;
+    return (int)packet.Size();
+    
+}
+
+// parse one kind of message benchmarkParses times, reading its leading float arguments in order through the argument
+// stream or by index, and write the parse rates (plus, as a worst case, reverse order by rescanning from the first argument)
+static void timeOscParse(FILE* file, const char* name, const char* data, int size) {
+    
+    osc::ReceivedMessage sample(osc::ReceivedPacket(data, size));
+    unsigned long count = sample.ArgumentCount();
+    
+    // before: one pass in order through the argument stream
+    double sum = 0;
+    long long t0 = getMonotonicTimeNs();
+    for (int n = 0; n < benchmarkParses; n++) {
+        osc::ReceivedMessage m(osc::ReceivedPacket(data, size));
+        osc::ReceivedMessageArgumentStream args = m.ArgumentStream();
+        float value;
+        for (unsigned long i = 0; i < count; i++) {
+            if (m.TypeTags()[i] != osc::FLOAT_TYPE_TAG) break;
+            args >> value;
+            sum += value;
+        }
+    }
+    long long streamNs = getMonotonicTimeNs() - t0;
+    
+    // after: the positions found while the message was checked
+    t0 = getMonotonicTimeNs();
+    for (int n = 0; n < benchmarkParses; n++) {
+        osc::ReceivedMessage m(osc::ReceivedPacket(data, size));
+        for (unsigned long i = 0; i < count; i++) {
+            osc::ReceivedMessageArgument arg = m.Argument(i);
+            if (!arg.IsFloat()) break;
+            sum -= arg.AsFloat();
+        }
+    }
+    long long indexNs = getMonotonicTimeNs() - t0;
+    
+    // worst case without the index: a consumer picking out channels in reverse order walks to each one from the first
+    t0 = getMonotonicTimeNs();
+    for (int n = 0; n < benchmarkParses; n++) {
+        osc::ReceivedMessage m(osc::ReceivedPacket(data, size));
+        for (unsigned long i = count; i-- > 0;) {
+            osc::ReceivedMessageArgumentIterator arg = m.ArgumentsBegin();
+            for (unsigned long j = 0; j < i; j++) ++arg;
+            if (arg->IsFloat()) sum += arg->AsFloat();
+        }
+    }
+    long long rescanNs = getMonotonicTimeNs() - t0;
+    
+    double bytes = (double)size * benchmarkParses;
+    fprintf(file, "  %-22s %3lu args  stream %6.1f  indexed %6.1f nsec/message  (indexed %6.1f MB/s; reverse rescan %6.1f)\n", name, count,
+            (double)streamNs / benchmarkParses, (double)indexNs / benchmarkParses, bytes / (indexNs * 1.0e-3),
+            (double)rescanNs / benchmarkParses);
+    parseSink = sum;
+    
+}
+
+// time parsing Emotiv and multi-float telemetry messages and reading their arguments, and write a summary to a file
+void benchmarkOscParse(FILE* file) {
+    
+    char cog[64], eeg[256], telemetry[512];
+    osc::OutboundPacketStream packet(cog, sizeof(cog));
+    packet << osc::BeginMessage("/COG/LEFT") << 0.5f << osc::EndMessage;
+    int cogSize = (int)packet.Size();
+    int eegSize = buildTelemetry(eeg, sizeof(eeg), "/EEG", 14, false);
+    int telemetrySize = buildTelemetry(telemetry, sizeof(telemetry), "/telemetry/frame", 32, true);
+    
+    fprintf(file, "OSC message parsing, %d of each, float arguments read in order (%d indexed per message):\n", benchmarkParses, OSC_INDEXED_ARGUMENTS);
+    timeOscParse(file, "/COG/LEFT (Emotiv)", cog, cogSize);
+    timeOscParse(file, "/EEG (14 channels)", eeg, eegSize);
+    timeOscParse(file, "/telemetry/frame", telemetry, telemetrySize);
+    
+}
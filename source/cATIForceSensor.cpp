@@ -1,4 +1,5 @@
 #include "cATIForceSensor.h"
+#include "cDiagLog.h"
 
 #define FIRST_TORQUE_INDEX 3            // the index of the first torque reading in
                                         // the standard output list order (fx, fy, fz, tx, ty, tz)
@@ -373,13 +374,13 @@ int cATIForceSensor::ReadSingleFTRecord(double a_Readings[] )
 
     if ( NULL == m_Calibration )
     {
-		printf("Error 1Calibration: cATIForceSensor\n");
+		DIAG_ERROR("cATIForceSensor: no calibration loaded");
         return 1;
     }
 
     int retVal = 0;
 
-    double *gcVoltages = new double[NUM_STRAIN_GAUGES + 1]; // allow an extra reading for the thermistor
+    double gcVoltages[NUM_STRAIN_GAUGES + 1]; // allow an extra reading for the thermistor
     float nogcVoltages[NUM_STRAIN_GAUGES + 1];
     float tempResult [NUM_FT_AXES];
     retVal = ReadSingleGaugePoint( gcVoltages );
@@ -389,10 +390,10 @@ int cATIForceSensor::ReadSingleFTRecord(double a_Readings[] )
     {
         if ( 2 == retVal )
         {
+			DIAG_WARN("cATIForceSensor: gauges saturated");
             return 2; // saturation
-			printf("Error 2: cATIForceSensor");
         }
-		printf("Error 1: cATIForceSensor");
+		DIAG_ERROR("cATIForceSensor: error reading gauges");
         return 1;  // other error
     }
 
@@ -416,7 +417,6 @@ int cATIForceSensor::ReadSingleFTRecord(double a_Readings[] )
         a_Readings[i] = tempResult[i];
     }
 
-	delete gcVoltages;
 
     return retVal;
 }
@@ -0,0 +1,81 @@
+#include "cBCI2000Commands.h"
+#include <string.h>
+
+
+// longest line: a full-length name, a space, a sign and 10 digits, and a newline
+static const size_t maxLine = BCI2000_NAME_LENGTH + 13;
+
+
+// write a decimal integer at p (returns the end)
+static char* writeInteger(char* p, int value) {
+
+    char digits[12];
+    int n = 0;
+    unsigned int magnitude = (value < 0) ? 0U - (unsigned int)value : (unsigned int)value;
+    do {
+        digits[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) *p++ = '-';
+    while (n > 0) *p++ = digits[--n];
+    return p;
+
+}
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cBCI2000Commands::cBCI2000Commands(void)
+{
+    m_numPending = 0;
+    m_queued = 0;
+    m_collapsed = 0;
+    m_datagrams = 0;
+}
+
+// queue a state update, replacing any value already queued for it
+bool cBCI2000Commands::set(const char* a_name, int a_value) {
+
+    size_t length = strlen(a_name);
+    for (int i = 0; i < m_numPending; i++) {
+        if (m_nameLengths[i] == length && memcmp(m_names[i], a_name, length) == 0) {
+            m_values[i] = a_value;
+            m_queued++;
+            m_collapsed++;
+            return true;
+        }
+    }
+    if (m_numPending >= BCI2000_MAX_STATES || length == 0 || length >= BCI2000_NAME_LENGTH) return false;
+
+    int slot = m_numPending++;
+    memcpy(m_names[slot], a_name, length + 1);
+    m_nameLengths[slot] = length;
+    m_values[slot] = a_value;
+    m_queued++;
+    return true;
+
+}
+
+// send the queued updates as one datagram of "Name value" lines
+size_t cBCI2000Commands::flush(streamsock& a_socket) {
+
+    if (m_numPending == 0) return 0;
+
+    char* p = m_datagram;
+    for (int i = 0; i < m_numPending; i++) {
+        if ((size_t)(p - m_datagram) + maxLine > sizeof(m_datagram)) break;  // (not reached for BCI2000_MAX_STATES names)
+        memcpy(p, m_names[i], m_nameLengths[i]);
+        p += m_nameLengths[i];
+        *p++ = ' ';
+        p = writeInteger(p, m_values[i]);
+        *p++ = '\n';
+    }
+    m_numPending = 0;
+
+    if (!a_socket.is_open()) return 0;
+    size_t sent = a_socket.write(m_datagram, p - m_datagram);
+    if (sent > 0) m_datagrams++;
+    return sent;
+
+}
@@ -0,0 +1,226 @@
+#include "cBCI2000Parser.h"
+#include <string.h>
+#include <math.h>
+
+
+static const unsigned int maxSeeds = 10000;  // seeds tried per table size before the table is grown
+
+// exact powers of ten (as doubles)
+static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+
+static inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+static inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// parse a decimal number (e.g., "-12.5e-3") from [p, end), without needing a terminator
+static bool parseNumber(const char* p, const char* end, float& value) {
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+    // up to 19 significant digits in an integer, the rest only move the decimal point
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    for (; p < end && isDigit(*p); p++, any = true) {
+        if (digits < 19) { mantissa = 10 * mantissa + (*p - '0'); if (mantissa) digits++; }
+        else exponent++;
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && isDigit(*p); p++, any = true) {
+            if (digits < 19) { mantissa = 10 * mantissa + (*p - '0'); if (mantissa) digits++; exponent--; }
+        }
+    }
+    if (!any) return false;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) negativeExponent = (*p++ == '-');
+        int e = 0;
+        if (p >= end || !isDigit(*p)) return false;
+        for (; p < end && isDigit(*p); p++) if (e < 1000) e = 10 * e + (*p - '0');
+        exponent += negativeExponent ? -e : e;
+    }
+    while (p < end && isSpace(*p)) p++;
+    if (p != end) return false;
+
+    double result = (double)mantissa;
+    if (exponent > 0)       result *= (exponent <= 22) ? powersOfTen[exponent] : pow(10.0, exponent);
+    else if (exponent < 0)  result /= (exponent >= -22) ? powersOfTen[-exponent] : pow(10.0, -exponent);
+    value = (float)(negative ? -result : result);
+    return true;
+
+}
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cBCI2000Parser::cBCI2000Parser(void)
+{
+    m_numStates = 0;
+    m_mask = 0;
+    m_seed = 0;
+    for (int i = 0; i < 4 * BCI2000_MAX_STATES; i++) m_buckets[i] = -1;
+    reset();
+}
+
+// FNV-1a, salted with the seed
+unsigned int cBCI2000Parser::hash(const char* a_name, size_t a_length, unsigned int a_seed) const {
+
+    unsigned int h = 2166136261u ^ (a_seed * 2654435761u);
+    for (size_t i = 0; i < a_length; i++) {
+        h ^= (unsigned char)a_name[i];
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+
+}
+
+// register a state
+int cBCI2000Parser::registerState(const char* a_name) {
+
+    size_t length = strlen(a_name);
+    for (int i = 0; i < m_numStates; i++) {
+        if (m_nameLengths[i] == length && memcmp(m_names[i], a_name, length) == 0) return i;
+    }
+    if (m_numStates >= BCI2000_MAX_STATES || length == 0 || length >= BCI2000_NAME_LENGTH) return -1;
+
+    int slot = m_numStates++;
+    memcpy(m_names[slot], a_name, length + 1);
+    m_nameLengths[slot] = length;
+    m_values[slot] = 0;
+    m_updates[slot] = 0;
+    buildTable();
+    return slot;
+
+}
+
+// choose a seed and bucket count under which registered names do not collide
+void cBCI2000Parser::buildTable(void) {
+
+    unsigned int buckets = 8;
+    while (buckets < 2 * (unsigned int)m_numStates) buckets *= 2;
+
+    for (; buckets <= 4 * BCI2000_MAX_STATES; buckets *= 2) {
+        for (unsigned int seed = 0; seed < maxSeeds; seed++) {
+            for (unsigned int b = 0; b < buckets; b++) m_buckets[b] = -1;
+            bool collision = false;
+            for (int i = 0; i < m_numStates && !collision; i++) {
+                unsigned int b = hash(m_names[i], m_nameLengths[i], seed) & (buckets - 1);
+                if (m_buckets[b] >= 0) collision = true;
+                else m_buckets[b] = i;
+            }
+            if (!collision) {
+                m_mask = buckets - 1;
+                m_seed = seed;
+                return;
+            }
+        }
+    }
+
+    // (not reached for BCI2000_MAX_STATES names in 4x as many buckets)
+    m_mask = 0;
+    m_numStates = 0;
+    m_buckets[0] = -1;
+
+}
+
+void cBCI2000Parser::reset(void) {
+
+    for (int i = 0; i < BCI2000_MAX_STATES; i++) {
+        m_values[i] = 0;
+        m_updates[i] = 0;
+    }
+    m_lines = 0;
+    m_skipped = 0;
+    m_carryLength = 0;
+
+}
+
+// parse one complete line
+bool cBCI2000Parser::parseLine(const char* a_line, size_t a_length) {
+
+    const char* p = a_line;
+    const char* end = a_line + a_length;
+    while (p < end && isSpace(*p)) p++;
+    if (p == end) return false;  // (blank line)
+    m_lines++;
+
+    // name, hashed as it is scanned
+    const char* name = p;
+    unsigned int h = 2166136261u ^ (m_seed * 2654435761u);
+    for (; p < end && !isSpace(*p); p++) {
+        h ^= (unsigned char)*p;
+        h *= 16777619u;
+    }
+    h ^= h >> 15;
+    size_t nameLength = p - name;
+
+    // one bucket, one compare
+    int slot = (m_numStates > 0) ? m_buckets[h & m_mask] : -1;
+    float value;
+    if (slot < 0 || m_nameLengths[slot] != nameLength || memcmp(m_names[slot], name, nameLength) != 0) {
+        m_skipped++;
+        return false;
+    }
+    while (p < end && isSpace(*p)) p++;
+    if (!parseNumber(p, end, value)) {
+        m_skipped++;
+        return false;
+    }
+    m_values[slot] = value;
+    m_updates[slot]++;
+    return true;
+
+}
+
+// parse a buffer of lines
+int cBCI2000Parser::parse(const char* a_data, size_t a_length) {
+
+    int updated = 0;
+    const char* p = a_data;
+    const char* end = a_data + a_length;
+
+    // finish a line left over from the previous buffer
+    if (m_carryLength > 0) {
+        const char* newline = (const char*)memchr(p, '\n', end - p);
+        const char* lineEnd = (newline != NULL) ? newline : end;
+        size_t length = lineEnd - p;
+        if (m_carryLength + length > BCI2000_MAX_LINE) {
+            m_skipped++;             // too long to be a state; drop it
+            m_carryLength = 0;
+            if (newline == NULL) return 0;
+        }
+        else {
+            memcpy(m_carry + m_carryLength, p, length);
+            m_carryLength += length;
+            if (newline == NULL) return 0;
+            if (parseLine(m_carry, m_carryLength)) updated++;
+            m_carryLength = 0;
+        }
+        p = newline + 1;
+    }
+
+    // complete lines, in place
+    while (p < end) {
+        const char* newline = (const char*)memchr(p, '\n', end - p);
+        if (newline == NULL) break;
+        if (parseLine(p, newline - p)) updated++;
+        p = newline + 1;
+    }
+
+    // keep a trailing partial line for the next buffer
+    if (p < end) {
+        size_t length = end - p;
+        if (length <= BCI2000_MAX_LINE) {
+            memcpy(m_carry, p, length);
+            m_carryLength = length;
+        }
+        else m_skipped++;
+    }
+    return updated;
+
+}
@@ -0,0 +1,143 @@
+#include "cDiagLog.h"
+#include <string.h>
+
+
+static const char* levelNames[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+// the process-wide log
+cDiagLog diagLog;
+
+thread_local cRingBuffer<diag_record>* cDiagLog::s_ring = NULL;
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cDiagLog::cDiagLog(void) : m_numRings(0), m_unattached(0)
+{
+    m_start = getMonotonicTimeNs();
+}
+
+//===========================================================================
+// Destructor
+//===========================================================================
+cDiagLog::~cDiagLog(void)
+{
+    flush(stdout);
+}
+
+// give the calling thread a ring of its own
+bool cDiagLog::attachThread(void) {
+
+    if (s_ring != NULL) return true;
+
+    std::lock_guard<std::mutex> lock(m_attachLock);
+    int index = m_numRings.load(std::memory_order_relaxed);
+    if (index >= DIAG_MAX_THREADS) return false;
+    m_rings[index].allocate(DIAG_RING_SIZE);
+    m_numRings.store(index + 1, std::memory_order_release);  // (the flushing thread only looks at rings once they are allocated)
+    s_ring = &m_rings[index];
+    return true;
+
+}
+
+// format one message (one printf conversion at a time, with each argument cast to what its conversion expects)
+void cDiagLog::format(const diag_record& a_record, char* a_line, size_t a_size) const {
+
+    int level = a_record.site->level;
+    size_t n = snprintf(a_line, a_size, "[%10.4f] %-5s ", (a_record.time - m_start) * 1.0e-9,
+                        (level >= 0 && level <= DIAG_LEVEL_ERROR) ? levelNames[level] : "?");
+
+    int arg = 0;
+    for (const char* p = a_record.format; *p != '\0' && n < a_size - 1; p++) {
+        if (*p != '%') {
+            a_line[n++] = *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            a_line[n++] = '%';
+            p++;
+            continue;
+        }
+
+        // flags, width, and precision are kept; length modifiers are replaced to match the stored argument
+        char spec[32];
+        size_t s = 0;
+        spec[s++] = *p++;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != NULL && s < sizeof(spec) - 4) spec[s++] = *p++;
+        while (*p != '\0' && strchr("hlLqjzt", *p) != NULL) p++;
+        if (*p == '\0') break;
+        char conversion = *p;
+
+        int written = 0;
+        if (arg >= a_record.numArgs) written = snprintf(a_line + n, a_size - n, "<?>");
+        else if (strchr("diouxXc", conversion) != NULL) {
+            long long value = (a_record.types[arg] == 'd') ? (long long)a_record.args[arg].d : a_record.args[arg].i;
+            if (conversion == 'c') {
+                spec[s++] = 'c';
+                spec[s] = '\0';
+                written = snprintf(a_line + n, a_size - n, spec, (int)value);
+            }
+            else {
+                spec[s++] = 'l';
+                spec[s++] = 'l';
+                spec[s++] = conversion;
+                spec[s] = '\0';
+                written = snprintf(a_line + n, a_size - n, spec, value);
+            }
+        }
+        else if (strchr("fFeEgGaA", conversion) != NULL) {
+            double value = (a_record.types[arg] == 'i') ? (double)a_record.args[arg].i : a_record.args[arg].d;
+            spec[s++] = conversion;
+            spec[s] = '\0';
+            written = snprintf(a_line + n, a_size - n, spec, value);
+        }
+        else if (conversion == 's' && a_record.types[arg] == 's') {
+            spec[s++] = 's';
+            spec[s] = '\0';
+            written = snprintf(a_line + n, a_size - n, spec, (a_record.args[arg].s != NULL) ? a_record.args[arg].s : "(null)");
+        }
+        else written = snprintf(a_line + n, a_size - n, "<?>");
+        arg++;
+        if (written > 0) n += written;
+        if (n >= a_size) n = a_size - 1;
+    }
+
+    if (a_record.skipped > 0 && n < a_size - 1) {
+        int written = snprintf(a_line + n, a_size - n, " (%lu more suppressed)", a_record.skipped);
+        if (written > 0) n += written;
+        if (n >= a_size) n = a_size - 1;
+    }
+    a_line[n] = '\0';
+
+}
+
+// print everything buffered so far
+int cDiagLog::flush(FILE* a_file) {
+
+    std::lock_guard<std::mutex> lock(m_flushLock);
+    char line[512];
+    diag_record record;
+    int printed = 0;
+    int numRings = m_numRings.load(std::memory_order_acquire);
+    for (int i = 0; i < numRings; i++) {
+        while (m_rings[i].pop(record)) {
+            format(record, line, sizeof(line));
+            fprintf(a_file, "%s\n", line);
+            printed++;
+        }
+    }
+    if (printed > 0) fflush(a_file);
+    return printed;
+
+}
+
+// messages lost to full rings or to having too many threads
+unsigned long cDiagLog::getDropped(void) const {
+
+    unsigned long dropped = m_unattached.load(std::memory_order_relaxed);
+    int numRings = m_numRings.load(std::memory_order_acquire);
+    for (int i = 0; i < numRings; i++) dropped += m_rings[i].getDropped();
+    return dropped;
+
+}
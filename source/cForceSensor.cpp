@@ -5,6 +5,10 @@
 
 cForceSensor::cForceSensor(void)
 {
+    m_BackendType = HW_HARDWARE;
+    m_SimulatedMotors = NULL;
+    FTSensor = NULL;
+
     /*
     m_Force.set(0, 0, 0);
     */
@@ -12,7 +16,14 @@ cForceSensor::cForceSensor(void)
 
 cForceSensor::~cForceSensor(void)
 {
+    delete FTSensor;
+}
 
+// Function to select the real or simulated sensor
+void cForceSensor::Set_Backend(int a_type, cMotorBackend* a_simulatedMotors)
+{
+    m_BackendType = a_type;
+    m_SimulatedMotors = a_simulatedMotors;
 }
 
 // Function to acquire a sample of the force/torque data from the sensor
@@ -21,7 +32,8 @@ int cForceSensor::AcquireFTData()
     // Read in the force/torque data from the sensor
     static int Status;
 
-    Status = FTSensor->ReadSingleFTRecord(m_FTData);
+    if (FTSensor == NULL) return -1;
+    Status = FTSensor->readFT(m_FTData);
 
 
     if (Status != 0)
@@ -55,55 +67,23 @@ void cForceSensor::GetTorqueReading(double* a_readBuffer)
 // Function that initialize the force sensor and the DAQ hardware
 int cForceSensor::Initialize_Force_Sensor(std::string a_Device)
 {
-    FTSensor = new cATIForceSensor();
-
-    m_Frequency = 10000;
-    m_AveragingSize = 10;
-
-    // Load the calibration file before start force sensor
-    int loadCalFileStatus = FTSensor->LoadCalibrationFile(m_CalibrationFileLocation, 1);
-
-    if (loadCalFileStatus != 0)
+    delete FTSensor;
+    FTSensor = createForceBackend(m_BackendType, m_SimulatedMotors);
+    if (FTSensor == NULL)
     {
-        // Fail to load calibration file
-		printf("Fail to load calibration file!\n");
+		printf("No force sensor backend available!\n");
         return -1;
     }
 
-	int startStatus = FTSensor->StartSingleSampleAcquisition(a_Device, m_Frequency, m_AveragingSize, 0, false);
-    // int startStatus = FTSensor->StartSingleSampleAcquisition(FS_DEVICE_NAME, m_Frequency, m_AveragingSize, 0, false);
-
-    if (startStatus != 0)
-    {
-        // Start acquisition has failed
-		printf("Fail to start acquisition!\n");
-        return -2;
-    }
-
-    // Setting SI units
-    int setForceUnitsStatus = FTSensor->SetForceUnits("N");
-    if (setForceUnitsStatus != 0)
-    {
-        // Set force unit has failed
-		printf("Fail to set force unit!\n");
-        return -3;
-    }
-
-    int setTorqueUnitsStatus = FTSensor->SetTorqueUnits("Nm");
-    if (setTorqueUnitsStatus != 0)
-    {
-        // Set torque unit has failed
-		printf("Fail to set torque unit!\n");
-        return -4;
-    }
-
-    return 0;
+    // Load the calibration file, start acquisition, and set SI units (-1 to -4 on failure)
+    return FTSensor->initialize(m_CalibrationFileLocation, a_Device);
 }
 
 // Function to stop the force sensor acquisition of data
 int cForceSensor::Stop_Force_Sensor()
 {
-    return FTSensor->StopAcquisition();
+    if (FTSensor == NULL) return 0;
+    return FTSensor->stop();
 
     return 0;
 }
@@ -113,7 +93,8 @@ int cForceSensor::Stop_Force_Sensor()
 // Function to zero the bias of the force sensor
 int cForceSensor::Zero_Force_Sensor(void)
 {
-    int returnValue = FTSensor->BiasCurrentLoad();
+    if (FTSensor == NULL) return -1;
+    int returnValue = FTSensor->bias();
 
     return returnValue;
 
@@ -128,11 +109,11 @@ void cForceSensor::Set_Calibration_File_Loc(std::string a_Location)
 // Function to get the unit for the force vector
 std::string cForceSensor::GetForceUnit(void)
 {
-    return FTSensor->GetForceUnits();
+    return (FTSensor != NULL) ? FTSensor->getForceUnits() : std::string("N");
 }
 
 // Function to get the unit for the torque vector
 std::string cForceSensor::GetTorqueUnit(void)
 {
-    return FTSensor->GetTorqueUnits();
+    return (FTSensor != NULL) ? FTSensor->getTorqueUnits() : std::string("Nm");
 }
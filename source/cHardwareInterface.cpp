@@ -0,0 +1,387 @@
+/*******************************************************************************
+ *                                 INCLUDES                                    *
+ ******************************************************************************/
+#include "cHardwareInterface.h"
+#include "cSimulatedHardware.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#ifdef SENSORAY_ACTIVE
+extern "C"
+{
+#include "Win626.h"
+}
+#include "APP626.h"
+#endif
+#ifdef QUAD04_ACTIVE
+#include "cbw.h"
+#endif
+#ifdef NIDAQ_ACTIVE
+#include "NIDAQcommands.h"
+#endif
+#ifdef ATI_ACTIVE
+#include "cATIForceSensor.h"
+#endif
+
+// encoder and DAC constants shared with the NeuroTouch driver (MAX_COUNT, ENCCOUNT_TO_DEG, DAC_VSCALAR, ...)
+#include "cNeuroTouch.h"
+
+
+/*******************************************************************************
+ *							   PRIVATE VARIABLES                               *
+ *******************************************************************************/
+
+/***************** Sensoray Defines *****************/
+static const unsigned int board = 0;          // the board handle number (if single, 0)
+
+/***************** QUAD04 Defines *******************/
+static const unsigned int QUAD04_board_num = 0;  // Define the board number to be zero as defined by InstaCal
+static const unsigned int Encoder_A = 1;         // Encoder A maps to P1 on QUAD04 pinout
+static const unsigned int Encoder_B = 2;         // Encoder B maps to P2 on QUAD04 pinout
+static const double LoadValue = 100000;          // load value to deduct from counts of encoder
+
+/***************** NIDAQ Defines *******************/
+static const int MotorA_ChannelNum = 0;          // channel 0 dedicated to voltage output for motor A ref input, AO 0 --> pin 15
+static const int MotorB_ChannelNum = 1;          // channel 1 for voltage output for motor B ref input, AO 1 --> pin 31
+static const double MAX_DAC_VALUE = 65536;       // based on 16-bit DAC resolution
+static const unsigned int MAX_DAC_VOLTAGE = 10;  // Maximum voltage that can possibly be output by the DAC
+static const float DAC_VOLTAGE_STEP = (float)(MAX_DAC_VOLTAGE / MAX_DAC_VALUE);  // The discrete voltage step of the DAC
+static const unsigned int MAX_LIMIT_NIDAQ_VOLTAGE_OUT = 5;                       // AMC amplifiers configured for 5v operation
+static const float MAX_LIMIT_AD_VALUE = (MAX_LIMIT_NIDAQ_VOLTAGE_OUT / DAC_VOLTAGE_STEP);  // The maximum AD value that the DAC can output
+
+//--------------------------------- END OF PRIVATE VARIABLES ----------------
+
+
+/*******************************************************************************
+ *                          QUAD04 ENCODER BACKEND                             *
+ ******************************************************************************/
+#ifdef QUAD04_ACTIVE
+class cQuad04Encoders : public cEncoderBackend
+{
+  public:
+
+    // configure both counters for X4 quadrature and preload them with the rollover value
+    int openEncoders()
+    {
+        unsigned int ULStat = 0;
+        ULStat = cbC7266Config (QUAD04_board_num, Encoder_A, X4_QUAD, NORMAL_MODE,
+                                BINARY_ENCODING, INDEX_DISABLED, DISABLED, CARRY_BORROW, DISABLED);
+        ULStat = cbC7266Config (QUAD04_board_num, Encoder_B, X4_QUAD, NORMAL_MODE,
+                                BINARY_ENCODING, INDEX_DISABLED, DISABLED, CARRY_BORROW, DISABLED);
+        return zeroEncoders();
+    }
+
+    int closeEncoders() { return 0; }
+
+    // re-initialize the quadrature board to zero the encoders ( From Hopkins code )
+    int zeroEncoders()
+    {
+        unsigned int ULStat = 0;
+        ULStat = cbCLoad32 (QUAD04_board_num, COUNT1, LoadValue);
+        ULStat = cbCLoad32 (QUAD04_board_num, COUNT2, LoadValue);
+
+        // Prescaler definitions
+        ULStat = cbCLoad(QUAD04_board_num, PRESCALER1, 1);
+        ULStat = cbCLoad(QUAD04_board_num, PRESCALER2, 1);
+        return (ULStat == NOERRORS) ? 0 : 1;
+    }
+
+    int readEncoders(float& a_degA, float& a_degB)
+    {
+        // request the encoder tick count from the QUAD04
+        unsigned long Encoder_A_tics = 0;
+        unsigned long Encoder_B_tics = 0;
+        unsigned int ULStat = cbCIn32(QUAD04_board_num, Encoder_A, &Encoder_A_tics);
+        ULStat |= cbCIn32(QUAD04_board_num, Encoder_B, &Encoder_B_tics);
+
+        // subtract the load value from the accumulated tics, then divide by the counts per revolution (1024) and scale to degrees
+        a_degA = ((float)(Encoder_A_tics - LoadValue) / ENC_CNT_PER_REV) * 180;
+        a_degB = ((float)(Encoder_B_tics - LoadValue) / ENC_CNT_PER_REV) * 180;
+        return (ULStat == NOERRORS) ? 0 : 1;
+    }
+};
+#endif // QUAD04_ACTIVE
+
+
+/*******************************************************************************
+ *                     SENSORAY 626 ENCODER/DAC BACKEND                        *
+ ******************************************************************************/
+#ifdef SENSORAY_ACTIVE
+class cSensorayBoard : public cEncoderBackend, public cMotorBackend
+{
+  public:
+
+    cSensorayBoard() : m_open(false), m_zeroA(0), m_zeroB(0) {}
+
+    int openEncoders() { return openBoard(); }
+    int openMotors()   { return openBoard(); }
+
+    int closeEncoders() { return closeBoard(); }
+    int closeMotors()   { return closeBoard(); }
+
+    // capture the current angles so later readings are relative to them
+    int zeroEncoders()
+    {
+        m_zeroA = 0;
+        m_zeroB = 0;
+        float a, b;
+        readEncoders(a, b);
+        m_zeroA = a;
+        m_zeroB = b;
+        return 0;
+    }
+
+    int readEncoders(float& a_degA, float& a_degB)
+    {
+        // Read in value from Encoder for Motor A and B
+        unsigned long EncoderRawA = S626_CounterReadLatch(board, CNTR_0A); // Motor A
+        unsigned long EncoderRawB = S626_CounterReadLatch(board, CNTR_1A); // Motor B
+
+        a_degA = (float)(centerCount(EncoderRawA) * ENCCOUNT_TO_DEG - m_zeroA);
+        a_degB = (float)(centerCount(EncoderRawB) * ENCCOUNT_TO_DEG - m_zeroB);
+        return 0;
+    }
+
+    int writeVoltages(double a_voltA, double a_voltB)
+    {
+        // Check to make sure the voltage does not exceed the range of 5 volts
+        if (a_voltA > 5) a_voltA = 5;
+        if (a_voltB > 5) a_voltB = 5;
+        if (a_voltA < -5) a_voltA = -5;
+        if (a_voltB < -5) a_voltB = -5;
+
+        S626_WriteDAC(board, DAC1, (LONG)(a_voltA * DAC_VSCALAR)); // Motor A
+        S626_WriteDAC(board, DAC2, (LONG)(a_voltB * DAC_VSCALAR)); // Motor B
+        return 0;
+    }
+
+  private:
+
+    // center the raw 24-bit count around 0 (counts past the midpoint have gone negative)
+    static double centerCount(unsigned long a_raw)
+    {
+        if (a_raw < ((MAX_COUNT+1)/2)) return (double)a_raw;
+        return -MAX_COUNT+1+(double)a_raw;
+    }
+
+    int openBoard()
+    {
+        if (m_open) return 0;
+
+        // load the .dll and open the 626 card
+        S626_DLLOpen();
+        S626_OpenBoard(board, 0, 0, 0);
+        if (S626_GetErrors(board) != 0) {
+            printf("ERROR IN OPENING BOARD\n\n");
+            return S626_GetErrors(board);
+        }
+
+        // Motor A on counter 0A, Motor B on counter 1A
+        configureCounter(CNTR_0A);
+        configureCounter(CNTR_1A);
+        m_open = true;
+        return 0;
+    }
+
+    void configureCounter(WORD a_counter)
+    {
+        // Set counter operating mode.
+        S626_CounterModeSet( board, a_counter,
+        ( INDXSRC_SOFT << BF_INDXSRC )	|
+        ( INDXPOL_POS << BF_INDXPOL )	| // Active high index.
+        ( CLKSRC_COUNTER << BF_CLKSRC ) | // Operating mode is Counter.
+        ( CLKPOL_POS << BF_CLKPOL )		| // Active high clock.
+        ( CLKMULT_4X << BF_CLKMULT )	| // Clock multiplier is 4x.
+        ( CLKENAB_ALWAYS << BF_CLKENAB ) ); // Counting is always enabled.
+
+        // Initialize preload value to zero so that the counter core will be set to zero upon the occurance of an Index.
+        S626_CounterPreload( board, a_counter, 0 );
+
+        // Enable latching of accumulated counts on demand.
+        S626_CounterLatchSourceSet( board, a_counter, LATCHSRC_AB_READ );
+
+        // Enable the counter to generate interrupt requests upon index.
+        S626_CounterIntSourceSet( board, a_counter, INTSRC_INDX );
+
+        // Simulate Index Pulse to reset count at 0 on startup
+        S626_CounterSoftIndex(board, a_counter);
+    }
+
+    int closeBoard()
+    {
+        if (!m_open) return 0;
+
+        // Program all analog outputs to zero volts and all digital outputs to the inactive state.
+        for ( WORD DacChan = 0; DacChan < 4; S626_WriteDAC( board, DacChan++, 0 ));
+        for ( WORD Group = 0; Group < 3; S626_DIOWriteBankSet( board, Group++, 0 ));
+
+        // Unregister the board, release its handle, and close the DLL
+        S626_CloseBoard( board );
+        S626_DLLClose();
+        m_open = false;
+        return 0;
+    }
+
+    bool m_open;
+    double m_zeroA;  // [deg]
+    double m_zeroB;
+};
+#endif // SENSORAY_ACTIVE
+
+
+/*******************************************************************************
+ *                          NI-DAQ MOTOR BACKEND                               *
+ ******************************************************************************/
+#ifdef NIDAQ_ACTIVE
+class cNidaqMotors : public cMotorBackend
+{
+  public:
+
+    cNidaqMotors() : m_daq(NULL) {}
+    ~cNidaqMotors() { delete m_daq; }
+
+    // the DAQ tasks are only created once the device is actually opened
+    int openMotors()
+    {
+        if (m_daq == NULL) m_daq = new NIDAQcommands();
+        return 0;
+    }
+
+    int closeMotors()
+    {
+        if (m_daq == NULL) return 0;
+        m_daq->writeAnalogOutput(MotorA_ChannelNum, 0);
+        m_daq->writeAnalogOutput(MotorB_ChannelNum, 0);
+        return 0;
+    }
+
+    int writeVoltages(double a_voltA, double a_voltB)
+    {
+        if (m_daq == NULL) return 1;
+
+        // the DAQ takes the desired voltage directly; just keep the command within the amplifiers' range
+        const double limit = MAX_LIMIT_NIDAQ_VOLTAGE_OUT;  // (signed, so it can be negated)
+        if (a_voltA > limit) a_voltA = limit;
+        if (a_voltB > limit) a_voltB = limit;
+        if (a_voltA < -limit) a_voltA = -limit;
+        if (a_voltB < -limit) a_voltB = -limit;
+
+        m_daq->writeAnalogOutput(MotorA_ChannelNum, a_voltA);
+        m_daq->writeAnalogOutput(MotorB_ChannelNum, a_voltB);
+        return 0;
+    }
+
+  private:
+    NIDAQcommands* m_daq;
+};
+#endif // NIDAQ_ACTIVE
+
+
+/*******************************************************************************
+ *                        ATI FORCE/TORQUE BACKEND                             *
+ ******************************************************************************/
+#ifdef ATI_ACTIVE
+class cAtiForceSensor : public cForceBackend
+{
+  public:
+
+    cAtiForceSensor() : m_sensor(NULL) {}
+    ~cAtiForceSensor() { delete m_sensor; }
+
+    int initialize(const std::string& a_calibrationFile, const std::string& a_device)
+    {
+        m_sensor = new cATIForceSensor();
+
+        // Load the calibration file before start force sensor
+        if (m_sensor->LoadCalibrationFile(a_calibrationFile, 1) != 0) {
+            printf("Fail to load calibration file!\n");
+            return -1;
+        }
+
+        if (m_sensor->StartSingleSampleAcquisition(a_device, m_frequency, m_averagingSize, 0, false) != 0) {
+            printf("Fail to start acquisition!\n");
+            return -2;
+        }
+
+        // Setting SI units
+        if (m_sensor->SetForceUnits("N") != 0) {
+            printf("Fail to set force unit!\n");
+            return -3;
+        }
+        if (m_sensor->SetTorqueUnits("Nm") != 0) {
+            printf("Fail to set torque unit!\n");
+            return -4;
+        }
+
+        return 0;
+    }
+
+    int stop()           { return (m_sensor != NULL) ? m_sensor->StopAcquisition() : 0; }
+    int bias()           { return (m_sensor != NULL) ? m_sensor->BiasCurrentLoad() : 1; }
+    int readFT(double a_ft[6]) { return (m_sensor != NULL) ? m_sensor->ReadSingleFTRecord(a_ft) : 1; }
+    std::string getForceUnits()  { return m_sensor->GetForceUnits(); }
+    std::string getTorqueUnits() { return m_sensor->GetTorqueUnits(); }
+
+  private:
+    static const int m_averagingSize = 10;
+    static const double m_frequency;
+    cATIForceSensor* m_sensor;
+};
+const double cAtiForceSensor::m_frequency = 10000;
+#endif // ATI_ACTIVE
+
+
+/*******************************************************************************
+ *                               FACTORIES                                     *
+ ******************************************************************************/
+
+// create the encoder and motor backends for the NeuroTouch
+bool createNeuroTouchBackends(int a_type, cEncoderBackend*& a_encoders, cMotorBackend*& a_motors) {
+
+    a_encoders = NULL;
+    a_motors = NULL;
+
+    if (a_type == HW_SIMULATED) {
+        cSimulatedNeuroTouch* sim = new cSimulatedNeuroTouch();
+        a_encoders = sim;
+        a_motors = sim;
+        return true;
+    }
+
+#ifdef SENSORAY_ACTIVE
+    cSensorayBoard* sensoray = new cSensorayBoard();
+    a_encoders = sensoray;
+    a_motors = sensoray;
+#endif
+#ifdef QUAD04_ACTIVE
+    a_encoders = new cQuad04Encoders();
+#endif
+#ifdef NIDAQ_ACTIVE
+    a_motors = new cNidaqMotors();
+#endif
+
+    if (a_encoders == NULL || a_motors == NULL) {
+        printf("\nNo NeuroTouch hardware compiled in for this platform.\n");
+        return false;
+    }
+    return true;
+
+}
+
+// create the force/torque sensor backend
+cForceBackend* createForceBackend(int a_type, cMotorBackend* a_simulatedMotors) {
+
+    if (a_type == HW_SIMULATED) {
+        return new cSimulatedForceSensor(dynamic_cast<cSimulatedNeuroTouch*>(a_simulatedMotors));
+    }
+
+#ifdef ATI_ACTIVE
+    return new cAtiForceSensor();
+#else
+    printf("\nNo force sensor hardware compiled in for this platform.\n");
+    return NULL;
+#endif
+
+}
@@ -0,0 +1,198 @@
+#include "cInputRecording.h"
+#include "cLoopTimer.h"
+#include <string.h>
+#include <stdint.h>
+
+
+static const size_t fileHeaderSize = 8 + 4 + 4;       // magic + version, BCI
+static const size_t datagramHeaderSize = 8 + 1 + 4;   // arrival time, source, length
+
+
+static void putUint32(unsigned char* a_to, uint32_t a_value) {
+
+    for (int i = 0; i < 4; i++) a_to[i] = (unsigned char)(a_value >> (8 * i));
+
+}
+
+static uint32_t getUint32(const unsigned char* a_from) {
+
+    return (uint32_t)a_from[0] | ((uint32_t)a_from[1] << 8) | ((uint32_t)a_from[2] << 16) | ((uint32_t)a_from[3] << 24);
+
+}
+
+static void putUint64(unsigned char* a_to, uint64_t a_value) {
+
+    for (int i = 0; i < 8; i++) a_to[i] = (unsigned char)(a_value >> (8 * i));
+
+}
+
+static uint64_t getUint64(const unsigned char* a_from) {
+
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) value = (value << 8) | a_from[i];
+    return value;
+
+}
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cInputRecorder::cInputRecorder(void)
+{
+    m_file = NULL;
+    m_startNs = 0;
+    m_buffer = NULL;
+    m_used = 0;
+    m_datagrams = 0;
+    m_bytes = 0;
+}
+
+//===========================================================================
+// Destructor
+//===========================================================================
+cInputRecorder::~cInputRecorder(void)
+{
+    close();
+    delete[] m_buffer;
+}
+
+// create the file and write its header
+bool cInputRecorder::open(const char* a_filename, int a_bci) {
+
+    close();
+    m_file = fopen(a_filename, "wb");
+    if (m_file == NULL) {
+        printf("\nUnable to create input recording %s\n", a_filename);
+        return false;
+    }
+    if (m_buffer == NULL) m_buffer = new unsigned char[INPUT_CHUNK_BYTES];
+
+    unsigned char header[fileHeaderSize];
+    memcpy(header, INPUT_MAGIC, 8);
+    putUint32(header + 8, INPUT_VERSION);
+    putUint32(header + 12, (uint32_t)a_bci);
+    fwrite(header, 1, fileHeaderSize, m_file);
+
+    m_startNs = getMonotonicTimeNs();
+    m_used = 0;
+    m_datagrams = 0;
+    m_bytes = 0;
+    return true;
+
+}
+
+// append one datagram (NOTE: only touches the file once a chunk has filled up)
+void cInputRecorder::record(int a_source, const char* a_data, size_t a_length, long long a_arrivalNs) {
+
+    if (m_file == NULL) return;
+    if (a_length > INPUT_MAX_DATAGRAM) a_length = INPUT_MAX_DATAGRAM;
+
+    unsigned char header[datagramHeaderSize];
+    putUint64(header, (uint64_t)(a_arrivalNs - m_startNs));
+    header[8] = (unsigned char)a_source;
+    putUint32(header + 9, (uint32_t)a_length);
+
+    if (m_used + datagramHeaderSize + a_length > INPUT_CHUNK_BYTES) writeBuffer();
+    if (datagramHeaderSize + a_length > INPUT_CHUNK_BYTES) {
+        fwrite(header, 1, datagramHeaderSize, m_file);  // (a datagram bigger than a chunk goes straight to the file)
+        fwrite(a_data, 1, a_length, m_file);
+    }
+    else {
+        memcpy(m_buffer + m_used, header, datagramHeaderSize);
+        memcpy(m_buffer + m_used + datagramHeaderSize, a_data, a_length);
+        m_used += datagramHeaderSize + a_length;
+    }
+    m_datagrams++;
+    m_bytes += a_length;
+
+}
+
+void cInputRecorder::writeBuffer(void) {
+
+    if (m_used > 0) fwrite(m_buffer, 1, m_used, m_file);
+    m_used = 0;
+
+}
+
+void cInputRecorder::close(void) {
+
+    if (m_file == NULL) return;
+    writeBuffer();
+    fclose(m_file);
+    m_file = NULL;
+
+}
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cInputReplayer::cInputReplayer(void)
+{
+    m_file = NULL;
+    m_bci = 0;
+    m_source = 0;
+    m_timeNs = 0;
+    m_data = NULL;
+    m_length = 0;
+}
+
+//===========================================================================
+// Destructor
+//===========================================================================
+cInputReplayer::~cInputReplayer(void)
+{
+    close();
+    delete[] m_data;
+}
+
+// open a recording and check its header
+bool cInputReplayer::open(const char* a_filename) {
+
+    close();
+    m_file = fopen(a_filename, "rb");
+    if (m_file == NULL) {
+        printf("\nUnable to open input recording %s\n", a_filename);
+        return false;
+    }
+
+    unsigned char header[fileHeaderSize];
+    if (fread(header, 1, fileHeaderSize, m_file) != fileHeaderSize || memcmp(header, INPUT_MAGIC, 8) != 0) {
+        printf("\n%s is not an input recording\n", a_filename);
+        close();
+        return false;
+    }
+    if (getUint32(header + 8) > INPUT_VERSION) {
+        printf("\n%s is a newer recording (version %u) than this program reads\n", a_filename, getUint32(header + 8));
+        close();
+        return false;
+    }
+    m_bci = (int)getUint32(header + 12);
+    if (m_data == NULL) m_data = new char[INPUT_MAX_DATAGRAM];
+    m_length = 0;
+    return true;
+
+}
+
+// read the next datagram
+bool cInputReplayer::next(void) {
+
+    if (m_file == NULL) return false;
+
+    unsigned char header[datagramHeaderSize];
+    if (fread(header, 1, datagramHeaderSize, m_file) != datagramHeaderSize) return false;
+    m_timeNs = (long long)getUint64(header);
+    m_source = header[8];
+    m_length = getUint32(header + 9);
+    if (m_length > INPUT_MAX_DATAGRAM) return false;
+    return fread(m_data, 1, m_length, m_file) == m_length;
+
+}
+
+void cInputReplayer::close(void) {
+
+    if (m_file != NULL) fclose(m_file);
+    m_file = NULL;
+
+}
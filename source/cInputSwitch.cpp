@@ -0,0 +1,102 @@
+#include "cInputSwitch.h"
+#include "cLoopTimer.h"
+#include <chrono>
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cInputSwitch::cInputSwitch(void) : m_selected(INPUT_NONE), m_shutdown(false), m_switches(0)
+{
+    for (int i = 0; i < INPUT_MODES; i++) {
+        m_sources[i] = NULL;
+        m_states[i] = IDLE;
+        m_selections[i] = 0;
+    }
+}
+
+void cInputSwitch::setSource(int a_input, cInputSource* a_source) {
+
+    if (a_input < 0 || a_input >= INPUT_MODES) return;
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_sources[a_input] = a_source;
+
+}
+
+// switch sources (NOTE: interrupts the running source every millisecond until its host has closed it, so an interrupt that lands just before run() is not lost)
+long long cInputSwitch::select(int a_input) {
+
+    long long start = getMonotonicTimeNs();
+    std::unique_lock<std::mutex> lock(m_lock);
+    int previous = m_selected;
+    if (a_input == previous || m_shutdown) return 0;
+
+    m_selected = a_input;
+    if (a_input >= 0 && a_input < INPUT_MODES) m_selections[a_input]++;
+    m_switches++;
+    m_changed.notify_all();
+
+    if (previous >= 0 && previous < INPUT_MODES) {
+        while (m_states[previous] != IDLE) {
+            if (m_states[previous] == RUNNING) m_sources[previous]->interrupt();
+            m_changed.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+    return getMonotonicTimeNs() - start;
+
+}
+
+void cInputSwitch::shutdown(void) {
+
+    select(INPUT_NONE);
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_shutdown = true;
+    m_changed.notify_all();
+
+}
+
+// open, run, and close the source for a_input whenever it is selected
+void cInputSwitch::host(int a_input) {
+
+    if (a_input < 0 || a_input >= INPUT_MODES) return;
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (!m_shutdown) {
+        cInputSource* source = m_sources[a_input];
+        if (m_selected != a_input || source == NULL) {
+            m_changed.wait(lock);
+            continue;
+        }
+        unsigned long selection = m_selections[a_input];
+
+        m_states[a_input] = OPENING;
+        lock.unlock();
+        bool opened = source->open();
+        lock.lock();
+
+        bool ended = false;
+        if (opened && m_selected == a_input) {
+            m_states[a_input] = RUNNING;
+            lock.unlock();
+            source->run();
+            lock.lock();
+            ended = (m_selected == a_input);
+        }
+
+        if (opened) {
+            m_states[a_input] = CLOSING;
+            lock.unlock();
+            source->close();
+            lock.lock();
+        }
+        m_states[a_input] = IDLE;
+        m_changed.notify_all();
+
+        // a source that could not open is retried while it stays selected; one that ended on its own waits to be selected again
+        if (!opened) m_changed.wait_for(lock, std::chrono::milliseconds(INPUT_RETRY_MS));
+        else if (ended) {
+            while (!m_shutdown && m_selected == a_input && m_selections[a_input] == selection) m_changed.wait(lock);
+        }
+    }
+
+}
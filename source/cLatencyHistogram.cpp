@@ -0,0 +1,120 @@
+#include "cLatencyHistogram.h"
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cLatencyHistogram::cLatencyHistogram(void)
+{
+    m_thresholdNs = 0;
+    reset();
+}
+
+// clear all samples
+void cLatencyHistogram::reset(void) {
+
+    for (int i = 0; i < HIST_NUM_BUCKETS; i++) m_buckets[i].store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_overThreshold.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+
+}
+
+// count samples above a_thresholdNs separately
+void cLatencyHistogram::setThreshold(long long a_thresholdNs) {
+
+    m_thresholdNs = a_thresholdNs;
+
+}
+
+// bucket index for a value (linear below HIST_SUB_COUNT, then HIST_SUB_COUNT buckets per power of two)
+int cLatencyHistogram::bucketIndex(long long a_valueNs) {
+
+    if (a_valueNs < 0) a_valueNs = 0;
+    if (a_valueNs < HIST_SUB_COUNT) return (int)a_valueNs;
+
+    // position of the most significant bit
+    int exponent = 0;
+    unsigned long long v = (unsigned long long)a_valueNs;
+    while (v >>= 1) exponent++;
+    if (exponent > HIST_MAX_EXP) return HIST_NUM_BUCKETS - 1;
+
+    int shift = exponent - HIST_SUB_BITS;
+    int sub = (int)((unsigned long long)a_valueNs >> shift) - HIST_SUB_COUNT;
+    return HIST_SUB_COUNT + shift * HIST_SUB_COUNT + sub;
+
+}
+
+// largest value that maps to a bucket
+long long cLatencyHistogram::bucketUpperBound(int a_index) {
+
+    if (a_index < HIST_SUB_COUNT) return a_index;
+
+    int shift = (a_index - HIST_SUB_COUNT) / HIST_SUB_COUNT;
+    int sub = (a_index - HIST_SUB_COUNT) % HIST_SUB_COUNT;
+    return (((long long)(HIST_SUB_COUNT + sub + 1)) << shift) - 1;
+
+}
+
+// record one duration [nsec]
+void cLatencyHistogram::record(long long a_valueNs) {
+
+    // only one thread records, so plain load/store pairs are enough (and cheaper than atomic increments)
+    std::atomic<unsigned long>& bucket = m_buckets[bucketIndex(a_valueNs)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    unsigned long long count = m_count.load(std::memory_order_relaxed);
+    if (count == 0 || a_valueNs < m_min.load(std::memory_order_relaxed)) m_min.store(a_valueNs, std::memory_order_relaxed);
+    if (count == 0 || a_valueNs > m_max.load(std::memory_order_relaxed)) m_max.store(a_valueNs, std::memory_order_relaxed);
+    m_sum.store(m_sum.load(std::memory_order_relaxed) + a_valueNs, std::memory_order_relaxed);
+    if (m_thresholdNs > 0 && a_valueNs > m_thresholdNs) {
+        m_overThreshold.store(m_overThreshold.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    m_count.store(count + 1, std::memory_order_release);
+
+}
+
+// compute summary statistics
+void cLatencyHistogram::getSummary(latency_summary& a_summary) const {
+
+    a_summary.count = m_count.load(std::memory_order_acquire);
+    a_summary.min = m_min.load(std::memory_order_relaxed);
+    a_summary.max = m_max.load(std::memory_order_relaxed);
+    a_summary.overThreshold = m_overThreshold.load(std::memory_order_relaxed);
+    a_summary.mean = (a_summary.count > 0) ? (double)m_sum.load(std::memory_order_relaxed) / (double)a_summary.count : 0.0;
+    a_summary.p50 = 0;
+    a_summary.p99 = 0;
+    a_summary.p999 = 0;
+    if (a_summary.count == 0) return;
+
+    // walk the buckets once, picking off each percentile as its rank is passed
+    unsigned long long rank50 = (unsigned long long)(0.50 * a_summary.count);
+    unsigned long long rank99 = (unsigned long long)(0.99 * a_summary.count);
+    unsigned long long rank999 = (unsigned long long)(0.999 * a_summary.count);
+    unsigned long long seen = 0;
+    bool found50 = false, found99 = false;
+    for (int i = 0; i < HIST_NUM_BUCKETS; i++) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (!found50 && seen > rank50) { a_summary.p50 = bucketUpperBound(i); found50 = true; }
+        if (!found99 && seen > rank99) { a_summary.p99 = bucketUpperBound(i); found99 = true; }
+        if (seen > rank999) { a_summary.p999 = bucketUpperBound(i); break; }
+    }
+
+    // bucket bounds can overshoot the true extremes
+    if (a_summary.p50 > a_summary.max) a_summary.p50 = a_summary.max;
+    if (a_summary.p99 > a_summary.max) a_summary.p99 = a_summary.max;
+    if (a_summary.p999 > a_summary.max || a_summary.p999 == 0) a_summary.p999 = a_summary.max;
+
+}
+
+// write a one-line summary to a file
+void cLatencyHistogram::print(FILE* a_file, const char* a_name) const {
+
+    latency_summary s;
+    getSummary(s);
+    fprintf(a_file, "%-14s n=%llu  mean=%.1f  p50=%.1f  p99=%.1f  p99.9=%.1f  max=%.1f usec  over=%llu\n",
+            a_name, s.count, s.mean * 1.0e-3, s.p50 * 1.0e-3, s.p99 * 1.0e-3, s.p999 * 1.0e-3, s.max * 1.0e-3, s.overThreshold);
+
+}
@@ -0,0 +1,224 @@
+#include "cLoopTimer.h"
+
+#ifdef _WIN32
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <time.h>
+#include <errno.h>
+#endif
+
+
+static const double defaultPeriod = 0.001;          // default loop period [sec]
+static const long long reportInterval = 1000000000; // how often CPU load is recomputed [nsec]
+#ifdef _WIN32
+static const double defaultSpin = 200.0;            // waitable timers are only accurate to a few hundred usec
+#else
+static const double defaultSpin = 50.0;             // clock_nanosleep wake-up latency on a typical kernel [usec]
+#endif
+
+
+// current time from a monotonic clock [nsec]
+long long getMonotonicTimeNs(void) {
+
+#ifdef _WIN32
+    static LARGE_INTEGER frequency = {0};
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER count;
+    QueryPerformanceCounter(&count);
+    return (long long)((double)count.QuadPart * 1.0e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+
+}
+
+// CPU time consumed so far by the calling thread [nsec]
+long long getThreadCpuTimeNs(void) {
+
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;  k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;    u.HighPart = user.dwHighDateTime;
+    return (long long)(k.QuadPart + u.QuadPart) * 100;  // FILETIME units are 100 nsec
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+
+}
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cLoopTimer::cLoopTimer(void)
+    : m_periodNs((long long)(defaultPeriod * 1.0e9)),
+      m_spinNs((long long)(defaultSpin * 1.0e3)),
+      m_nextDeadlineNs(0),
+      m_started(false),
+      m_reportStartNs(0),
+      m_reportStartCpuNs(0),
+      m_cpuLoad(0.0),
+      m_missedDeadlines(0)
+{
+#ifdef _WIN32
+    // prefer a high-resolution waitable timer (Windows 10+), otherwise raise the scheduler resolution
+    m_waitableTimer = CreateWaitableTimerEx(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (m_waitableTimer == NULL) {
+        timeBeginPeriod(1);
+        m_waitableTimer = CreateWaitableTimer(NULL, TRUE, NULL);
+    }
+#endif
+}
+
+//===========================================================================
+// Destructor
+//===========================================================================
+cLoopTimer::~cLoopTimer(void)
+{
+#ifdef _WIN32
+    if (m_waitableTimer != NULL) CloseHandle(m_waitableTimer);
+#endif
+}
+
+// set the loop period [sec]
+void cLoopTimer::setPeriodSeconds(double a_period) {
+
+    m_periodNs.store((long long)(a_period * 1.0e9));
+
+}
+
+// get the loop period [sec]
+double cLoopTimer::getPeriodSeconds(void) const {
+
+    return (double)m_periodNs.load() * 1.0e-9;
+
+}
+
+// set the spin-wait window before each deadline [usec]
+void cLoopTimer::setSpinThresholdMicroseconds(double a_spin) {
+
+    m_spinNs = (long long)(a_spin * 1.0e3);
+
+}
+
+// (re)start the schedule, with the first deadline one period from now
+void cLoopTimer::start(void) {
+
+    m_nextDeadlineNs = getMonotonicTimeNs() + m_periodNs.load();
+    m_started = true;
+
+}
+
+// block until the next deadline
+bool cLoopTimer::waitForNextPeriod(void) {
+
+    if (!m_started) start();
+
+    long long now = getMonotonicTimeNs();
+    long long period = m_periodNs.load();
+    bool onTime = true;
+
+    if (now > m_nextDeadlineNs + period) {
+
+        // more than a full period late (e.g., the loop body stalled), so re-align instead of bursting to catch up
+        onTime = false;
+        m_missedDeadlines.fetch_add(1);
+        m_nextDeadlineNs = now;
+
+    } else {
+
+        if (now > m_nextDeadlineNs) {
+            onTime = false;
+            m_missedDeadlines.fetch_add(1);
+        }
+
+        // sleep until just before the deadline, then spin the rest of the way
+        if (m_nextDeadlineNs - now > m_spinNs) sleepUntil(m_nextDeadlineNs - m_spinNs);
+        while ((now = getMonotonicTimeNs()) < m_nextDeadlineNs) {}
+    }
+
+    m_nextDeadlineNs += period;
+    updateCpuLoad(now);
+
+    return onTime;
+
+}
+
+// block until an absolute time (e.g., for an irregular schedule such as replayed input)
+bool cLoopTimer::waitUntil(long long a_deadlineNs) {
+
+    long long now = getMonotonicTimeNs();
+    if (now >= a_deadlineNs) return false;
+    if (a_deadlineNs - now > m_spinNs) sleepUntil(a_deadlineNs - m_spinNs);
+    while (getMonotonicTimeNs() < a_deadlineNs) {}
+    return true;
+
+}
+
+// sleep (without spinning) until shortly before a_deadlineNs
+void cLoopTimer::sleepUntil(long long a_deadlineNs) {
+
+#ifdef _WIN32
+    // waitable timers only take relative (or wall-clock) due times, so convert from the absolute deadline
+    long long remaining = a_deadlineNs - getMonotonicTimeNs();
+    if (remaining <= 0) return;
+    if (m_waitableTimer != NULL) {
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -(remaining / 100);  // negative = relative, in 100 nsec units
+        if (SetWaitableTimer(m_waitableTimer, &dueTime, 0, NULL, NULL, FALSE)) {
+            WaitForSingleObject(m_waitableTimer, INFINITE);
+            return;
+        }
+    }
+    Sleep((DWORD)(remaining / 1000000));
+#else
+    struct timespec ts;
+    ts.tv_sec = (time_t)(a_deadlineNs / 1000000000LL);
+    ts.tv_nsec = (long)(a_deadlineNs % 1000000000LL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+#endif
+
+}
+
+// update the CPU load measurement (called from the looping thread)
+void cLoopTimer::updateCpuLoad(long long a_nowNs) {
+
+    if (m_reportStartNs == 0) {
+        m_reportStartNs = a_nowNs;
+        m_reportStartCpuNs = getThreadCpuTimeNs();
+        return;
+    }
+
+    long long elapsed = a_nowNs - m_reportStartNs;
+    if (elapsed >= reportInterval) {
+        long long cpu = getThreadCpuTimeNs();
+        m_cpuLoad.store((double)(cpu - m_reportStartCpuNs) / (double)elapsed);
+        m_reportStartNs = a_nowNs;
+        m_reportStartCpuNs = cpu;
+    }
+
+}
+
+// fraction of one core used by the looping thread over the last report interval
+double cLoopTimer::getCpuLoad(void) const {
+
+    return m_cpuLoad.load();
+
+}
+
+// number of deadlines that had already passed when waitForNextPeriod() was called
+unsigned long cLoopTimer::getMissedDeadlines(void) const {
+
+    return m_missedDeadlines.load();
+
+}
@@ -12,25 +12,25 @@
  *                                 INCLUDES                                    *
  ******************************************************************************/
 #include "cNeuroTouch.h"
-#include "cbw.h"
+#include "cDiagLog.h"
+#include "cSimulatedHardware.h"
+#ifdef NIDAQ_ACTIVE
 #include "NIDAQcommands.h"
-#include "NIDAQmx.h"
+#endif
 
 #define ACTIVATE_SS_DEVICE
 
-// Define the PCI board that will be used 
-//#define DEBUG_PRINTF
-//#define SENSORAY_ACTIVE
-#define QUAD04_ACTIVE
-#define NIDAQ_ACTIVE
+// NOTE: the PCI boards that will be used (SENSORAY_ACTIVE, QUAD04_ACTIVE, NIDAQ_ACTIVE) are defined in cHardwareInterface.h,
+// and the board-specific code lives in cHardwareInterface.cpp
 
 
 /*******************************************************************************
  *                            PRIVATE #DEFINES                                 *
  ******************************************************************************/	
-//#define DEBUG_PRINTF // Debug print flag, when defined, print statements allowed
+// (debug messages are DIAG_DEBUG; build with DIAG_MIN_LEVEL=DIAG_LEVEL_DEBUG to see them)
 
 // DLL for the PCI Express card: S626 //
+#ifdef SENSORAY_ACTIVE
 #ifndef DLLVERSIONINFO
 typedef struct _DllVersionInfo
 {
@@ -45,6 +45,7 @@ typedef struct _DllVersionInfo
 #ifndef DLLGETVERSIONPROC
 typedef int (FAR WINAPI *DLLGETVERSIONPROC) (DLLVERSIONINFO *);
 #endif
+#endif // SENSORAY_ACTIVE
 //-------------------------- END OF PRIVATE DEFINES ----------------------------
 
 
@@ -53,31 +54,10 @@ typedef int (FAR WINAPI *DLLGETVERSIONPROC) (DLLVERSIONINFO *);
  *******************************************************************************/
 
 /***************** Sensoray Defines *****************/
+#ifdef SENSORAY_ACTIVE
 // PCI Board Definitions //
 const unsigned int board = 0; // the board handle number (if single, 0)
-
-/***************** QUAD04 Defines *******************/
-const unsigned int QUAD04_board_num = 0; // Define the board number to be zero as defined by InstaCal
-const unsigned int Encoder_A = 1;		 // Encoder A maps to P1 on QUAD04 pinout
-const unsigned int Encoder_B = 2;		 // Encoder B maps to P2 on QUAD04 pinout
-unsigned int ULStat = 0;				 // Error return variable for QUAD04 operation
-double LoadValue = 100000;					 // load value to deduct from counts of encoder
-
-/***************** NIDAQ Defines *******************/
-int MotorA_ChannelNum = 0;  	// channel 0 dedicated to voltage output for motor A ref input, AO 0 --> pin 15
-int MotorB_ChannelNum = 1;	// channel 1 for voltage output for motor B ref input, AO 1 --> pin 31
-double MAX_DAC_VALUE = 65536;				// based on 16-bit DAC resolution
-unsigned int MAX_DAC_VOLTAGE =	10;			// Maximum voltage that can possibly be output by the DAC
-float DAC_VOLTAGE_STEP = (MAX_DAC_VOLTAGE / MAX_DAC_VALUE); // The discrete voltage step of the DAC
-
-unsigned int MAX_LIMIT_NIDAQ_VOLTAGE_OUT = 5;	 	// Maximum voltage limit (user defined), AMC amplifiers configured for 5v operation
-float MAX_LIMIT_AD_VALUE = (MAX_LIMIT_NIDAQ_VOLTAGE_OUT / DAC_VOLTAGE_STEP);	 	// The maximum AD value that the DAC can output based on user defined output voltage limit
-float VOLTAGE_TO_AD_CONVERSION = (MAX_LIMIT_AD_VALUE / MAX_LIMIT_NIDAQ_VOLTAGE_OUT); // conversion factor to be used to translate a desired voltage to the analog value
-
-
-// Encoder Variables //
-static double zeroEncoderParamA = 0; // This should be subtracted from the raw encoder value to zero for Motor A
-static double zeroEncoderParamB = 0; // "	"	"	"	"	"	
+#endif
 
 // Jacobian Defines for Force-Torque relationship //
 static float Jacobian[2][2] =
@@ -108,6 +88,7 @@ static float Vout_max_10			 = 10;							// maximum allowed output voltage from t
 
 
 // Poll List for ADC setup //
+#ifdef SENSORAY_ACTIVE
 BYTE poll_list[2] = 
 	{
 		{1 | RANGE_5V},			// Channel 1, Limit input range of 5v( ON PIN 6 and 5 J1)--> Current Monitor Pin on Driver Board
@@ -115,6 +96,7 @@ BYTE poll_list[2] =
 	};
 
 SHORT databuf[16]; // Buffer to recieve the data returned from an A/D read
+#endif // SENSORAY_ACTIVE
 
 
 // Module level variables for Query Functions
@@ -133,9 +115,6 @@ static float Timestamp  = 0;  // Time_Stamp
 //--------------------------------- END OF PRIVATE VARIABLES ----------------
 
 
-// Define Object staticalls such that the contents can be reached from the module
-static NIDAQcommands* DAQcommands = new NIDAQcommands();
-
 /*******************************************************************************
  *							PRIVATE FUNCTIONS                                  *
  ******************************************************************************/
@@ -143,9 +122,12 @@ static NIDAQcommands* DAQcommands = new NIDAQcommands();
 //===========================================================================
 // Constructor
 //===========================================================================
-cNeuroTouch::cNeuroTouch(unsigned int a_deviceNumber)
+cNeuroTouch::cNeuroTouch(unsigned int a_deviceNumber, int a_backend)
 {
 	m_deviceID = a_deviceNumber;
+	m_backend = a_backend;
+	m_encoders = NULL;
+	m_motors = NULL;
 }
 
 //===========================================================================
@@ -153,7 +135,11 @@ cNeuroTouch::cNeuroTouch(unsigned int a_deviceNumber)
 //===========================================================================
 cNeuroTouch::~cNeuroTouch()
 {
-	this->setForce(0,0);
+	if (m_motors != NULL) this->setForce(0,0);
+
+	// a single board (or the simulation) may implement both backends, so only delete it once
+	if (dynamic_cast<void*>(m_encoders) != dynamic_cast<void*>(m_motors)) delete m_encoders;
+	delete m_motors;
 }
 
 
@@ -174,9 +160,10 @@ cNeuroTouch::~cNeuroTouch()
      Integer (O exit fine, 1 error)
 
  Description
-    Opens connection to the Sensoray S626 board.
-	Configures the left and right motors' counters on the S626 to read
-	quadrature encoder signals. 
+    Creates the encoder and motor backends (real boards or simulation, as
+	chosen when the device was constructed) and opens them. For the boards,
+	this configures the left and right motors' counters to read quadrature
+	encoder signals and prepares the DACs driving the amplifiers.
 
  Notes
      To activate the NeuroTouch, must define ACTIVATE_SS_DEVICE in header.
@@ -194,101 +181,28 @@ cNeuroTouch::~cNeuroTouch()
 int cNeuroTouch::open()
 {
 #ifdef ACTIVATE_SS_DEVICE //defined in header file
-	
-	#ifdef SENSORAY_ACTIVE
-		// load the .dll
-		S626_DLLOpen();
-		#ifdef DEBUG_PRINTF
-			std::cout << "OPENED DLL\n\n";
-		#endif
-
-		// open the 626 card
-		S626_OpenBoard(0,0,0,0);
-		#ifdef DEBUG_PRINTF
-			std::cout << "OPENED Board 626\n\n";
-		#endif
-
-		//check for any errors in opening board
-		if (S626_GetErrors(0) != 0){
-			std::cout << "ERROR IN OPENING BOARD\n\n";
-			return S626_GetErrors(0);
-		}
-
-
-		// Encoder Configurations //
-
-		/**************** MOTOR A ******************/
-		// Set counter operating mode.
-		S626_CounterModeSet( 0, CNTR_0A , // set counter for channel 0A
-		( INDXSRC_SOFT << BF_INDXSRC )	|
-		( INDXPOL_POS << BF_INDXPOL )	| // Active high index.
-		( CLKSRC_COUNTER << BF_CLKSRC ) | // Operating mode is Counter.
-		( CLKPOL_POS << BF_CLKPOL )		| // Active high clock.
-		( CLKMULT_4X << BF_CLKMULT )	| // Clock multiplier is 4x.
-		( CLKENAB_ALWAYS << BF_CLKENAB ) ); // Counting is always enabled.
-
-		// Initialize preload value to zero so that the counter core will be set
-		// to zero upon the occurance of an Index.
-		S626_CounterPreload( 0, CNTR_0A, 0 );
-
-		// Enable latching of accumulated counts on demand. This assumes that
-		// there is no conflict with the latch source used by paired counter 2B.
-		S626_CounterLatchSourceSet( 0, CNTR_0A, LATCHSRC_AB_READ );
-
-		// Enable the counter to generate interrupt requests upon index.
-		S626_CounterIntSourceSet( 0, CNTR_0A, INTSRC_INDX );
-
-		// Simulate Index Pulse to reset count at 0 on startup
-		S626_CounterSoftIndex(0, CNTR_0A);
-
-
-		/**************** MOTOR B *******************/
-		// Set counter operating mode.
-		S626_CounterModeSet( 0, CNTR_1A,	// set counter for channel 1A
-		( INDXSRC_SOFT << BF_INDXSRC )	|
-		( INDXPOL_POS << BF_INDXPOL )	|	// Active high index.
-		( CLKSRC_COUNTER << BF_CLKSRC ) |	// Operating mode is Counter.
-		( CLKPOL_POS << BF_CLKPOL )		|	// Active high clock.
-		( CLKMULT_4X << BF_CLKMULT )	|	// Clock multiplier is 4x.
-		( CLKENAB_ALWAYS << BF_CLKENAB ) ); // Counting is always enabled.
-
-		// Initialize preload value to zero so that the counter core will be set
-		// to zero upon the occurance of an Index.
-		S626_CounterPreload( 0, CNTR_1A, 0 );
-
-		// Enable latching of accumulated counts on demand. This assumes that
-		// there is no conflict with the latch source used by paired counter 2B.
-		S626_CounterLatchSourceSet( 0, CNTR_1A, LATCHSRC_AB_READ );
-
-		// Enable the counter to generate interrupt requests upon index.
-		S626_CounterIntSourceSet( 0, CNTR_1A, INTSRC_INDX );
-
-		// Simulate Index Pulse to reset count at 0 on startup
-		S626_CounterSoftIndex(0, CNTR_1A);
-	
-	#endif // SENSORAY_ACTIVE
-
-	#ifdef QUAD04_ACTIVE
-		// Configure quadrature encoder board
-		ULStat = cbC7266Config (QUAD04_board_num, Encoder_A, X4_QUAD, NORMAL_MODE, 
-								BINARY_ENCODING, INDEX_DISABLED, DISABLED, CARRY_BORROW, DISABLED);
-
-		// Configure quadrature encoder board
-		ULStat = cbC7266Config (QUAD04_board_num, Encoder_B, X4_QUAD, NORMAL_MODE, 
-								BINARY_ENCODING, INDEX_DISABLED, DISABLED, CARRY_BORROW, DISABLED);
-								
-
-		// Initialize the quadrature board ( From Hopkins code ) 
-		//LoadValue = 100000; // This is the rollover counter value
-		ULStat = cbCLoad32 (QUAD04_board_num, COUNT1, LoadValue);
-		ULStat = cbCLoad32 (QUAD04_board_num, COUNT2, LoadValue);
-		
-		// Define prescaler for Counter 1 and 2
-		ULStat = cbCLoad(QUAD04_board_num, PRESCALER1, 1);
-		ULStat = cbCLoad(QUAD04_board_num, PRESCALER2, 1);
-
-	#endif // QUAD04_ACTIVE
-	
+
+	// create the encoder and motor backends on first use
+	if (m_encoders == NULL || m_motors == NULL) {
+		if (!createNeuroTouchBackends(m_backend, m_encoders, m_motors)) return 1;
+
+		// the simulated device needs the kinematics to report contact force to a simulated sensor
+		cSimulatedNeuroTouch* sim = dynamic_cast<cSimulatedNeuroTouch*>(m_motors);
+		if (sim != NULL) sim->setJacobianTranspose(Jacobian_Transpose);
+	}
+
+	// configure the encoder counters and the amplifier outputs
+	int status = m_encoders->openEncoders();
+	if (status != 0) {
+		std::cout << "ERROR IN OPENING ENCODERS\n\n";
+		return status;
+	}
+	status = m_motors->openMotors();
+	if (status != 0) {
+		std::cout << "ERROR IN OPENING MOTOR OUTPUTS\n\n";
+		return status;
+	}
+
 #endif // ACTIVATE_SS_DEVICE
 
     return 0;
@@ -308,9 +222,8 @@ int cNeuroTouch::open()
      Integer (O exit fine, 1 error)
 
  Description
-    Closes connection to the Sensoray S626 board.
-	Unregisters Board number 0 after programming analog and digital outputs
-	to their application-defined shut-down states
+    Closes the encoder and motor backends, programming the amplifier
+	outputs to zero volts first.
 
  Notes
      Sets the motor forces to zero, should also disable any force sensors.
@@ -323,19 +236,8 @@ int cNeuroTouch::close()
 {
 #ifdef ACTIVATE_SS_DEVICE
 	
-	#ifdef SENSORAY_ACTIVE
-		// Program all analog outputs to zero volts.
-		for ( WORD DacChan = 0; DacChan < 4; S626_WriteDAC( 0, DacChan++, 0 ));
-	
-		// Program all digital outputs to the inactive state.
-		for ( WORD Group = 0; Group < 3; S626_DIOWriteBankSet( 0, Group++, 0 ));
-	
-		// Unregister the board and release its handle.
-		S626_CloseBoard( 0 );
-
-		// close the DLL
-		S626_DLLClose();
-	#endif // SENSORAY_ACTIVE
+	if (m_motors != NULL)   m_motors->closeMotors();
+	if (m_encoders != NULL) m_encoders->closeEncoders();
     
 #endif // ACTIVATE_SS_DEVICE
 	return 0;
@@ -368,67 +270,18 @@ int cNeuroTouch::getPosition(float& a_position, float& b_position)
 {
 #ifdef ACTIVATE_SS_DEVICE
     
-	#ifdef SENSORAY_ACTIVE
-		// Read in value from Encoder for Motor A and B
-		unsigned long EncoderRawA = S626_CounterReadLatch(0, CNTR_0A); // Motor A
-		unsigned long EncoderRawB = S626_CounterReadLatch(0, CNTR_1A); // Motor B
-
-		// Change the raw encoder count into a double and center the total count 
-		// around 0
-		double EncoderPosA = 0;
-		if (EncoderRawA < ((MAX_COUNT+1)/2)){ // If the encoder count hasn't gone in the negative direction
-			EncoderPosA = EncoderRawA; //set the raw encoder value to PosA
-		
-		}
-		else if (EncoderRawA >= ((MAX_COUNT+1)/2)){ // If the encoder count has gone negative
-			EncoderPosA = -MAX_COUNT+1+(double)EncoderRawA; // account for negative angle by subtracting from Maxcount
-		}
-	
-		// Repeat for Motor B
-		double EncoderPosB = 0;
-		if (EncoderRawB < ((MAX_COUNT+1)/2))
-			EncoderPosB = EncoderRawB;
-		else if (EncoderRawB >= ((MAX_COUNT+1)/2))
-			EncoderPosB = -MAX_COUNT+1+(double)EncoderRawB;
-	
-		/*
-		// Return encoder position as a double in radian
-		a_position = EncoderPosA * ENCCOUNT_TO_RAD;
-		b_position = EncoderPosB * ENCCOUNT_TO_RAD;
-		*/
-
-		// Or Return encoder position as a double in degrees
-		a_position = EncoderPosA * ENCCOUNT_TO_DEG - zeroEncoderParamA;
-		b_position = EncoderPosB * ENCCOUNT_TO_DEG - zeroEncoderParamB;
-
-		// Debug 
-		#ifdef DEBUG_PRINTF
-			printf("RAW A: %d   RAW B: %d\n",EncoderRawA, EncoderRawB);	
-			printf("Encoder PosA : %f      PosB: %f\n\n",a_position, b_position);
-		#endif
-	#endif // SENSORAY_ACTIVE
-
-	#ifdef QUAD04_ACTIVE
-		// obtain the readings for encoder A and B
-		//define variables to store the encoder values into
-		unsigned long Encoder_A_tics = 0;
-		unsigned long Encoder_B_tics = 0; 
-
-		//request the encoder tick count from the QUAD04
-		ULStat = cbCIn32(QUAD04_board_num, Encoder_A, &Encoder_A_tics);
-		ULStat = cbCIn32(QUAD04_board_num, Encoder_B, &Encoder_B_tics);
-		
-		// convert to degrees
-		float curposA = Encoder_A_tics - LoadValue; // subtract the loadvalue variable from the accumulated encoder tics
-		float curposA_deg = (curposA / ENC_CNT_PER_REV)*180;		// Divide the actual encoder tick amount by the counts per revolution of the encoder (1024) and convert to degrees by multiplying by 180
-
-		float curposB = Encoder_B_tics - LoadValue; // subtract the loadvalue variable from the accumulated encoder tics
-		float curposB_deg = (curposB / ENC_CNT_PER_REV)*180;		// Divide the actual encoder tick amount by the counts per revolution of the encoder (1024) and convert to degrees by multiplying by 180
-		
-		// set the return values
-		a_position = curposA_deg;
-		b_position = curposB_deg;
-	#endif // QUAD04_ACTIVE
+	if (m_encoders == NULL) {
+		a_position = 0;
+		b_position = 0;
+		return 1;
+	}
+
+	int status = m_encoders->readEncoders(a_position, b_position);
+
+	// Debug 
+	DIAG_DEBUG("Encoder PosA : %f      PosB: %f", a_position, b_position);
+
+	return status;
 
 #else // If the NeuroTouch device is not defined
     a_position = 0;
@@ -485,59 +338,20 @@ int cNeuroTouch::setForce(const double& x_force, const double& y_force)
 		float Torque_Motor_A = (Torque_Capstan_A/GearRatio);
 		float Torque_Motor_B = (Torque_Capstan_B/GearRatio);
 	  
-	#ifdef SENSORAY_ACTIVE
-		// based on the ratio of the desired torque and the maximum torque that can be output, scale the command voltage to the 
-		// amplifier appropriately
+		// Based on the ratio of the desired torque and the maximum torque that can be output, scale the command voltage to the
+		// amplifier appropriately (the backend limits it to what its DAC can safely output)
 		VoltOutA = Vout_max_5*(Torque_Motor_A / Torque_max_motor);
 		VoltOutB = Vout_max_5*(Torque_Motor_B / Torque_max_motor);
 
-		// Check to make sure the voltage does not exceed the range of 5 volts
-		if(VoltOutA > 5) VoltOutA = 5;
-		if(VoltOutB > 5) VoltOutB = 5;
-
-		if(VoltOutA < -5) VoltOutA = -5;
-		if(VoltOutB < -5) VoltOutB = -5;
-
-
-		// Write the voltages out to the DAC
-		S626_WriteDAC(board, DAC1, VoltOutA*DAC_VSCALAR); // Write the MotorA voltage out to DAC1 Motor A
-		S626_WriteDAC(board, DAC2, VoltOutB*DAC_VSCALAR); // Write the MotorB voltage out to DAC2 Motor B
-	#endif // SENSORAY_ACTIVE 
-
-	#ifdef NIDAQ_ACTIVE
-		// Based on the ratio of the desired torque and the maximum torque that can be output, scale the command voltage to the
-		// amplifier appropriately
-		VoltOutA = MAX_LIMIT_NIDAQ_VOLTAGE_OUT* (Torque_Motor_A / Torque_max_motor);
-		VoltOutB = MAX_LIMIT_NIDAQ_VOLTAGE_OUT* (Torque_Motor_B / Torque_max_motor);
-
-	
-		// It turns out that you can write the voltage that you desire out to analogA and analogB
-		// I.E. for 3.2 volts out for motor A you call writeAnalogOutput(Channel, 3.2)
-		float AnalogA = VoltOutA;
-		float AnalogB = VoltOutB;
-
-
-		// Error check to make sure command signal stays within bounds 
-
-		
-		if(AnalogA > MAX_LIMIT_AD_VALUE) AnalogA = MAX_LIMIT_AD_VALUE;
-		if(AnalogB > MAX_LIMIT_AD_VALUE) AnalogB = MAX_LIMIT_AD_VALUE;
-
-
-		// Write the analog out value to the NIDAQ
-		DAQcommands->writeAnalogOutput(MotorA_ChannelNum, AnalogA);
-		DAQcommands->writeAnalogOutput(MotorB_ChannelNum, AnalogB);
-	#endif // NIDAQ_ACTIVE
+		if (m_motors != NULL) m_motors->writeVoltages(VoltOutA, VoltOutB);
 
 #endif // ACTIVATE_SS_DEVICE
 
 	//Debug Prints
-	#ifdef DEBUG_PRINTF
-		printf("DESIRED X FORCE: %f			DESIRED Y FORCE: %f\n",(float)x_force, (float)y_force);
-		printf("CAP TORQUE A :   %f			CAP TORQUE B :   %f\n",Torque_Capstan_A, Torque_Capstan_B);
-		printf("MOTORA TORQUE:   %f			MOTORB TORQUE:   %f\n",Torque_Motor_A, Torque_Motor_B);
-		printf("VOLT OUT A:      %f			VOLT OUT B:      %f\n", VoltOutA, VoltOutB);
-	#endif
+	DIAG_DEBUG("DESIRED X FORCE: %f			DESIRED Y FORCE: %f", x_force, y_force);
+	DIAG_DEBUG("CAP TORQUE A :   %f			CAP TORQUE B :   %f", Torque_Capstan_A, Torque_Capstan_B);
+	DIAG_DEBUG("MOTORA TORQUE:   %f			MOTORB TORQUE:   %f", Torque_Motor_A, Torque_Motor_B);
+	DIAG_DEBUG("VOLT OUT A:      %f			VOLT OUT B:      %f", VoltOutA, VoltOutB);
 
 	// Update module level variables for use with query functions
 	 Torque_MA = Torque_Motor_A; // Motor A Torque last commanded
@@ -586,53 +400,10 @@ int cNeuroTouch::setForce(const double& x_force, const double& y_force)
  ****************************************************************************/
 int cNeuroTouch::zeroEncoders(void)
 {
-#ifdef SENSORAY_ACTIVE
-	// obtain the current value of the encoders at this point and store them in the variable zeroEncoderParam
-    unsigned long EncoderRaw = S626_CounterReadLatch(0, CNTR_0A);
-	
-	// store into module level variable 
-	if (EncoderRaw < ((MAX_COUNT+1)/2)){ // if the current angle is positive
-		zeroEncoderParamA = EncoderRaw;
-		
-	}
-	else if (EncoderRaw >= ((MAX_COUNT+1)/2)) // if the current angle is negative
-		zeroEncoderParamA = -MAX_COUNT+1+(double)EncoderRaw;
-
+	if (m_encoders == NULL) return 1;
 
-	// Repeat for Motor B
-	unsigned long EncoderRawB = S626_CounterReadLatch(0, CNTR_1A);
-
-	// store into module level variable 
-	if (EncoderRawB < ((MAX_COUNT+1)/2)){
-		zeroEncoderParamB = EncoderRawB;
-		
-	}
-	else if (EncoderRawB >= ((MAX_COUNT+1)/2))
-		zeroEncoderParamB = -MAX_COUNT+1+(double)EncoderRawB;
-
-
-	// Convert to degress using conversion factor
-	zeroEncoderParamB = zeroEncoderParamB * ENCCOUNT_TO_DEG;
-	zeroEncoderParamA = zeroEncoderParamA * ENCCOUNT_TO_DEG;
-
-	//Debug
-	#ifdef DEBUG_PRINTF
-		printf("Raw A %d, Raw B %d  \n\n",EncoderRaw, EncoderRawB);
-	#endif
-#endif // SENSORAY_ACTIVE
-
-#ifdef QUAD04_ACTIVE
-		//Re-Initialize the quadrature board to zero the encoders ( From Hopkins code ) 
-		LoadValue = 100000;
-		ULStat = cbCLoad32 (QUAD04_board_num, COUNT1, LoadValue);
-		ULStat = cbCLoad32 (QUAD04_board_num, COUNT2, LoadValue);
-		
-		// Prescaler definitions
-		ULStat = cbCLoad(QUAD04_board_num, PRESCALER1, 1);
-		ULStat = cbCLoad(QUAD04_board_num, PRESCALER2, 1);
-#endif // QUAD04_ACTIVE
-
-	return 0;
+	// the backend stores (or reloads) whatever it needs so the current angles read as zero
+	return m_encoders->zeroEncoders();
 }
 
 
@@ -730,8 +501,9 @@ int cNeuroTouch::testHarnessADC(void)
 
 #ifdef NIDAQ_ACTIVE
 	//command 5 volts to the reference input 
-	DAQcommands->writeAnalogOutput(MotorA_ChannelNum,0); 
-	DAQcommands->writeAnalogOutput(MotorB_ChannelNum,2.5); 
+	NIDAQcommands DAQcommands;
+	DAQcommands.writeAnalogOutput(0,0);   // motor A, AO 0 --> pin 15
+	DAQcommands.writeAnalogOutput(1,2.5); // motor B, AO 1 --> pin 31
 
 	// Define the current monitor pin channels
 	int curr_monitor_A_channel = 0; // Pin 1 --> AI 0+
@@ -739,7 +511,7 @@ int cNeuroTouch::testHarnessADC(void)
 
 	for(;;){
 		// obtain the contents of AD port pin for current monitor 
-		double val = DAQcommands->readAnalogInput(curr_monitor_A_channel);
+		double val = DAQcommands.readAnalogInput(curr_monitor_A_channel);
 
 		//print the value to stdout using the 2.2A/V conversion factor for the 12A8
 		printf("Current Output for Channel B is          :             %f\r\n\n", (float)val*(2.2));
@@ -0,0 +1,511 @@
+#include "cSessionLog.h"
+#include <string.h>
+#include <stdint.h>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+
+static const size_t fixedHeaderSize = 8 + 4 * 4 + 8;  // magic + version, header size, record size, number of fields + record count
+static const size_t fixedHeaderSizeV1 = 8 + 4 * 4;    // (version 1 had no record count)
+static const size_t countOffset = 24;                 // position of the record count (8-byte aligned, so a mapped log can update it in one store)
+
+
+// true on little-endian hosts (records are stored little-endian, so nothing is swapped there)
+static bool hostIsLittleEndian(void) {
+
+    const uint16_t one = 1;
+    return *(const unsigned char*)&one == 1;
+
+}
+static const bool littleEndian = hostIsLittleEndian();
+
+// copy one value, converting between host and little-endian byte order (NOTE: fixed-size copies compile to single moves)
+static inline void copyLittleEndian(unsigned char* a_to, const unsigned char* a_from, size_t a_size) {
+
+    if (littleEndian) {
+        if (a_size == 8)      memcpy(a_to, a_from, 8);
+        else if (a_size == 4) memcpy(a_to, a_from, 4);
+        else                  memcpy(a_to, a_from, a_size);
+    }
+    else for (size_t i = 0; i < a_size; i++) a_to[i] = a_from[a_size - 1 - i];
+
+}
+
+static void putUint32(unsigned char* a_to, uint32_t a_value) {
+
+    for (int i = 0; i < 4; i++) a_to[i] = (unsigned char)(a_value >> (8 * i));
+
+}
+
+static uint32_t getUint32(const unsigned char* a_from) {
+
+    return (uint32_t)a_from[0] | ((uint32_t)a_from[1] << 8) | ((uint32_t)a_from[2] << 16) | ((uint32_t)a_from[3] << 24);
+
+}
+
+static void putUint64(unsigned char* a_to, uint64_t a_value) {
+
+    for (int i = 0; i < 8; i++) a_to[i] = (unsigned char)(a_value >> (8 * i));
+
+}
+
+static uint64_t getUint64(const unsigned char* a_from) {
+
+    return (uint64_t)getUint32(a_from) | ((uint64_t)getUint32(a_from + 4) << 32);
+
+}
+
+size_t logTypeSize(int a_type) {
+
+    switch (a_type) {
+        case LOG_INT32:   return 4;
+        case LOG_BOOL:    return 1;
+        case LOG_FLOAT32: return 4;
+        case LOG_FLOAT64: return 8;
+    }
+    return 0;
+
+}
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cSessionLogWriter::cSessionLogWriter(void)
+{
+    m_numFields = 0;
+    m_recordSize = 0;
+    m_file = NULL;
+    m_chunk = NULL;
+    m_chunkUsed = 0;
+    m_mapping = NULL;
+    m_headerSize = 0;
+    m_capacity = 0;
+    m_dropped = 0;
+#ifdef _WIN32
+    m_fileHandle = INVALID_HANDLE_VALUE;
+    m_mapHandle = NULL;
+#else
+    m_fd = -1;
+#endif
+    m_records.store(0);
+    m_syncBusy.store(false);
+}
+
+cSessionLogWriter::~cSessionLogWriter(void)
+{
+    close();
+    delete[] m_chunk;
+}
+
+// append a field to the schema
+bool cSessionLogWriter::addField(const char* a_name, const char* a_unit, int a_type, size_t a_sourceOffset) {
+
+    size_t size = logTypeSize(a_type);
+    if (isOpen() || m_numFields >= LOG_MAX_FIELDS || size == 0) return false;
+    if (strlen(a_name) >= LOG_NAME_LENGTH || strlen(a_unit) >= LOG_UNIT_LENGTH) return false;
+
+    log_field& field = m_fields[m_numFields++];
+    strcpy(field.name, a_name);
+    strcpy(field.unit, a_unit);
+    field.type = a_type;
+    field.size = size;
+    field.recordOffset = m_recordSize;
+    field.sourceOffset = a_sourceOffset;
+    m_recordSize += size;
+    return true;
+
+}
+
+// build the header in the chunk
+size_t cSessionLogWriter::buildHeader(const char* a_info) {
+
+    size_t infoLength = strlen(a_info);
+    if (infoLength >= LOG_INFO_LENGTH) infoLength = LOG_INFO_LENGTH - 1;
+    unsigned char* p = m_chunk + fixedHeaderSize;
+    for (int i = 0; i < m_numFields; i++) {
+        size_t nameLength = strlen(m_fields[i].name);
+        size_t unitLength = strlen(m_fields[i].unit);
+        *p++ = (unsigned char)m_fields[i].type;
+        *p++ = (unsigned char)nameLength;
+        *p++ = (unsigned char)unitLength;
+        memcpy(p, m_fields[i].name, nameLength);  p += nameLength;
+        memcpy(p, m_fields[i].unit, unitLength);  p += unitLength;
+    }
+    *p++ = (unsigned char)(infoLength & 0xFF);
+    *p++ = (unsigned char)(infoLength >> 8);
+    memcpy(p, a_info, infoLength);  p += infoLength;
+    size_t headerSize = p - m_chunk;
+
+    memcpy(m_chunk, LOG_MAGIC, 8);
+    putUint32(m_chunk + 8, LOG_VERSION);
+    putUint32(m_chunk + 12, (uint32_t)headerSize);
+    putUint32(m_chunk + 16, (uint32_t)m_recordSize);
+    putUint32(m_chunk + 20, (uint32_t)m_numFields);
+    putUint64(m_chunk + countOffset, LOG_COUNT_UNKNOWN);
+    return headerSize;
+
+}
+
+// create a log file and write its header
+bool cSessionLogWriter::open(const char* a_filename, const char* a_info, size_t a_mappedRecords) {
+
+    close();
+    if (m_numFields == 0 || m_recordSize > LOG_CHUNK_BYTES) return false;
+
+    // the chunk is allocated once and reused for every file
+    if (m_chunk == NULL) m_chunk = new unsigned char[LOG_CHUNK_BYTES]();
+    m_chunkUsed = 0;
+    m_dropped = 0;
+    m_records.store(0);
+    size_t headerSize = buildHeader(a_info);
+
+    if (a_mappedRecords > 0) return openMapped(a_filename, headerSize, a_mappedRecords);
+
+    // streamed: write the header in one go
+    m_file = fopen(a_filename, "wb");
+    if (m_file == NULL) return false;
+    if (fwrite(m_chunk, 1, headerSize, m_file) != headerSize) {
+        close();
+        return false;
+    }
+    return true;
+
+}
+
+// create, size, and map a file for a_records records
+bool cSessionLogWriter::openMapped(const char* a_filename, size_t a_headerSize, size_t a_records) {
+
+    size_t size = a_headerSize + a_records * m_recordSize;
+    putUint64(m_chunk + countOffset, 0);
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(a_filename, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    HANDLE map = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+    void* mapping = (map != NULL) ? MapViewOfFile(map, FILE_MAP_WRITE, 0, 0, size) : NULL;
+    if (mapping == NULL) {
+        if (map != NULL) CloseHandle(map);
+        CloseHandle(file);
+        DeleteFileA(a_filename);
+        return false;
+    }
+    m_fileHandle = file;
+    m_mapHandle = map;
+#else
+    int fd = ::open(a_filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    // reserve the blocks now, so running out of disk shows up here rather than as a fault mid-session
+    void* mapping = MAP_FAILED;
+    if (posix_fallocate(fd, 0, (off_t)size) == 0) mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(fd);
+        unlink(a_filename);
+        return false;
+    }
+    m_fd = fd;
+#endif
+
+    m_mapping = (unsigned char*)mapping;
+    m_headerSize = a_headerSize;
+    m_capacity = a_records;
+    memcpy(m_mapping, m_chunk, a_headerSize);
+
+    // get the header to disk, then touch every page (after syncing, since a synced page faults again on its next write)
+    syncMapping();
+    for (size_t i = a_headerSize; i < size; i += 4096) m_mapping[i] = 0;
+    return true;
+
+}
+
+// pack one struct into a record
+void cSessionLogWriter::pack(unsigned char* a_record, const unsigned char* a_source) const {
+
+    for (int i = 0; i < m_numFields; i++) {
+        const log_field& field = m_fields[i];
+        if (field.type == LOG_BOOL) a_record[field.recordOffset] = *(const bool*)(a_source + field.sourceOffset) ? 1 : 0;
+        else copyLittleEndian(a_record + field.recordOffset, a_source + field.sourceOffset, field.size);
+    }
+
+}
+
+// append one struct as a record
+void cSessionLogWriter::append(const void* a_source) {
+
+    unsigned long records = m_records.load(std::memory_order_relaxed);
+
+    // mapped: pack straight into the file, then publish the new count (record first, so a reader never sees a count ahead of the data)
+    if (m_mapping != NULL) {
+        if (records >= m_capacity) {
+            m_dropped++;
+            return;
+        }
+        pack(m_mapping + m_headerSize + records * m_recordSize, (const unsigned char*)a_source);
+        unsigned char bytes[8];
+        uint64_t count;
+        putUint64(bytes, records + 1);
+        memcpy(&count, bytes, 8);
+        std::atomic_thread_fence(std::memory_order_release);
+        *(volatile uint64_t*)(m_mapping + countOffset) = count;
+        m_records.store(records + 1, std::memory_order_release);
+        return;
+    }
+
+    if (m_file == NULL) return;
+    if (m_chunkUsed + m_recordSize > LOG_CHUNK_BYTES) {
+        fwrite(m_chunk, 1, m_chunkUsed, m_file);
+        m_chunkUsed = 0;
+    }
+    pack(m_chunk + m_chunkUsed, (const unsigned char*)a_source);
+    m_chunkUsed += m_recordSize;
+    m_records.store(records + 1, std::memory_order_relaxed);
+
+}
+
+// write buffered records and flush the file
+void cSessionLogWriter::flush(void) {
+
+    if (m_mapping != NULL) {
+        sync();
+        return;
+    }
+    if (m_file == NULL) return;
+    if (m_chunkUsed > 0) fwrite(m_chunk, 1, m_chunkUsed, m_file);
+    m_chunkUsed = 0;
+    fflush(m_file);
+
+}
+
+// write the mapped records to disk (NOTE: the OS only writes pages that changed)
+void cSessionLogWriter::syncMapping(void) {
+
+    size_t used = m_headerSize + m_records.load(std::memory_order_acquire) * m_recordSize;
+#ifdef _WIN32
+    FlushViewOfFile(m_mapping, used);
+    FlushFileBuffers((HANDLE)m_fileHandle);
+#else
+    msync(m_mapping, used, MS_SYNC);
+#endif
+
+}
+
+void cSessionLogWriter::sync(void) {
+
+    // (closeMapped holds the flag while it unmaps, so the mapping cannot go away under us)
+    while (m_syncBusy.exchange(true)) std::this_thread::yield();
+    if (m_mapping != NULL) syncMapping();
+    m_syncBusy.store(false);
+
+}
+
+// unmap a mapped log, trimming it to the records written
+void cSessionLogWriter::closeMapped(void) {
+
+    while (m_syncBusy.exchange(true)) std::this_thread::yield();
+    syncMapping();
+    size_t used = m_headerSize + m_records.load() * m_recordSize;
+#ifdef _WIN32
+    UnmapViewOfFile(m_mapping);
+    CloseHandle((HANDLE)m_mapHandle);
+    LARGE_INTEGER end;
+    end.QuadPart = (LONGLONG)used;
+    if (SetFilePointerEx((HANDLE)m_fileHandle, end, NULL, FILE_BEGIN)) SetEndOfFile((HANDLE)m_fileHandle);
+    CloseHandle((HANDLE)m_fileHandle);
+    m_fileHandle = INVALID_HANDLE_VALUE;
+    m_mapHandle = NULL;
+#else
+    munmap(m_mapping, m_headerSize + m_capacity * m_recordSize);
+    if (ftruncate(m_fd, (off_t)used) != 0) printf("\nUnable to trim session log (it has %lu unused records)\n", (unsigned long)(m_capacity - m_records.load()));
+    ::close(m_fd);
+    m_fd = -1;
+#endif
+    m_mapping = NULL;
+    m_syncBusy.store(false);
+
+}
+
+void cSessionLogWriter::close(void) {
+
+    if (m_mapping != NULL) {
+        closeMapped();
+        return;
+    }
+    if (m_file == NULL) return;
+    flush();
+
+    // now the record count is known
+    unsigned char count[8];
+    putUint64(count, m_records.load());
+    if (fseek(m_file, (long)countOffset, SEEK_SET) == 0) fwrite(count, 1, 8, m_file);
+    fclose(m_file);
+    m_file = NULL;
+
+}
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cSessionLogReader::cSessionLogReader(void)
+{
+    m_numFields = 0;
+    m_recordSize = 0;
+    m_info[0] = '\0';
+    m_count = LOG_COUNT_UNKNOWN;
+    m_read = 0;
+    m_file = NULL;
+    m_record = NULL;
+}
+
+cSessionLogReader::~cSessionLogReader(void)
+{
+    close();
+}
+
+// open a log and read its header
+bool cSessionLogReader::open(const char* a_filename) {
+
+    close();
+    m_file = fopen(a_filename, "rb");
+    if (m_file == NULL) {
+        printf("\nUnable to open %s\n", a_filename);
+        return false;
+    }
+
+    unsigned char fixed[fixedHeaderSize];
+    if (fread(fixed, 1, fixedHeaderSizeV1, m_file) != fixedHeaderSizeV1 || memcmp(fixed, LOG_MAGIC, 8) != 0) {
+        printf("\n%s is not a session log\n", a_filename);
+        close();
+        return false;
+    }
+    uint32_t version = getUint32(fixed + 8);
+    uint32_t headerSize = getUint32(fixed + 12);
+    m_recordSize = getUint32(fixed + 16);
+    uint32_t numFields = getUint32(fixed + 20);
+    size_t fixedSize = (version == 1) ? fixedHeaderSizeV1 : fixedHeaderSize;
+    if (version < 1 || version > LOG_VERSION || numFields == 0 || numFields > LOG_MAX_FIELDS || headerSize < fixedSize) {
+        printf("\n%s: unsupported log (version %u, %u fields)\n", a_filename, (unsigned)version, (unsigned)numFields);
+        close();
+        return false;
+    }
+
+    // record count (as of now, if the log is still being written)
+    m_count = LOG_COUNT_UNKNOWN;
+    m_read = 0;
+    if (version >= 2) {
+        if (fread(fixed + fixedHeaderSizeV1, 1, 8, m_file) != 8) {
+            printf("\n%s: corrupt header\n", a_filename);
+            close();
+            return false;
+        }
+        m_count = getUint64(fixed + countOffset);
+    }
+
+    // field descriptions and session info
+    size_t variableSize = headerSize - fixedSize;
+    unsigned char* header = new unsigned char[variableSize];
+    bool ok = (fread(header, 1, variableSize, m_file) == variableSize);
+    const unsigned char* p = header;
+    const unsigned char* end = header + variableSize;
+    size_t recordOffset = 0;
+    for (uint32_t i = 0; ok && i < numFields; i++) {
+        if (end - p < 3) { ok = false; break; }
+        log_field& field = m_fields[i];
+        field.type = p[0];
+        size_t nameLength = p[1];
+        size_t unitLength = p[2];
+        p += 3;
+        field.size = logTypeSize(field.type);
+        if (field.size == 0 || nameLength >= LOG_NAME_LENGTH || unitLength >= LOG_UNIT_LENGTH || (size_t)(end - p) < nameLength + unitLength) {
+            ok = false;
+            break;
+        }
+        memcpy(field.name, p, nameLength);  field.name[nameLength] = '\0';  p += nameLength;
+        memcpy(field.unit, p, unitLength);  field.unit[unitLength] = '\0';  p += unitLength;
+        field.recordOffset = recordOffset;
+        field.sourceOffset = 0;
+        recordOffset += field.size;
+    }
+    if (ok && end - p >= 2) {
+        size_t infoLength = p[0] | (p[1] << 8);
+        p += 2;
+        if (infoLength >= LOG_INFO_LENGTH || (size_t)(end - p) < infoLength) ok = false;
+        else {
+            memcpy(m_info, p, infoLength);
+            m_info[infoLength] = '\0';
+        }
+    }
+    else ok = false;
+    delete[] header;
+
+    if (!ok || recordOffset != m_recordSize) {
+        printf("\n%s: corrupt header\n", a_filename);
+        close();
+        return false;
+    }
+    m_numFields = numFields;
+    m_record = new unsigned char[m_recordSize];
+    return true;
+
+}
+
+// read the next record
+bool cSessionLogReader::readRecord(void) {
+
+    if (m_file == NULL || m_read >= m_count) return false;
+    if (fread(m_record, 1, m_recordSize, m_file) != m_recordSize) return false;
+    m_read++;
+    return true;
+
+}
+
+void cSessionLogReader::close(void) {
+
+    if (m_file != NULL) fclose(m_file);
+    m_file = NULL;
+    delete[] m_record;
+    m_record = NULL;
+    m_numFields = 0;
+
+}
+
+// value of an integer field in the current record
+long cSessionLogReader::getInteger(int a_index) const {
+
+    const log_field& field = m_fields[a_index];
+    const unsigned char* value = m_record + field.recordOffset;
+    if (field.type == LOG_BOOL) return value[0];
+    if (field.type == LOG_INT32) {
+        int32_t i;
+        copyLittleEndian((unsigned char*)&i, value, 4);
+        return i;
+    }
+    return (long)getDouble(a_index);
+
+}
+
+// value of any field in the current record
+double cSessionLogReader::getDouble(int a_index) const {
+
+    const log_field& field = m_fields[a_index];
+    const unsigned char* value = m_record + field.recordOffset;
+    if (field.type == LOG_FLOAT32) {
+        float f;
+        copyLittleEndian((unsigned char*)&f, value, 4);
+        return f;
+    }
+    if (field.type == LOG_FLOAT64) {
+        double d;
+        copyLittleEndian((unsigned char*)&d, value, 8);
+        return d;
+    }
+    return (double)getInteger(a_index);
+
+}
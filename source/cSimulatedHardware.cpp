@@ -0,0 +1,222 @@
+#include "cSimulatedHardware.h"
+#include <cmath>
+
+
+// actuator (matches the amplifier/motor constants in cNeuroTouch.cpp)
+static const double Kt = 23.2;             // torque constant [mNm/A]
+static const double Kloopgain = 0.22;      // amplifier transconductance [A/V]
+static const double Imax = 1.1;            // amplifier current limit [A]
+static const double GearRatio = 13;        // capstan drive gear ratio
+
+// capstan joint and skin (tuned for ~20 Hz, damping ratio ~0.7, a few degrees of travel at full torque)
+static const double jointInertia = 1.0e-4;   // [kg m^2]
+static const double jointDamping = 0.02;     // [Nm s/rad]
+static const double skinStiffness = 2.0;     // [Nm/rad]
+
+// encoder resolution (HEDS 5540, 512 lines, quadrature)
+static const double encoderStep = 2.0 * 3.14159265358979 / (512.0 * 4.0);  // [rad]
+static const double radToDeg = 180.0 / 3.14159265358979;
+
+// default sensor imperfections
+static const double defaultDacLatency = 0.0005;  // [sec]
+static const double defaultForceNoise = 0.02;    // [N]
+static const double defaultTorqueNoise = 0.0005; // [Nm]
+static const double defaultForceDrift = 1.0e-7;  // [N per read]
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cSimulatedNeuroTouch::cSimulatedNeuroTouch(double a_timeStep)
+{
+    m_timeStep = a_timeStep;
+    m_delayIndex = 0;
+    for (int i = 0; i < SIM_MAX_DELAY_TICKS; i++) m_delayLine[i][0] = m_delayLine[i][1] = 0;
+    for (int j = 0; j < 2; j++) {
+        m_angle[j] = 0;
+        m_velocity[j] = 0;
+        m_zero[j] = 0;
+        m_contactForce[j].store(0);
+    }
+
+    // identity until the real Jacobian is supplied
+    m_forceMap[0][0] = 1;  m_forceMap[0][1] = 0;
+    m_forceMap[1][0] = 0;  m_forceMap[1][1] = 1;
+
+    setDacLatency(defaultDacLatency);
+}
+
+int cSimulatedNeuroTouch::openEncoders()  { return 0; }
+int cSimulatedNeuroTouch::closeEncoders() { return 0; }
+int cSimulatedNeuroTouch::openMotors()    { return 0; }
+
+int cSimulatedNeuroTouch::closeMotors() {
+
+    for (int i = 0; i < SIM_MAX_DELAY_TICKS; i++) m_delayLine[i][0] = m_delayLine[i][1] = 0;
+    return 0;
+
+}
+
+// treat the current angles as zero
+int cSimulatedNeuroTouch::zeroEncoders() {
+
+    m_zero[0] = m_angle[0];
+    m_zero[1] = m_angle[1];
+    return 0;
+
+}
+
+// read encoder angles [deg], quantized to encoder resolution
+int cSimulatedNeuroTouch::readEncoders(float& a_degA, float& a_degB) {
+
+    a_degA = (float)(floor((m_angle[0] - m_zero[0]) / encoderStep + 0.5) * encoderStep * radToDeg);
+    a_degB = (float)(floor((m_angle[1] - m_zero[1]) / encoderStep + 0.5) * encoderStep * radToDeg);
+    return 0;
+
+}
+
+// latch new amplifier voltages and advance the model by one time step
+int cSimulatedNeuroTouch::writeVoltages(double a_voltA, double a_voltB) {
+
+    // commands come out of the delay line m_delayTicks later
+    m_delayLine[m_delayIndex][0] = a_voltA;
+    m_delayLine[m_delayIndex][1] = a_voltB;
+    int outIndex = (m_delayIndex - m_delayTicks + SIM_MAX_DELAY_TICKS) % SIM_MAX_DELAY_TICKS;
+    m_delayIndex = (m_delayIndex + 1) % SIM_MAX_DELAY_TICKS;
+
+    double springTorque[2];  // [mNm]
+    for (int j = 0; j < 2; j++) {
+
+        // current-mode amplifier with its current limit, then capstan gearing
+        double current = Kloopgain * m_delayLine[outIndex][j];
+        if (current > Imax) current = Imax;
+        if (current < -Imax) current = -Imax;
+        double torque = 1.0e-3 * Kt * current * GearRatio;  // [Nm]
+
+        // semi-implicit Euler (stable for these gains at 1 msec)
+        double acc = (torque - jointDamping * m_velocity[j] - skinStiffness * m_angle[j]) / jointInertia;
+        m_velocity[j] += acc * m_timeStep;
+        m_angle[j] += m_velocity[j] * m_timeStep;
+
+        springTorque[j] = 1.0e3 * skinStiffness * m_angle[j];
+    }
+
+    // the skin pushes back with the end-effector force that would produce the spring torques
+    m_contactForce[0].store(m_forceMap[0][0] * springTorque[0] + m_forceMap[0][1] * springTorque[1]);
+    m_contactForce[1].store(m_forceMap[1][0] * springTorque[0] + m_forceMap[1][1] * springTorque[1]);
+
+    return 0;
+
+}
+
+void cSimulatedNeuroTouch::setTimeStep(double a_timeStep) {
+
+    m_timeStep = a_timeStep;
+    setDacLatency(defaultDacLatency);
+
+}
+
+// DAC latency [sec], rounded to whole ticks
+void cSimulatedNeuroTouch::setDacLatency(double a_latency) {
+
+    m_delayTicks = (int)floor(a_latency / m_timeStep + 0.5);
+    if (m_delayTicks < 0) m_delayTicks = 0;
+    if (m_delayTicks > SIM_MAX_DELAY_TICKS - 1) m_delayTicks = SIM_MAX_DELAY_TICKS - 1;
+
+}
+
+// map from capstan torques back to end-effector force (inverse of the Jacobian transpose used by setForce)
+void cSimulatedNeuroTouch::setJacobianTranspose(const float a_jacobianTranspose[2][2]) {
+
+    double a = a_jacobianTranspose[0][0], b = a_jacobianTranspose[0][1];
+    double c = a_jacobianTranspose[1][0], d = a_jacobianTranspose[1][1];
+    double det = a * d - b * c;
+    if (fabs(det) < 1.0e-12) return;
+    m_forceMap[0][0] =  d / det;  m_forceMap[0][1] = -b / det;
+    m_forceMap[1][0] = -c / det;  m_forceMap[1][1] =  a / det;
+
+}
+
+// end-effector force currently held by the skin [N]
+void cSimulatedNeuroTouch::getContactForce(double& a_forceX, double& a_forceY) const {
+
+    a_forceX = m_contactForce[0].load();
+    a_forceY = m_contactForce[1].load();
+
+}
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cSimulatedForceSensor::cSimulatedForceSensor(cSimulatedNeuroTouch* a_plant)
+    : m_plant(a_plant),
+      m_generator(12345),  // fixed seed so regression runs are repeatable
+      m_unitNoise(0.0, 1.0)
+{
+    m_forceNoise = defaultForceNoise;
+    m_torqueNoise = defaultTorqueNoise;
+    m_drift = defaultForceDrift;
+    m_driftAccum = 0;
+
+    // an untared sensor reads some arbitrary load
+    static const double offset[6] = {0.35, -0.12, 1.40, 0.004, -0.002, 0.001};
+    for (int i = 0; i < 6; i++) {
+        m_offset[i] = offset[i];
+        m_bias[i] = 0;
+    }
+}
+
+int cSimulatedForceSensor::initialize(const std::string& /*a_calibrationFile*/, const std::string& /*a_device*/) { return 0; }
+int cSimulatedForceSensor::stop() { return 0; }
+std::string cSimulatedForceSensor::getForceUnits()  { return "N"; }
+std::string cSimulatedForceSensor::getTorqueUnits() { return "Nm"; }
+
+void cSimulatedForceSensor::setNoise(double a_forceStdDev, double a_torqueStdDev) {
+
+    m_forceNoise = a_forceStdDev;
+    m_torqueNoise = a_torqueStdDev;
+
+}
+
+void cSimulatedForceSensor::setDrift(double a_forceDriftPerRead) {
+
+    m_drift = a_forceDriftPerRead;
+
+}
+
+// raw (untared) reading
+void cSimulatedForceSensor::rawReading(double a_ft[6]) {
+
+    double fx = 0, fy = 0;
+    if (m_plant != NULL) m_plant->getContactForce(fx, fy);
+    m_driftAccum += m_drift;
+
+    a_ft[0] = fx;
+    a_ft[1] = fy;
+    a_ft[2] = 0;
+    a_ft[3] = a_ft[4] = a_ft[5] = 0;
+    for (int i = 0; i < 6; i++) {
+        double sigma = (i < 3) ? m_forceNoise : m_torqueNoise;
+        a_ft[i] += m_offset[i] + sigma * m_unitNoise(m_generator);
+        if (i < 3) a_ft[i] += m_driftAccum;
+    }
+
+}
+
+// tare at the current load
+int cSimulatedForceSensor::bias() {
+
+    rawReading(m_bias);
+    return 0;
+
+}
+
+// read one force/torque record
+int cSimulatedForceSensor::readFT(double a_ft[6]) {
+
+    rawReading(a_ft);
+    for (int i = 0; i < 6; i++) a_ft[i] -= m_bias[i];
+    return 0;
+
+}
@@ -0,0 +1,281 @@
+#include "cThreadConfig.h"
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#endif
+
+
+static const size_t stackPrefault = 256 * 1024;  // stack each configured thread touches up front [bytes]
+static const size_t pageSize = 4096;             // smallest page size we need to touch [bytes]
+
+static const char* policyNames[] = {"other", "fifo", "rr"};
+
+static volatile char stackSink;  // prefaultStack reads its buffer back into this (so the buffer is used, and kept)
+
+
+// touch stackPrefault bytes of the calling thread's stack so later calls never page-fault (NOTE: must not be inlined)
+#ifdef _MSC_VER
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+static void prefaultStack(void) {
+
+    volatile char buffer[stackPrefault];
+    for (size_t i = 0; i < stackPrefault; i += pageSize) buffer[i] = 0;
+    stackSink = buffer[0];
+
+}
+
+
+//===========================================================================
+// Constructor
+//===========================================================================
+cThreadConfig::cThreadConfig(void)
+{
+    m_numThreads = 0;
+    m_memoryLocked = false;
+    m_heapPrefaulted = 0;
+    for (int i = 0; i < TC_MAX_THREADS; i++) {
+        m_applied[i].store(false);
+        m_ok[i].store(false);
+    }
+}
+
+// index of a thread's settings (-1 if not configured)
+int cThreadConfig::find(const char* a_name) const {
+
+    for (int i = 0; i < m_numThreads; i++) {
+        if (strcmp(m_requested[i].name, a_name) == 0) return i;
+    }
+    return -1;
+
+}
+
+// set (or replace) the settings for one thread
+void cThreadConfig::setDefault(const char* a_name, int a_cpu, int a_policy, int a_priority) {
+
+    int i = find(a_name);
+    if (i < 0) {
+        if (m_numThreads >= TC_MAX_THREADS) return;
+        i = m_numThreads++;
+    }
+    strncpy(m_requested[i].name, a_name, TC_NAME_LENGTH - 1);
+    m_requested[i].name[TC_NAME_LENGTH - 1] = '\0';
+    m_requested[i].cpu = a_cpu;
+    m_requested[i].policy = a_policy;
+    m_requested[i].priority = (a_policy == TC_POLICY_OTHER) ? 0 : a_priority;
+
+}
+
+// read settings from a file (one "name cpu policy priority" line per thread)
+bool cThreadConfig::load(const char* a_filename) {
+
+    FILE* file = fopen(a_filename, "r");
+    if (file == NULL) return false;
+
+    char line[256];
+    int lineNum = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        lineNum++;
+
+        // strip comments, skip blank lines
+        char* comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        char name[TC_NAME_LENGTH];
+        char policy[16];
+        int cpu, priority;
+        int n = sscanf(line, "%31s %d %15s %d", name, &cpu, policy, &priority);
+        if (n <= 0) continue;
+        if (n != 4) {
+            printf("\n%s:%d: expected \"name cpu policy priority\"\n", a_filename, lineNum);
+            continue;
+        }
+
+        int p = -1;
+        for (int j = 0; j < 3; j++) if (strcmp(policy, policyNames[j]) == 0) p = j;
+        if (p < 0) {
+            printf("\n%s:%d: unknown policy \"%s\" (use other, fifo, or rr)\n", a_filename, lineNum, policy);
+            continue;
+        }
+        setDefault(name, cpu, p, priority);
+    }
+
+    fclose(file);
+    return true;
+
+}
+
+// read back the calling thread's actual affinity and scheduling
+void cThreadConfig::readActual(thread_settings& a_actual) const {
+
+    a_actual.cpu = -1;
+    a_actual.policy = TC_POLICY_OTHER;
+    a_actual.priority = 0;
+
+#ifdef _WIN32
+    // there is no GetThreadAffinityMask, so setting the mask again returns the current one
+    HANDLE thread = GetCurrentThread();
+    DWORD_PTR mask = SetThreadAffinityMask(thread, (DWORD_PTR)-1);
+    if (mask != 0) SetThreadAffinityMask(thread, mask);
+    if (mask != 0 && (mask & (mask - 1)) == 0) {
+        for (int cpu = 0; cpu < (int)(8 * sizeof(mask)); cpu++) if (mask == ((DWORD_PTR)1 << cpu)) a_actual.cpu = cpu;
+    }
+    int priority = GetThreadPriority(thread);
+    if (priority >= THREAD_PRIORITY_HIGHEST) {
+        a_actual.policy = TC_POLICY_FIFO;
+        a_actual.priority = (priority == THREAD_PRIORITY_TIME_CRITICAL) ? 99 : 50;
+    }
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0 && CPU_COUNT(&set) == 1) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) if (CPU_ISSET(cpu, &set)) a_actual.cpu = cpu;
+    }
+    int policy;
+    struct sched_param param;
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0) {
+        if (policy == SCHED_FIFO)    a_actual.policy = TC_POLICY_FIFO;
+        else if (policy == SCHED_RR) a_actual.policy = TC_POLICY_RR;
+        a_actual.priority = (a_actual.policy == TC_POLICY_OTHER) ? 0 : param.sched_priority;
+    }
+#endif
+
+}
+
+// apply a thread's settings to the calling thread
+bool cThreadConfig::apply(const char* a_name) {
+
+    int i = find(a_name);
+    if (i < 0) return true;  // nothing requested
+    const thread_settings& requested = m_requested[i];
+    bool ok = true;
+
+#ifdef _WIN32
+    HANDLE thread = GetCurrentThread();
+    if (requested.cpu >= 0) {
+        if (requested.cpu >= (int)(8 * sizeof(DWORD_PTR)) || SetThreadAffinityMask(thread, (DWORD_PTR)1 << requested.cpu) == 0) {
+            printf("\nThread %s: unable to pin to CPU %d\n", a_name, requested.cpu);
+            ok = false;
+        }
+    }
+    // Windows has no real-time policy for threads, so the nearest priority class is used
+    if (requested.policy != TC_POLICY_OTHER) {
+        int priority = (requested.priority >= 50) ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+        if (!SetThreadPriority(thread, priority)) {
+            printf("\nThread %s: unable to raise priority\n", a_name);
+            ok = false;
+        }
+    }
+#else
+    if (requested.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        int error = EINVAL;
+        if (requested.cpu < CPU_SETSIZE) {
+            CPU_SET(requested.cpu, &set);
+            error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+        if (error != 0) {
+            printf("\nThread %s: unable to pin to CPU %d (%s)\n", a_name, requested.cpu, strerror(error));
+            ok = false;
+        }
+    }
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    int policy = SCHED_OTHER;
+    if (requested.policy == TC_POLICY_FIFO) policy = SCHED_FIFO;
+    if (requested.policy == TC_POLICY_RR)   policy = SCHED_RR;
+    if (policy != SCHED_OTHER) {
+        int lowest = sched_get_priority_min(policy);
+        int highest = sched_get_priority_max(policy);
+        param.sched_priority = requested.priority;
+        if (param.sched_priority < lowest)  param.sched_priority = lowest;
+        if (param.sched_priority > highest) param.sched_priority = highest;
+    }
+    int error = pthread_setschedparam(pthread_self(), policy, &param);
+    if (error != 0) {
+        printf("\nThread %s: unable to set %s priority %d (%s)\n", a_name, policyNames[requested.policy], requested.priority,
+               (error == EPERM) ? "needs CAP_SYS_NICE or an rtprio limit" : strerror(error));
+        ok = false;
+    }
+#endif
+
+    // fault in the stack now rather than during the first ticks
+    prefaultStack();
+
+    // record what was actually granted
+    m_actual[i] = requested;
+    readActual(m_actual[i]);
+    if (requested.cpu >= 0 && m_actual[i].cpu != requested.cpu) ok = false;
+    if (m_actual[i].policy != requested.policy) ok = false;
+#ifndef _WIN32
+    if (m_actual[i].priority != requested.priority) ok = false;  // (Windows only has coarse priority levels)
+#endif
+    m_ok[i].store(ok);
+    m_applied[i].store(true, std::memory_order_release);
+    return ok;
+
+}
+
+// lock memory and prefault heap
+bool cThreadConfig::lockMemory(size_t a_heapBytes) {
+
+#ifdef _WIN32
+    // no process-wide equivalent of mlockall; the working set is left to the OS
+    m_memoryLocked = false;
+#else
+    m_memoryLocked = (mlockall(MCL_CURRENT | MCL_FUTURE) == 0);
+    if (!m_memoryLocked) printf("\nUnable to lock memory (%s)\n", (errno == EPERM || errno == ENOMEM) ? "needs CAP_IPC_LOCK or a memlock limit" : strerror(errno));
+
+#ifdef __GLIBC__
+    // keep freed memory in the (locked) heap instead of returning it to the OS
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+#endif
+#endif
+
+    // touch every page of a block of heap, then release it for later allocations to reuse
+    m_heapPrefaulted = 0;
+    if (a_heapBytes > 0) {
+        char* heap = (char*)malloc(a_heapBytes);
+        if (heap != NULL) {
+            for (size_t i = 0; i < a_heapBytes; i += pageSize) heap[i] = 0;
+            free(heap);
+            m_heapPrefaulted = a_heapBytes;
+        }
+    }
+
+    return m_memoryLocked;
+
+}
+
+// write requested vs. actual settings
+void cThreadConfig::report(FILE* a_file) const {
+
+    fprintf(a_file, "Thread settings (memory %s, %lu KB heap prefaulted):\n",
+            m_memoryLocked ? "locked" : "NOT locked", (unsigned long)(m_heapPrefaulted / 1024));
+    for (int i = 0; i < m_numThreads; i++) {
+        const thread_settings& r = m_requested[i];
+        if (!m_applied[i].load(std::memory_order_acquire)) {
+            fprintf(a_file, "  %-12s requested cpu %2d %-5s %2d  (not started)\n", r.name, r.cpu, policyNames[r.policy], r.priority);
+            continue;
+        }
+        const thread_settings& a = m_actual[i];
+        fprintf(a_file, "  %-12s requested cpu %2d %-5s %2d  actual cpu %2d %-5s %2d  %s\n",
+                r.name, r.cpu, policyNames[r.policy], r.priority, a.cpu, policyNames[a.policy], a.priority,
+                m_ok[i].load() ? "OK" : "MISMATCH");
+    }
+
+}
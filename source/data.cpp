@@ -1,11 +1,17 @@
 
 #include "data.h"
+#include <thread>
 using namespace std;
 
 
 static char response;   // Y/N response to set-up questions
 static save_data temp;  // for temporarily holding one time step of data (that is to be saved)
 
+static const int flushTimeout = 5000;       // longest flushTrialData and closeSessionLog wait for the writer thread [msec]
+static const double syncInterval = 1.0;     // how often the writer thread syncs a mapped session log to disk [sec]
+static const int benchmarkTrials = 20;      // trials timed by benchmarkSampleStorage and benchmarkLogFormat
+static const int stressReads = 5000000;     // reads checked against a concurrent writer by each half of benchmarkSeqLock
+
 static shared_data* p_sharedData;  // structure for sharing data between threads
 
 
@@ -22,8 +28,6 @@ void setup(void) {
     // initialize shared data
 	p_sharedData->simulationRunning = false;
 	p_sharedData->simulationFinished = false;
-	p_sharedData->phantomPos = 0;
-	p_sharedData->phantomVel = 0;
 	p_sharedData->cogRight = 0;
 	p_sharedData->cogLeft = 0;
 	p_sharedData->cogNeut = 0;
@@ -34,9 +38,8 @@ void setup(void) {
 	p_sharedData->controller = HAPTICS_OFF;
 	p_sharedData->autoFreq = 0.02;
     p_sharedData->cursorPos = 0;
-    p_sharedData->cursorPosOneAgo = 0;
     p_sharedData->cursorVel = 0;
-    p_sharedData->cursorVelOneAgo = 0;
+    p_sharedData->cursorResetRequests.store(0);
     p_sharedData->eeForceDesX = 0;
     p_sharedData->eeForceDesY = 0;
     p_sharedData->sensing = false;
@@ -46,6 +49,26 @@ void setup(void) {
     p_sharedData->blockNum = 0;
     p_sharedData->trialNum = 0;
 	p_sharedData->trialSuccess = false;
+    describeSaveData(p_sharedData->outputLog);
+    
+    // preallocate room for a whole trial of samples, so saving a sample never allocates (even if the recorder falls behind)
+    size_t samplesPerTrial = (size_t)(TRIAL_TIME / EXPERIMENT_LOOP_TIME) + 1;
+    p_sharedData->trialRing.allocate(samplesPerTrial);
+    
+    // preallocate the trial buffers passed between the recorder and writer threads (all start out empty)
+    p_sharedData->trialEnds.allocate(4 * TRIAL_BUFFERS);
+    p_sharedData->writerQueue.allocate(TRIAL_BUFFERS);
+    p_sharedData->freeBuffers.allocate(TRIAL_BUFFERS);
+    for (int i = 0; i < TRIAL_BUFFERS; i++) {
+        trial_buffer* buffer = new trial_buffer();
+        buffer->reserve(p_sharedData->trialRing.capacity());
+        p_sharedData->freeBuffers.push(buffer);
+    }
+    p_sharedData->trialsRecorded.store(0);
+    p_sharedData->trialsWritten.store(0);
+    p_sharedData->writerStalls.store(0);
+    p_sharedData->logClose.store(LOG_CLOSE_NONE);
+    p_sharedData->maxWriterBacklog.store(0);
 	
 	// create timers, PHANTOM device handler, and NeuroTouch device
     // NOTE: only use these constructors once (at beginning of main) to avoid pointer issues
@@ -54,7 +77,10 @@ void setup(void) {
     p_sharedData->timer = new cPrecisionClock();
     p_sharedData->p_phantomHandler = new cHapticDeviceHandler();
     p_sharedData->p_phantomHandler->getDevice(p_sharedData->p_Phantom, 0);  // 1st available haptic device
-    p_sharedData->p_NeuroTouch = new cNeuroTouch();
+    p_sharedData->p_NeuroTouch = new cNeuroTouch(0, p_sharedData->hardware);
+    
+    // headless runs use the defaults (demo mode, autonomous cursor)
+    if (p_sharedData->headless) return;
     
     // ask for operating mode (defaults to demo)
     printf("\nIs this going to be an experiment?\n");
@@ -80,40 +106,223 @@ void setup(void) {
     
 }
 
-// save one time step of data to vector for current trial
+// save one time step of data for current trial
 void saveOneTimeStep(void) {
     
 	save_data temp;
     
+    // get a consistent snapshot of the haptic state (written by the NeuroTouch thread)
+    haptic_state haptic;
+    p_sharedData->hapticState.read(haptic);
+    
     // record individual parameters
     temp.d_blockNum = p_sharedData->blockNum;
     temp.d_trialNum = p_sharedData->trialNum;
     temp.d_trialSuccess = p_sharedData->trialSuccess;
     temp.d_targetSide = p_sharedData->targetSide;
-    temp.d_cursorPos = p_sharedData->cursorPos;
-    temp.d_cursorVel = p_sharedData->cursorVel;
+    temp.d_cursorPos = haptic.cursorPos;
+    temp.d_cursorVel = haptic.cursorVel;
     temp.d_timeElapsed = p_sharedData->timeElapsed;
     temp.d_cogRight = p_sharedData->cogRight;
     temp.d_cogLeft = p_sharedData->cogLeft;
     temp.d_cogNeut = p_sharedData->cogNeut;
     temp.d_controlSig = p_sharedData->controlSig;
-    temp.d_eeForceDesX = p_sharedData->eeForceDesX;
-    temp.d_eeForceDesY = p_sharedData->eeForceDesY;
-    temp.d_motorAPos = p_sharedData->motorAPos;
-    temp.d_motorBPos = p_sharedData->motorBPos;
-    for (int i=0; i<3; i++) temp.d_force[i] = p_sharedData->force[i];
+    temp.d_eeForceDesX = haptic.eeForceDesX;
+    temp.d_eeForceDesY = haptic.eeForceDesY;
+    temp.d_motorAPos = haptic.motorAPos;
+    temp.d_motorBPos = haptic.motorBPos;
+    for (int i=0; i<3; i++) temp.d_force[i] = haptic.force[i];
+    
+    // hand off to the recorder thread (never allocates or blocks)
+	if (!p_sharedData->trialRing.push(temp)) DIAG_WARN("sample ring full, dropped a sample");
+    
+}
+
+// recorder loop: drain saved samples into trial buffers, handing each completed trial to the writer thread
+void updateRecorder(void) {
+    
+    p_sharedData->threadConfig.apply("recorder");
+    p_sharedData->m_recorderLoopTimer.setPeriodSeconds(RECORDER_LOOP_TIME / p_sharedData->speedup);
+    p_sharedData->m_recorderLoopTimer.start();
+    
+    trial_buffer* current = NULL;  // buffer for the trial in progress
+    size_t drained = 0;            // samples drained so far
+    size_t trialEnd = 0;           // sample count at which the next trial ends
+    bool endPending = false;
+    bool stalled = false;
+    save_data sample;
+    
+    while (p_sharedData->simulationRunning) {
+        p_sharedData->m_recorderLoopTimer.waitForNextPeriod();
+        
+        // leave the log alone while the writer closes it (NOTE: read first, so a request covers every sample saved before it)
+        int closing = p_sharedData->logClose.load();
+        if (closing == LOG_CLOSE_RECORDER_DONE) continue;
+        
+        // only drain samples saved before this point (any trial end among them is then already visible in trialEnds)
+        size_t available = p_sharedData->trialRing.getPushed();
+        
+        // mapped log: copy samples straight into the file, with no trial buffers or writer hand-off
+        if (p_sharedData->outputLog.isMapped() && current == NULL) {
+            while (true) {
+                if (!endPending) endPending = p_sharedData->trialEnds.pop(trialEnd);
+                if (endPending && drained == trialEnd) {
+                    (p_sharedData->trialsWritten)++;
+                    endPending = false;
+                    continue;
+                }
+                if (drained == available || !p_sharedData->trialRing.pop(sample)) break;
+                p_sharedData->outputLog.append(&sample);
+                drained++;
+            }
+            if (closing == LOG_CLOSE_REQUESTED) p_sharedData->logClose.store(LOG_CLOSE_RECORDER_DONE);
+            continue;
+        }
+        
+        while (true) {
+            
+            // hand off a completed trial
+            if (!endPending) endPending = p_sharedData->trialEnds.pop(trialEnd);
+            if (endPending && drained == trialEnd && current != NULL) {
+                p_sharedData->writerQueue.push(current);  // (cannot fail, the queue has room for every buffer)
+                unsigned long backlog = (unsigned long)p_sharedData->writerQueue.size();
+                if (backlog > p_sharedData->maxWriterBacklog.load()) p_sharedData->maxWriterBacklog.store(backlog);
+                current = NULL;
+                endPending = false;
+                continue;
+            }
+            
+            // back-pressure: with no empty buffer from the writer, leave samples in the ring (which holds a whole trial)
+            if (current == NULL) {
+                if (drained == available && !endPending) break;
+                if (!p_sharedData->freeBuffers.pop(current)) {
+                    if (!stalled) (p_sharedData->writerStalls)++;
+                    stalled = true;
+                    break;
+                }
+                stalled = false;
+                if (endPending && drained == trialEnd) continue;  // (an empty trial)
+            }
+            
+            if (drained == available || !p_sharedData->trialRing.pop(sample)) break;
+            current->push_back(sample);
+            drained++;
+        }
+        
+        // stop appending to the log being closed (an unfinished trial belongs to it, so it must not start the next log)
+        if (closing == LOG_CLOSE_REQUESTED) {
+            if (current != NULL) current->clear();
+            p_sharedData->logClose.store(LOG_CLOSE_RECORDER_DONE);
+        }
+    }
+    
+}
+
+// writer loop: format and write completed trials, then return their buffers to the recorder (or, with a mapped log, periodically sync it to disk)
+void updateWriter(void) {
+    
+    p_sharedData->threadConfig.apply("writer");
+    p_sharedData->m_writerLoopTimer.setPeriodSeconds(WRITER_LOOP_TIME / p_sharedData->speedup);
+    p_sharedData->m_writerLoopTimer.start();
     
-    // push into vector for current trial
-	p_sharedData->trialData.push_back(temp);
+    int ticksPerSync = (int)(syncInterval / WRITER_LOOP_TIME);
+    int ticks = 0;
+    trial_buffer* trial;
+    while (p_sharedData->simulationRunning) {
+        p_sharedData->m_writerLoopTimer.waitForNextPeriod();
+        
+        // (read before draining the queue, so once the recorder is done everything it handed off is written below)
+        int closing = p_sharedData->logClose.load();
+        
+        // (no effect on a streamed log)
+        if (++ticks >= ticksPerSync) {
+            p_sharedData->outputLog.sync();
+            ticks = 0;
+        }
+        
+        while (p_sharedData->writerQueue.pop(trial)) {
+            if (p_sharedData->outputLog.isOpen()) writeTrial(*trial, p_sharedData->outputLog);
+            trial->clear();
+            p_sharedData->freeBuffers.push(trial);
+            (p_sharedData->trialsWritten)++;
+        }
+        
+        // close the log here, on the only thread still using it
+        if (closing == LOG_CLOSE_RECORDER_DONE) {
+            p_sharedData->outputLog.close();
+            p_sharedData->logClose.store(LOG_CLOSE_NONE);
+        }
+    }
     
 }
 
-// write data to file from current trial
+// diagnostics loop: print messages logged by the other loops (so none of them ever waits on the console)
+void updateDiagLog(void) {
+    
+    p_sharedData->threadConfig.apply("diag");
+    p_sharedData->m_diagLoopTimer.setPeriodSeconds(DIAG_LOOP_TIME);
+    p_sharedData->m_diagLoopTimer.start();
+    
+    while (p_sharedData->simulationRunning) {
+        p_sharedData->m_diagLoopTimer.waitForNextPeriod();
+        diagLog.flush(stdout);
+    }
+    diagLog.flush(stdout);
+    
+}
+
+// mark the end of the current trial (NOTE: only queues the trial; the recorder and writer threads write it out in the background)
 void recordTrial(void) {
     
+    if (!p_sharedData->trialEnds.push(p_sharedData->trialRing.getPushed())) {
+        DIAG_ERROR("too many trials waiting to be recorded, trial %d not saved", p_sharedData->trialNum);
+        return;
+    }
+    (p_sharedData->trialsRecorded)++;
+    
+    // warn if the writer is falling behind (samples are dropped once every buffer is waiting to be written)
+    unsigned long backlog = p_sharedData->trialsRecorded.load() - p_sharedData->trialsWritten.load();
+    if (backlog >= TRIAL_BUFFERS - 1) DIAG_WARN("data writer behind by %lu trials", backlog);
+    
+}
+
+// describe save_data to a log (NOTE: field names are the column names of the original text format; append new fields at the end)
+void describeSaveData(cSessionLogWriter& log) {
+    
+    log.addField("Block",        "",        LOG_INT32,   offsetof(save_data, d_blockNum));
+    log.addField("Trial",        "",        LOG_INT32,   offsetof(save_data, d_trialNum));
+    log.addField("Success",      "",        LOG_BOOL,    offsetof(save_data, d_trialSuccess));
+    log.addField("TargetSide",   "",        LOG_FLOAT64, offsetof(save_data, d_targetSide));
+    log.addField("CursorPos",    "world",   LOG_FLOAT64, offsetof(save_data, d_cursorPos));
+    log.addField("CursorVel",    "world/s", LOG_FLOAT64, offsetof(save_data, d_cursorVel));
+    log.addField("TimeElapsed",  "s",       LOG_FLOAT64, offsetof(save_data, d_timeElapsed));
+    log.addField("CogRight",     "",        LOG_FLOAT32, offsetof(save_data, d_cogRight));
+    log.addField("CogLeft",      "",        LOG_FLOAT32, offsetof(save_data, d_cogLeft));
+    log.addField("CogNeut",      "",        LOG_FLOAT32, offsetof(save_data, d_cogNeut));
+    log.addField("ControlSig",   "",        LOG_FLOAT32, offsetof(save_data, d_controlSig));
+    log.addField("eeForceDesX",  "N",       LOG_FLOAT64, offsetof(save_data, d_eeForceDesX));
+    log.addField("eeForceDesY",  "N",       LOG_FLOAT64, offsetof(save_data, d_eeForceDesY));
+    log.addField("MotorAPos",    "deg",     LOG_FLOAT32, offsetof(save_data, d_motorAPos));
+    log.addField("MotorBPos",    "deg",     LOG_FLOAT32, offsetof(save_data, d_motorBPos));
+    log.addField("FingerForceX", "N",       LOG_FLOAT64, offsetof(save_data, d_force[0]));
+    log.addField("FingerForceY", "N",       LOG_FLOAT64, offsetof(save_data, d_force[1]));
+    log.addField("FingerForceZ", "N",       LOG_FLOAT64, offsetof(save_data, d_force[2]));
+    
+}
+
+// write one trial's samples to a log
+void writeTrial(const trial_buffer& trial, cSessionLogWriter& log) {
+    
+    for (trial_buffer::const_iterator it = trial.begin() ; it != trial.end(); ++it) log.append(&(*it));
+    
+}
+
+// write one trial's samples as text (the original .dat format, kept for benchmarkLogFormat; see sessionLogToText)
+static void writeTrialText(const trial_buffer& trial, FILE* file) {
+    
     // iterate over vector, writing one time step at a time
-    for (vector<save_data>::iterator it = p_sharedData->trialData.begin() ; it != p_sharedData->trialData.end(); ++it) {
-        fprintf(p_sharedData->outputFile,"%d %d %d %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f\n",
+    for (trial_buffer::const_iterator it = trial.begin() ; it != trial.end(); ++it) {
+        fprintf(file,"%d %d %d %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f\n",
                 it->d_blockNum,
                 it->d_trialNum,
                 it->d_trialSuccess,
@@ -134,7 +343,267 @@ void recordTrial(void) {
                 it->d_force[2]);
     }
     
-    // clear vector for next segment and signal that recording is done
-    p_sharedData->trialData.clear();
+}
+
+// wait until every recorded trial has been written (returns false on timeout; the log itself is flushed when the writer closes it)
+bool flushTrialData(void) {
+    
+    for (int waited = 0; p_sharedData->trialsWritten.load() != p_sharedData->trialsRecorded.load(); waited++) {
+        if (waited >= flushTimeout) {
+            printf("\nTIMED OUT WRITING TRIAL DATA (%lu OF %lu TRIALS WRITTEN)\n", p_sharedData->trialsWritten.load(), p_sharedData->trialsRecorded.load());
+            return false;
+        }
+        cSleepMs(1);
+    }
+    return true;
+    
+}
+
+// close the session log once everything saved so far is in it (NOTE: the recorder stops appending, then the writer closes it, so it is
+// never closed under either thread; returns false on timeout, in which case the writer still closes it once the recorder is done)
+bool closeSessionLog(void) {
+    
+    flushTrialData();
+    p_sharedData->logClose.store(LOG_CLOSE_REQUESTED);
+    for (int waited = 0; p_sharedData->logClose.load() != LOG_CLOSE_NONE; waited++) {
+        if (waited >= flushTimeout) {
+            printf("\nTIMED OUT CLOSING THE SESSION LOG\n");
+            return false;
+        }
+        cSleepMs(1);
+    }
+    return true;
+    
+}
+
+// write a summary of data recording (including any back-pressure from the writer)
+void printRecorderStats(FILE* file) {
+    
+    fprintf(file, "Data recording: %lu trials recorded, %lu written, max backlog %lu trials, writer stalls %lu, samples dropped %lu\n",
+            p_sharedData->trialsRecorded.load(), p_sharedData->trialsWritten.load(), p_sharedData->maxWriterBacklog.load(),
+            p_sharedData->writerStalls.load(), p_sharedData->trialRing.getDropped());
+    if (p_sharedData->outputLog.getRecordsDropped() > 0) fprintf(file, "Mapped session log full: %lu samples not saved\n", p_sharedData->outputLog.getRecordsDropped());
+    
+}
+
+// time the per-sample cost of the old (vector) and new (ring) sample storage and write a summary to a file
+void benchmarkSampleStorage(FILE* file) {
+    
+    size_t samplesPerTrial = (size_t)(TRIAL_TIME / EXPERIMENT_LOOP_TIME);
+    save_data sample;
+    memset(&sample, 0, sizeof(sample));
+    cLatencyHistogram timerCost, vectorCost, ringCost;
+    long long t0, t1;
+    
+    // cost of the timestamps themselves (included in both results below)
+    for (size_t i = 0; i < samplesPerTrial; i++) {
+        t0 = getMonotonicTimeNs();
+        t1 = getMonotonicTimeNs();
+        timerCost.record(t1 - t0);
+    }
+    
+    // before: push_back onto a vector that is cleared (but keeps its capacity) after each trial
+    vector<save_data> trialVector;
+    for (int trial = 0; trial < benchmarkTrials; trial++) {
+        for (size_t i = 0; i < samplesPerTrial; i++) {
+            sample.d_trialNum = (int)i;
+            t0 = getMonotonicTimeNs();
+            trialVector.push_back(sample);
+            t1 = getMonotonicTimeNs();
+            vectorCost.record(t1 - t0);
+        }
+        trialVector.clear();
+    }
+    
+    // after: push into the preallocated ring (drained between trials, as the recorder thread would)
+    cRingBuffer<save_data> ring;
+    ring.allocate(samplesPerTrial + 1);
+    for (int trial = 0; trial < benchmarkTrials; trial++) {
+        for (size_t i = 0; i < samplesPerTrial; i++) {
+            sample.d_trialNum = (int)i;
+            t0 = getMonotonicTimeNs();
+            ring.push(sample);
+            t1 = getMonotonicTimeNs();
+            ringCost.record(t1 - t0);
+        }
+        while (ring.pop(sample)) {}
+    }
+    
+    // report in nsec (per-sample costs are well under the usec resolution of cLatencyHistogram::print)
+    latency_summary s;
+    fprintf(file, "Per-sample storage cost, %d trials of %lu samples (%lu-byte records) [nsec]:\n",
+            benchmarkTrials, (unsigned long)samplesPerTrial, (unsigned long)sizeof(save_data));
+    cLatencyHistogram* results[3] = {&timerCost, &vectorCost, &ringCost};
+    const char* names[3] = {"timer only", "vector", "ring"};
+    for (int i = 0; i < 3; i++) {
+        results[i]->getSummary(s);
+        fprintf(file, "  %-10s mean=%.1f  p50=%lld  p99=%lld  p99.9=%lld  max=%lld\n", names[i], s.mean, s.p50, s.p99, s.p999, s.max);
+    }
+    
+}
+
+// size of a file [bytes] (-1 if it cannot be read)
+static long fileSize(const char* filename) {
+    
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+    
+}
+
+// time writing trials in the original text format and the binary log format and write a summary to a file
+void benchmarkLogFormat(FILE* file) {
+    
+    static const char* textFilename = "benchmark_text.dat";
+    static const char* logFilename = "benchmark_log.log";
+    
+    // one trial of plausible (i.e., not very compressible) samples
+    size_t samplesPerTrial = (size_t)(TRIAL_TIME / EXPERIMENT_LOOP_TIME);
+    trial_buffer trial(samplesPerTrial);
+    for (size_t i = 0; i < samplesPerTrial; i++) {
+        save_data& s = trial[i];
+        double t = i * EXPERIMENT_LOOP_TIME;
+        s.d_blockNum = 3;
+        s.d_trialNum = 12;
+        s.d_trialSuccess = (i > samplesPerTrial / 2);
+        s.d_targetSide = RIGHT;
+        s.d_cursorPos = 0.15 * sin(1.3 * t);
+        s.d_cursorVel = 0.195 * cos(1.3 * t);
+        s.d_timeElapsed = t;
+        s.d_cogRight = (float)(0.5 + 0.5 * sin(0.7 * t));
+        s.d_cogLeft = (float)(0.5 - 0.5 * sin(0.7 * t));
+        s.d_cogNeut = (float)(0.1 * cos(2.1 * t));
+        s.d_controlSig = (float)(1234.5 * sin(0.3 * t));
+        s.d_eeForceDesX = 0.8 * sin(1.3 * t);
+        s.d_eeForceDesY = 0.4 * cos(1.3 * t);
+        s.d_motorAPos = (float)(12.5 * sin(1.3 * t));
+        s.d_motorBPos = (float)(-7.25 * cos(1.3 * t));
+        for (int j = 0; j < 3; j++) s.d_force[j] = 0.01 * (j + 1) * sin(5.0 * t + j);
+    }
+    
+    // before: fprintf of each sample
+    long long t0 = getMonotonicTimeNs();
+    FILE* textFile = fopen(textFilename, "w");
+    if (textFile == NULL) {
+        fprintf(file, "Unable to create %s\n", textFilename);
+        return;
+    }
+    for (int i = 0; i < benchmarkTrials; i++) writeTrialText(trial, textFile);
+    fclose(textFile);
+    long long textNs = getMonotonicTimeNs() - t0;
+    
+    // after: packed records written in chunks
+    cSessionLogWriter log;
+    describeSaveData(log);
+    t0 = getMonotonicTimeNs();
+    if (!log.open(logFilename, "benchmark")) {
+        fprintf(file, "Unable to create %s\n", logFilename);
+        remove(textFilename);
+        return;
+    }
+    for (int i = 0; i < benchmarkTrials; i++) writeTrial(trial, log);
+    log.close();
+    long long logNs = getMonotonicTimeNs() - t0;
+    
+    // report throughput and size (including open/close, which is when the data actually reaches the file)
+    double samples = (double)benchmarkTrials * samplesPerTrial;
+    long textBytes = fileSize(textFilename);
+    long logBytes = fileSize(logFilename);
+    fprintf(file, "Log format, %d trials of %lu samples:\n", benchmarkTrials, (unsigned long)samplesPerTrial);
+    fprintf(file, "  %-10s %8.1f nsec/sample  %8.1f MB/s  %10ld bytes (%.1f per sample)\n", "text",
+            textNs / samples, textBytes / (textNs * 1.0e-3), textBytes, textBytes / samples);
+    fprintf(file, "  %-10s %8.1f nsec/sample  %8.1f MB/s  %10ld bytes (%.1f per sample)\n", "binary",
+            logNs / samples, logBytes / (logNs * 1.0e-3), logBytes, logBytes / samples);
+    if (logNs > 0 && logBytes > 0) fprintf(file, "  binary is %.1fx faster and %.1fx smaller\n", (double)textNs / logNs, (double)textBytes / logBytes);
+    
+    remove(textFilename);
+    remove(logFilename);
+    
+}
+
+// fill every field of a haptic state from one count (NOTE: wrapped so it is exact in the float fields too)
+static void fillHapticState(haptic_state& state, unsigned long count) {
+    
+    double value = (double)(count & 0xFFFFFF);
+    state.cursorPos = value;
+    state.cursorVel = value;
+    state.eeForceDesX = value;
+    state.eeForceDesY = value;
+    state.motorAPos = (float)value;
+    state.motorBPos = (float)value;
+    for (int i = 0; i < 3; i++) state.force[i] = value;
+    state.cursorResets = count;
+    
+}
+
+// true if every field of a haptic state came from the same write (i.e., the read that produced it was not torn)
+static bool isWholeHapticState(const haptic_state& state) {
+    
+    double value = (double)(state.cursorResets & 0xFFFFFF);
+    if (state.cursorPos != value || state.cursorVel != value) return false;
+    if (state.eeForceDesX != value || state.eeForceDesY != value) return false;
+    if (state.motorAPos != (float)value || state.motorBPos != (float)value) return false;
+    for (int i = 0; i < 3; i++) if (state.force[i] != value) return false;
+    return true;
+    
+}
+
+// stress the haptic state handoff: a writer thread publishes states as fast as it can while this thread reads them,
+// first through a plain struct copy (as before cSeqLock) and then through cSeqLock, and write the torn reads seen by each
+void benchmarkSeqLock(FILE* file) {
+    
+    haptic_state plain, state;
+    cSeqLock<haptic_state> locked;
+    std::atomic<bool> done;
+    unsigned long plainWrites = 0;
+    unsigned long long plainTorn = 0, lockedTorn = 0;
+    fillHapticState(plain, 0);
+    
+    // before: unsynchronized copy (NOTE: a data race, kept only to show the problem; the signal fences stop the compiler hoisting the copies out of the loops)
+    done = false;
+    std::thread plainWriter([&]() {
+        haptic_state next;
+        unsigned long count = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+            fillHapticState(next, ++count);
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            plain = next;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        }
+        plainWrites = count;
+    });
+    for (int i = 0; i < stressReads; i++) {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        state = plain;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        if (!isWholeHapticState(state)) plainTorn++;
+    }
+    done = true;
+    plainWriter.join();
+    
+    // after: the seqlock shared_data::hapticState uses
+    done = false;
+    std::thread lockedWriter([&]() {
+        haptic_state next;
+        unsigned long count = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+            fillHapticState(next, ++count);
+            locked.write(next);
+        }
+    });
+    for (int i = 0; i < stressReads; i++) {
+        locked.read(state);
+        if (!isWholeHapticState(state)) lockedTorn++;
+    }
+    done = true;
+    lockedWriter.join();
+    
+    // report (retried reads are the ones that would have been torn)
+    fprintf(file, "Haptic state handoff, %d reads against a concurrent writer (%lu-byte state):\n", stressReads, (unsigned long)sizeof(haptic_state));
+    fprintf(file, "  %-10s %10lu writes  %10llu torn reads\n", "plain copy", plainWrites, plainTorn);
+    fprintf(file, "  %-10s %10lu writes  %10llu torn reads  (%llu reads retried)\n", "cSeqLock", locked.getWriteCount(), lockedTorn, locked.getRetryCount());
     
 }
@@ -1,14 +1,19 @@
 
 #include "experiment.h"
+#ifndef _WIN32
+#include <sys/select.h>
+#include <unistd.h>
+#endif
 using namespace chai3d;
 using namespace std;
 
 
 static const int trialsPerBlock = 20;             // trials per control paradigm
-static const int trialTime = 20;                  // max time per trial or washout [sec]
+static const int blocksPerSession = 4;            // (NO_HAPTICS_1, HAPTICS_1, NO_HAPTICS_2, HAPTICS_2)
+static const int trialTime = TRIAL_TIME;          // max time per trial or washout [sec]
 static const int breakTime = 180;                 // break time [sec]
 static const int preblockTime = 10;               // time to display message [sec]
-static const int recordTime = 5;                  // time to record data [sec]
+static const int feedbackTime = 1;                // time to show a trial's result before the next trial [sec]
 static const int targetSides[2] = {RIGHT, LEFT};  // only experiment parameter
 
 static int subjectNum;           // subject number
@@ -20,6 +25,27 @@ static int nextExperimentState;  // so state machine knows where to go next
 static shared_data* p_sharedData;  // structure for sharing data between threads
 
 
+// whether a key has been pressed (a headless run has no one to press one, so it goes straight on)
+static bool keyPressed(void) {
+    
+    if (p_sharedData->headless) return true;
+#ifdef _WIN32
+    return _kbhit() != 0;
+#else
+    // (the terminal hands over whole lines, so this is a press of Enter, which is consumed)
+    fd_set keys;
+    FD_ZERO(&keys);
+    FD_SET(STDIN_FILENO, &keys);
+    struct timeval now = {0, 0};
+    if (select(STDIN_FILENO + 1, &keys, NULL, NULL, &now) <= 0) return false;
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF) {}
+    return true;
+#endif
+    
+}
+
+
 // point p_sharedData to sharedData, which is the data shared between all threads
 void linkSharedDataToExperiment(shared_data& sharedData) {
     
@@ -39,358 +65,367 @@ void initExperiment(void) {
     cin >> session;
     printf("\n");
     
-    // generate filename and open file for writing
-    sprintf(filename, "Subj_%dCtrl_%dSession%d.dat", subjectNum, control, session);
-    p_sharedData->outputFile = fopen(filename,"w");
-    fprintf(p_sharedData->outputFile, "Block, Trial, Success, TargetSide, CursorPos, CursorVel, TimeElapsed, CogRight, CogLeft, CogNeut, ControlSig, eeForceDesX, eeForceDesY, MotorAPos, MotorBPos, FingerForceX, FingerForceY, FingerForceZ\n");
+    // generate filename and open log for writing (NOTE: convert to the old .dat text format with sessionLogToText)
+    sprintf(filename, "Subj_%dCtrl_%dSession%d.log", subjectNum, control, session);
+    char info[100];
+    sprintf(info, "subject %d, control %d, session %d", subjectNum, control, session);
+    
+    // a mapped log is sized for a whole session up front (every trial running to timeout, plus the sample saved as each block ends)
+    size_t mappedRecords = 0;
+    if (p_sharedData->mappedLog) mappedRecords = (size_t)blocksPerSession * (trialsPerBlock + 1) * ((size_t)(trialTime / EXPERIMENT_LOOP_TIME) + 1);
+    if (!p_sharedData->outputLog.open(filename, info, mappedRecords)) printf("\nUNABLE TO CREATE %s, DATA WILL NOT BE SAVED\n", filename);
+    
+    // switch to BCI input if it is not already selected (NOTE: an experiment started from set-up or --headless begins on AUTO, with no BCI source running)
+    if (p_sharedData->input != BCI) {
+        p_sharedData->input = BCI;
+        initBCI();
+        p_sharedData->inputSwitch.select(BCI);
+    }
     
     // enter start-up mode, with force feedback off for safety
-    p_sharedData->input = BCI;
     p_sharedData->controller = HAPTICS_OFF;
     p_sharedData->experimentState = START_UP;
     p_sharedData->message = "Welcome.";
     
 	// initialize experiment loop timer
-	p_sharedData->m_expLoopTimer.setTimeoutPeriodSeconds(LOOP_TIME);
-	p_sharedData->m_expLoopTimer.start(true);
+	p_sharedData->m_expLoopTimer.setPeriodSeconds(EXPERIMENT_LOOP_TIME / p_sharedData->speedup);
+	p_sharedData->m_expLoopTimer.start();
     
 }
 
 // experiment state machine (only entered if in experiment mode)
 void updateExperiment(void) {
    
+    p_sharedData->threadConfig.apply("experiment");
+    diagLog.attachThread();
     while (p_sharedData->simulationRunning) {
 
-        // only update experiment if timer has expired
-	    if (p_sharedData->m_expLoopTimer.timeoutOccurred()) {
+        // sleep until the next update is due
+        p_sharedData->m_expLoopTimer.waitForNextPeriod();
 
-			p_sharedData->m_expLoopTimer.stop();
+		if (p_sharedData->opMode == EXPERIMENT) {
 
-			if (p_sharedData->opMode == EXPERIMENT) {
-            
-				switch (p_sharedData->experimentState) {
-                    
-					case START_UP:
-                    
-						// wait for a keypress
-						while(true){
-							if (_kbhit()) {
-                        
-								// ready subject for 1st block of trials
-								nextExperimentState = NO_HAPTICS_1;
-								p_sharedData->blockNum = 1;
-								p_sharedData->message = "Beginning Block 1 in " + to_string(static_cast<long long>(preblockTime)) + " seconds.";
-                        
-								// set/start timer (from zero)
-								p_sharedData->timer->setTimeoutPeriodSeconds(preblockTime);
-								p_sharedData->timer->start(true);
-								p_sharedData->experimentState = PREBLOCK;
-								break;
-							}
-						}
-						break;
+			// get a consistent snapshot of the haptic state (written by the NeuroTouch thread)
+			haptic_state haptic;
+			p_sharedData->hapticState.read(haptic);
+        
+			switch (p_sharedData->experimentState) {
+                
+				case START_UP:
+                
+					// wait for a keypress
+					while(true){
+						if (keyPressed()) {
                     
-					case NO_HAPTICS_1:
-                    
-						// save data from time step
-						p_sharedData->timeElapsed = p_sharedData->timer->getCurrentTimeSeconds();
-						saveOneTimeStep();
+							// ready subject for 1st block of trials
+							nextExperimentState = NO_HAPTICS_1;
+							p_sharedData->blockNum = 1;
+							p_sharedData->message = "Beginning Block 1 in " + to_string(static_cast<long long>(preblockTime)) + " seconds.";
                     
-						// finished with 1st block
-						if (p_sharedData->trialNum > trialsPerBlock) {
-                        
-							// give subject a break before 2nd block
-							nextExperimentState = HAPTICS_1;
-							p_sharedData->message = "Relax your mind for 3 minutes.";
-                        
 							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(breakTime);
+							p_sharedData->timer->setTimeoutPeriodSeconds(preblockTime);
 							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = BREAK;
+							p_sharedData->experimentState = PREBLOCK;
+							break;
 						}
+					}
+					break;
+                
+				case NO_HAPTICS_1:
+                
+					// save data from time step
+					p_sharedData->timeElapsed = p_sharedData->timer->getCurrentTimeSeconds();
+					saveOneTimeStep();
+                
+					// finished with 1st block
+					if (p_sharedData->trialNum > trialsPerBlock) {
                     
-						// successful trial (i.e., cursor reached target in time)
-						if ( ((p_sharedData->cursorPos) >= (TARGET_DIST) ) && (p_sharedData->targetSide == RIGHT)  ||
-							 ((p_sharedData->cursorPos) <= (-1*TARGET_DIST) ) && (p_sharedData->targetSide == LEFT)) {
-                        
-							p_sharedData->trialSuccess = true;
-							p_sharedData->message = "Success.";
-                        
-							// start recording trial data
-							saveOneTimeStep();
-							recordTrial();
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(recordTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = RECORD;
-						}
+						// give subject a break before 2nd block
+						nextExperimentState = HAPTICS_1;
+						p_sharedData->message = "Relax your mind for 3 minutes.";
                     
-						// unsuccessful trial (i.e., time expired)
-						if (p_sharedData->timer->timeoutOccurred()) {
-                        
-							p_sharedData->trialSuccess = false;
-							p_sharedData->message = "Time expired.";
-                        
-							// start recording trial data
-							saveOneTimeStep();
-							recordTrial();
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(recordTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = RECORD;
-						}
-						break;
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(breakTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = BREAK;
+					}
+                
+					// successful trial (i.e., cursor reached target in time)
+					if ( ((haptic.cursorPos) >= (TARGET_DIST) ) && (p_sharedData->targetSide == RIGHT)  ||
+						 ((haptic.cursorPos) <= (-1*TARGET_DIST) ) && (p_sharedData->targetSide == LEFT)) {
                     
-					case HAPTICS_1:
+						p_sharedData->trialSuccess = true;
+						p_sharedData->message = "Success.";
                     
-						// save data from time step
-						p_sharedData->timeElapsed = p_sharedData->timer->getCurrentTimeSeconds();
+						// queue trial data for recording (written in the background)
 						saveOneTimeStep();
+						recordTrial();
                     
-						// finished with 2nd block
-						if (p_sharedData->trialNum > trialsPerBlock) {
-                        
-							// turn off force feedback
-							p_sharedData->controller = HAPTICS_OFF;
-                        
-							// give subject a break before 3rd block
-							nextExperimentState = NO_HAPTICS_2;
-							p_sharedData->message = "Relax your mind for 3 minutes.";
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(breakTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = BREAK;
-						}
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(feedbackTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = RECORD;
+					}
+                
+					// unsuccessful trial (i.e., time expired)
+					if (p_sharedData->timer->timeoutOccurred()) {
                     
-						// successful trial (i.e., cursor reached target in time)
-						if ( ((p_sharedData->cursorPos) >= (TARGET_DIST) ) && (p_sharedData->targetSide == RIGHT)  ||
-							 ((p_sharedData->cursorPos) <= (-1*TARGET_DIST) ) && (p_sharedData->targetSide == LEFT)) {
-                        
-							p_sharedData->trialSuccess = true;
-							p_sharedData->message = "Success.";
-                        
-							// turn off force feedback
-							p_sharedData->controller = HAPTICS_OFF;
-                        
-							// start recording trial data
-							saveOneTimeStep();
-							recordTrial();
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(recordTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = RECORD;
-						}
+						p_sharedData->trialSuccess = false;
+						p_sharedData->message = "Time expired.";
                     
-						// unsuccessful trial (i.e., time expired)
-						if (p_sharedData->timer->timeoutOccurred()) {
-                        
-							p_sharedData->trialSuccess = false;
-							p_sharedData->message = "Time expired.";
-                        
-							// turn off force feedback
-							p_sharedData->controller = HAPTICS_OFF;
-                        
-							// start recording trial data
-							saveOneTimeStep();
-							recordTrial();
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(recordTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = RECORD;
-						}
-						break;
+						// queue trial data for recording (written in the background)
+						saveOneTimeStep();
+						recordTrial();
+                    
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(feedbackTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = RECORD;
+					}
+					break;
+                
+				case HAPTICS_1:
+                
+					// save data from time step
+					p_sharedData->timeElapsed = p_sharedData->timer->getCurrentTimeSeconds();
+					saveOneTimeStep();
+                
+					// finished with 2nd block
+					if (p_sharedData->trialNum > trialsPerBlock) {
+                    
+						// turn off force feedback
+						p_sharedData->controller = HAPTICS_OFF;
                     
-					case NO_HAPTICS_2:
+						// give subject a break before 3rd block
+						nextExperimentState = NO_HAPTICS_2;
+						p_sharedData->message = "Relax your mind for 3 minutes.";
                     
-						// save data from time step
-						p_sharedData->timeElapsed = p_sharedData->timer->getCurrentTimeSeconds();
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(breakTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = BREAK;
+					}
+                
+					// successful trial (i.e., cursor reached target in time)
+					if ( ((haptic.cursorPos) >= (TARGET_DIST) ) && (p_sharedData->targetSide == RIGHT)  ||
+						 ((haptic.cursorPos) <= (-1*TARGET_DIST) ) && (p_sharedData->targetSide == LEFT)) {
+                    
+						p_sharedData->trialSuccess = true;
+						p_sharedData->message = "Success.";
+                    
+						// turn off force feedback
+						p_sharedData->controller = HAPTICS_OFF;
+                    
+						// queue trial data for recording (written in the background)
 						saveOneTimeStep();
+						recordTrial();
                     
-						// finished with 3rd block
-						if (p_sharedData->trialNum > trialsPerBlock) {
-                        
-							// give subject a break before 4th block
-							nextExperimentState = HAPTICS_2;
-							p_sharedData->message = "Relax your mind for 3 minutes.";
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(breakTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = BREAK;
-						}
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(feedbackTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = RECORD;
+					}
+                
+					// unsuccessful trial (i.e., time expired)
+					if (p_sharedData->timer->timeoutOccurred()) {
                     
-						// successful trial (i.e., cursor reached target in time)
-					   if ( ((p_sharedData->cursorPos) >= (TARGET_DIST) ) && (p_sharedData->targetSide == RIGHT)  ||
-							 ((p_sharedData->cursorPos) <= (-1*TARGET_DIST) ) && (p_sharedData->targetSide == LEFT)) {
-                        
-							p_sharedData->trialSuccess = true;
-							p_sharedData->message = "Success.";
-                        
-							// start recording trial data
-							saveOneTimeStep();
-							recordTrial();
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(recordTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = RECORD;
-						}
+						p_sharedData->trialSuccess = false;
+						p_sharedData->message = "Time expired.";
                     
-						// unsuccessful trial (i.e., time expired)
-						if (p_sharedData->timer->timeoutOccurred()) {
-                        
-							p_sharedData->trialSuccess = false;
-							p_sharedData->message = "Time expired.";                        
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(recordTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = RECORD;
+						// turn off force feedback
+						p_sharedData->controller = HAPTICS_OFF;
+                    
+						// queue trial data for recording (written in the background)
+						saveOneTimeStep();
+						recordTrial();
+                    
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(feedbackTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = RECORD;
+					}
+					break;
+                
+				case NO_HAPTICS_2:
+                
+					// save data from time step
+					p_sharedData->timeElapsed = p_sharedData->timer->getCurrentTimeSeconds();
+					saveOneTimeStep();
+                
+					// finished with 3rd block
+					if (p_sharedData->trialNum > trialsPerBlock) {
+                    
+						// give subject a break before 4th block
+						nextExperimentState = HAPTICS_2;
+						p_sharedData->message = "Relax your mind for 3 minutes.";
+                    
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(breakTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = BREAK;
+					}
+                
+					// successful trial (i.e., cursor reached target in time)
+				   if ( ((haptic.cursorPos) >= (TARGET_DIST) ) && (p_sharedData->targetSide == RIGHT)  ||
+						 ((haptic.cursorPos) <= (-1*TARGET_DIST) ) && (p_sharedData->targetSide == LEFT)) {
+                    
+						p_sharedData->trialSuccess = true;
+						p_sharedData->message = "Success.";
+                    
+						// queue trial data for recording (written in the background)
+						saveOneTimeStep();
+						recordTrial();
+                    
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(feedbackTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = RECORD;
+					}
+                
+					// unsuccessful trial (i.e., time expired)
+					if (p_sharedData->timer->timeoutOccurred()) {
+                    
+						p_sharedData->trialSuccess = false;
+						p_sharedData->message = "Time expired.";                        
+                    
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(feedbackTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = RECORD;
 
-							// start recording trial data
-							saveOneTimeStep();
-							recordTrial();
-						}
-						break;
+						// queue trial data for recording (written in the background)
+						saveOneTimeStep();
+						recordTrial();
+					}
+					break;
+                
+				case HAPTICS_2:
+                
+					// save data from time step
+					p_sharedData->timeElapsed = p_sharedData->timer->getCurrentTimeSeconds();
+					saveOneTimeStep();
+                
+					// finished with last block
+					if (p_sharedData->trialNum > trialsPerBlock) {
+                    
+						// turn off force feedback
+						p_sharedData->controller = HAPTICS_OFF;
+                    
+						// thank subject and terminate experiment
+						p_sharedData->message = "Thank you.";
+						p_sharedData->experimentState = THANKS;
+						closeExperiment();
+					}
+                
+					// successful trial (i.e., cursor reached target in time)
+					if ( ((haptic.cursorPos) >= (TARGET_DIST) ) && (p_sharedData->targetSide == RIGHT)  ||
+						 ((haptic.cursorPos) <= (-1*TARGET_DIST) ) && (p_sharedData->targetSide == LEFT)) {
                     
-					case HAPTICS_2:
+						p_sharedData->trialSuccess = true;
+						p_sharedData->message = "Success.";
                     
-						// save data from time step
-						p_sharedData->timeElapsed = p_sharedData->timer->getCurrentTimeSeconds();
+						// turn off force feedback
+						p_sharedData->controller = HAPTICS_OFF;
+                    
+						// queue trial data for recording (written in the background)
 						saveOneTimeStep();
+						recordTrial();
                     
-						// finished with last block
-						if (p_sharedData->trialNum > trialsPerBlock) {
-                        
-							// turn off force feedback
-							p_sharedData->controller = HAPTICS_OFF;
-                        
-							// thank subject and terminate experiment
-							p_sharedData->message = "Thank you.";
-							p_sharedData->experimentState = THANKS;
-							closeExperiment();
-						}
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(feedbackTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = RECORD;
+					}
+                
+					// unsuccessful trial (i.e., time expired)
+					if (p_sharedData->timer->timeoutOccurred()) {
                     
-						// successful trial (i.e., cursor reached target in time)
-						if ( ((p_sharedData->cursorPos) >= (TARGET_DIST) ) && (p_sharedData->targetSide == RIGHT)  ||
-							 ((p_sharedData->cursorPos) <= (-1*TARGET_DIST) ) && (p_sharedData->targetSide == LEFT)) {
-                        
-							p_sharedData->trialSuccess = true;
-							p_sharedData->message = "Success.";
-                        
-							// turn off force feedback
-							p_sharedData->controller = HAPTICS_OFF;
-                        
-							// start recording trial data
-							saveOneTimeStep();
-							recordTrial();
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(recordTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = RECORD;
-						}
+						p_sharedData->trialSuccess = false;
+						p_sharedData->message = "Time expired.";
                     
-						// unsuccessful trial (i.e., time expired)
-						if (p_sharedData->timer->timeoutOccurred()) {
-                        
-							p_sharedData->trialSuccess = false;
-							p_sharedData->message = "Time expired.";
-                        
-							// turn off force feedback
-							p_sharedData->controller = HAPTICS_OFF;
-                        
-							// start recording trial data
-							saveOneTimeStep();
-							recordTrial();
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(recordTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = RECORD;
-						}
-						break;
-                    
-					case PREBLOCK:
-                    
-						// wait for time to expire
-						if (p_sharedData->timer->timeoutOccurred()) {
-                        
-							// prep for 1st trial
-							p_sharedData->trialNum = 1;
-							p_sharedData->targetSide = targetSides[rand() % 2];
-							p_sharedData->cursorPos = 0;
-							p_sharedData->cursorPosOneAgo = 0;
-							p_sharedData->cursorVel = 0;
-							p_sharedData->cursorVelOneAgo = 0;
-                        
-							// set control paradigm
-							if (nextExperimentState == HAPTICS_1 || nextExperimentState == HAPTICS_2) p_sharedData->controller = control;
-							else                                                                      p_sharedData->controller = HAPTICS_OFF;
-                        
-							// set/start timer (from zero) and begin block of trials
-							p_sharedData->timer->setTimeoutPeriodSeconds(trialTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = nextExperimentState;
-						}
-						break;
+						// turn off force feedback
+						p_sharedData->controller = HAPTICS_OFF;
                     
-					case BREAK:
+						// queue trial data for recording (written in the background)
+						saveOneTimeStep();
+						recordTrial();
                     
-						// break over
-						if (p_sharedData->timer->timeoutOccurred()) {
-                        
-							// ready subject for next block of trials
-							(p_sharedData->blockNum)++;
-							p_sharedData->message = "Beginning Block " + to_string(static_cast<long long>(p_sharedData->blockNum)) + " in " + to_string(static_cast<long long>(preblockTime)) + " seconds.";
-                        
-							// set/start timer (from zero)
-							p_sharedData->timer->setTimeoutPeriodSeconds(preblockTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = PREBLOCK;
-						}
-						break;
-                    
-					case RECORD:
-                    
-						// wait for time to expire (more than enough to record data)
-						if (p_sharedData->timer->timeoutOccurred()) {
-                        
-							// prep for next trial
-							(p_sharedData->trialNum)++;
-							p_sharedData->trialSuccess = false;
-							p_sharedData->targetSide = targetSides[rand() % 2];
-							p_sharedData->cursorPos = 0;
-							p_sharedData->cursorPosOneAgo = 0;
-							p_sharedData->cursorVel = 0;
-							p_sharedData->cursorVelOneAgo = 0;
-                        
-							// set control paradigm
-							if (nextExperimentState == HAPTICS_1 || nextExperimentState == HAPTICS_2) p_sharedData->controller = control;
-							else                                                                      p_sharedData->controller = HAPTICS_OFF;
-                        
-							// set/start timer (from zero) and return to block
-							p_sharedData->timer->setTimeoutPeriodSeconds(trialTime);
-							p_sharedData->timer->start(true);
-							p_sharedData->experimentState = nextExperimentState;
-						}
-						break;
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(feedbackTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = RECORD;
+					}
+					break;
+                
+				case PREBLOCK:
+                
+					// wait for time to expire
+					if (p_sharedData->timer->timeoutOccurred()) {
+                    
+						// prep for 1st trial
+						p_sharedData->trialNum = 1;
+						p_sharedData->targetSide = targetSides[rand() % 2];
+						resetCursor();
+                    
+						// set control paradigm
+						if (nextExperimentState == HAPTICS_1 || nextExperimentState == HAPTICS_2) p_sharedData->controller = control;
+						else                                                                      p_sharedData->controller = HAPTICS_OFF;
                     
-					case THANKS:
-						break;
+						// set/start timer (from zero) and begin block of trials
+						p_sharedData->timer->setTimeoutPeriodSeconds(trialTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = nextExperimentState;
+					}
+					break;
+                
+				case BREAK:
+                
+					// break over
+					if (p_sharedData->timer->timeoutOccurred()) {
                     
-					default:
-						break;
-				}
+						// ready subject for next block of trials
+						(p_sharedData->blockNum)++;
+						p_sharedData->message = "Beginning Block " + to_string(static_cast<long long>(p_sharedData->blockNum)) + " in " + to_string(static_cast<long long>(preblockTime)) + " seconds.";
+                    
+						// set/start timer (from zero)
+						p_sharedData->timer->setTimeoutPeriodSeconds(preblockTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = PREBLOCK;
+					}
+					break;
+                
+				case RECORD:
+                
+					// show the trial's result (NOTE: its data is written in the background, so there is nothing to wait for)
+					if (p_sharedData->timer->timeoutOccurred()) {
+                    
+						// prep for next trial
+						(p_sharedData->trialNum)++;
+						p_sharedData->trialSuccess = false;
+						p_sharedData->targetSide = targetSides[rand() % 2];
+						resetCursor();
+                    
+						// set control paradigm
+						if (nextExperimentState == HAPTICS_1 || nextExperimentState == HAPTICS_2) p_sharedData->controller = control;
+						else                                                                      p_sharedData->controller = HAPTICS_OFF;
+                    
+						// set/start timer (from zero) and return to block
+						p_sharedData->timer->setTimeoutPeriodSeconds(trialTime);
+						p_sharedData->timer->start(true);
+						p_sharedData->experimentState = nextExperimentState;
+					}
+					break;
+                
+				case THANKS:
+					break;
+                
+				default:
+					break;
 			}
-            
-			p_sharedData->m_expLoopTimer.start(true);
 		}
+        
+        // send any BCI2000 state updates made this tick together
+        if (p_sharedData->bci == GTEC) flushToGTec();
     }
      
 }
@@ -399,6 +434,19 @@ void updateExperiment(void) {
 void closeExperiment(void) {
     
     p_sharedData->experimentState = THANKS;
-    if (p_sharedData->outputFile != NULL) fclose(p_sharedData->outputFile);
+    if (p_sharedData->outputLog.isOpen()) {
+        closeSessionLog();
+        
+        // save haptic loop timing for the session next to the data file
+        char timingFilename[100];
+        sprintf(timingFilename, "Subj_%dCtrl_%dSession%d_timing.txt", subjectNum, control, session);
+        FILE* timingFile = fopen(timingFilename, "w");
+        if (timingFile != NULL) {
+            printNeuroTouchTiming(timingFile);
+            printInputLatency(timingFile);
+            printBCITiming(timingFile);
+            fclose(timingFile);
+        }
+    }
     
 }
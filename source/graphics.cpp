@@ -117,12 +117,16 @@ void linkSharedDataToGraphics(shared_data& sharedData) {
 // update and re-render the graphics
 void updateGraphics(void) {
     
+    // get a consistent snapshot of the haptic state (written by the NeuroTouch thread)
+    haptic_state haptic;
+    p_sharedData->hapticState.read(haptic);
+    
     // update target and cursor
     double targetPos = (p_sharedData->targetSide) * TARGET_DIST;
     target->setLocalPos(targetPos, 0, 0);
     if (p_sharedData->trialSuccess) target->m_material->setGreenChartreuse();  // target turns bright green upon success
     else                            target->m_material->setRedCrimson();
-    cursor->setLocalPos(p_sharedData->cursorPos, 0, 0);
+    cursor->setLocalPos(haptic.cursorPos, 0, 0);
     
     // update labels
     if (p_sharedData->opMode == DEMO) opMode->setString("Mode: DEMO");
@@ -135,7 +139,10 @@ void updateGraphics(void) {
     else                               input->setString("Input: PHANTOM");
     controller->setString("Controller #" + to_string(static_cast<long long>(p_sharedData->controller)));
     phantomRate->setString("PHANTOM: " + to_string(static_cast<long long>(p_sharedData->phantomFreqCounter.getFrequency())));
-    neurotouchRate->setString("NeuroTouch: " + to_string(static_cast<long long>(p_sharedData->neurotouchFreqCounter.getFrequency())));
+    latency_summary period;
+    p_sharedData->neurotouchTiming.period.getSummary(period);
+    neurotouchRate->setString("NeuroTouch: " + to_string(static_cast<long long>(p_sharedData->neurotouchFreqCounter.getFrequency())) +
+                              " (p99 period " + to_string(static_cast<long double>(1.0e-6 * period.p99)) + " ms)");
     trial->setString("Trial: " + to_string(static_cast<long long>(p_sharedData->trialNum)));
     
     opMode->setLocalPos(10, (int) (windowH - 1.0 * opMode->getHeight()), 0);
@@ -250,18 +257,21 @@ void respToKey(unsigned char key, int x, int y) {
         case 'I':
             
             if (p_sharedData->opMode == DEMO) {
-                // auto -> BCI -> PHANTOM
+                // auto -> BCI -> PHANTOM (NOTE: the BCI and PHANTOM threads open and close their devices, so this only waits for the old source to stop)
+                long long stopNs = 0;
                 if (p_sharedData->input == AUTO) {
                     p_sharedData->input = BCI;
 					initBCI();
+                    stopNs = p_sharedData->inputSwitch.select(BCI);
                 } else if (p_sharedData->input == BCI) {
                     p_sharedData->input = PHANTOM;
+                    stopNs = p_sharedData->inputSwitch.select(PHANTOM);
                     closeBCI();
-                    initPhantom();
                 } else {
                     p_sharedData->input = AUTO;
-                    closePhantom();
+                    stopNs = p_sharedData->inputSwitch.select(AUTO);
                 }
+                printf("\nInput switched (previous source stopped in %.1f ms)\n", stopNs * 1.0e-6);
             } else {
                 printf("\nMust use BCI for experiment.\n");
             }
@@ -345,9 +355,31 @@ void close(void) {
     // wait for NeuroTouch thread to terminate
     while (!p_sharedData->simulationFinished) cSleepMs(100);
     
-    // close all devices
-    if (p_sharedData->input == BCI)          closeBCI();
-    else if (p_sharedData->input == PHANTOM) closePhantom();
+    // report how much of a core each loop was using (sleeping loops should sit well below 100%)
+    printf("\nCPU use per loop: NeuroTouch %.1f%% (%lu missed deadlines), cursor %.1f%% (%lu missed deadlines), PHANTOM %.1f%%, experiment %.1f%%,\n"
+           "                  recorder %.1f%%, writer %.1f%%, diagnostics %.1f%%\n",
+           100.0 * p_sharedData->m_neurotouchLoopTimer.getCpuLoad(),
+           p_sharedData->m_neurotouchLoopTimer.getMissedDeadlines(),
+           100.0 * p_sharedData->m_cursorLoopTimer.getCpuLoad(),
+           p_sharedData->m_cursorLoopTimer.getMissedDeadlines(),
+           100.0 * p_sharedData->m_phantomLoopTimer.getCpuLoad(),
+           100.0 * p_sharedData->m_expLoopTimer.getCpuLoad(),
+           100.0 * p_sharedData->m_recorderLoopTimer.getCpuLoad(),
+           100.0 * p_sharedData->m_writerLoopTimer.getCpuLoad(),
+           100.0 * p_sharedData->m_diagLoopTimer.getCpuLoad());
+    printNeuroTouchTiming(stdout);
+    printInputLatency(stdout);
+    printBCITiming(stdout);
+    p_sharedData->threadConfig.report(stdout);
+    printRecorderStats(stdout);
+    
+    // print any diagnostics messages the diagnostics thread did not get to
+    diagLog.flush(stdout);
+    if (diagLog.getDropped() > 0) printf("%lu diagnostics messages dropped\n", diagLog.getDropped());
+    
+    // close all devices (the input switch has the BCI or PHANTOM thread close its own)
+    p_sharedData->inputSwitch.shutdown();
+    closeBCI();
     closeNeuroTouch();
 
 	// clean up memory
@@ -28,21 +28,26 @@
 // Includes
 //----------
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <assert.h>
 #include <cstdio>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "BCI.h"
 #include "OSC_Listener.h"
 #include "Phantom.h"
 #include "NeuroTouch.h"
+#include "Cursor.h"
 #include "cForceSensor.h"
 #include "cATIForceSensor.h"
 #include "cDaqHardwareInterface.h"
 #include "chai3d.h"
 #include "graphics.h"
 #include "data.h"
+#include "benchmarkOsc.h"
 #include "shared_Data.h"
 using namespace chai3d;
 using namespace std;
@@ -56,46 +61,194 @@ using namespace std;
 cThread* bciThread;
 cThread* phantomThread;
 cThread* neurotouchThread;
+cThread* cursorThread;
 cThread* experimentThread;
+cThread* recorderThread;
+cThread* writerThread;
+cThread* diagThread;
 shared_data sharedData;
 
 
+// read command-line options (NOTE: anything unrecognized is left for GLUT)
+//   --sim           use simulated NeuroTouch and force sensor (no hardware required)
+//   --headless      no graphics or set-up prompts (demo mode, autonomous cursor)
+//   --speedup N     run loops N times faster than real time (simulated hardware only)
+//   --duration T    stop a headless run after T seconds (of wall-clock time)
+//   --controller C  control paradigm to start with (0-4, see shared_Data.h)
+//   --threads FILE  thread configuration to use instead of THREAD_CONFIG
+//   --mmap          write the session log through a preallocated memory mapping
+//   --record FILE   record every datagram from the BCI sockets, with arrival times
+//   --replay FILE   replay a recording in place of the BCI it was recorded from
+//   --replay-speed N  replay N times faster than recorded (0 = as fast as possible; default 1)
+//   --jitter-buffer MS  hold OSC bundles until their time tag plus MS, so network jitter does not reach the cursor
+//   --drop-late     drop OSC bundles that arrive after their time (with --jitter-buffer; default is to dispatch them at once)
+//   --benchmark     time the per-sample data storage, log formats, haptic state handoff (torn reads with and without cSeqLock), BCI2000 state parsing, and the OSC receive loop, address dispatch and message parsing, then exit
+//   --traffic FILE  recorded BCI2000 state traffic for --benchmark (synthetic if not given)
+static void parseOptions(int argc, char* argv[]) {
+    
+    // default thread settings (NOTE: the BCI thread mostly blocks on its socket, so it does not need real-time priority)
+    sharedData.threadConfig.setDefault("neurotouch", 1, TC_POLICY_FIFO, 80);
+    sharedData.threadConfig.setDefault("cursor", 2, TC_POLICY_FIFO, 70);
+    sharedData.threadConfig.setDefault("phantom", 2, TC_POLICY_FIFO, 60);
+    sharedData.threadConfig.setDefault("bci", -1, TC_POLICY_OTHER, 0);
+    sharedData.threadConfig.setDefault("experiment", -1, TC_POLICY_OTHER, 0);
+    sharedData.threadConfig.setDefault("recorder", -1, TC_POLICY_OTHER, 0);
+    sharedData.threadConfig.setDefault("writer", -1, TC_POLICY_OTHER, 0);
+    sharedData.threadConfig.setDefault("diag", -1, TC_POLICY_OTHER, 0);
+    sharedData.threadConfig.setDefault("graphics", -1, TC_POLICY_OTHER, 0);
+    const char* threadConfigFile = THREAD_CONFIG;
+    
+    sharedData.hardware = HW_HARDWARE;
+    sharedData.headless = false;
+    sharedData.speedup = 1.0;
+    sharedData.runTime = 0;
+    sharedData.mappedLog = false;
+    sharedData.recordFile = NULL;
+    sharedData.replayFile = NULL;
+    sharedData.replaySpeed = 1.0;
+    sharedData.oscJitterMs = -1;
+    sharedData.oscDropLate = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sim") == 0) sharedData.hardware = HW_SIMULATED;
+        else if (strcmp(argv[i], "--headless") == 0) sharedData.headless = true;
+        else if (strcmp(argv[i], "--speedup") == 0 && i+1 < argc) sharedData.speedup = atof(argv[++i]);
+        else if (strcmp(argv[i], "--duration") == 0 && i+1 < argc) sharedData.runTime = atof(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) threadConfigFile = argv[++i];
+        else if (strcmp(argv[i], "--mmap") == 0) sharedData.mappedLog = true;
+        else if (strcmp(argv[i], "--record") == 0 && i+1 < argc) sharedData.recordFile = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i+1 < argc) sharedData.replayFile = argv[++i];
+        else if (strcmp(argv[i], "--replay-speed") == 0 && i+1 < argc) sharedData.replaySpeed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--jitter-buffer") == 0 && i+1 < argc) sharedData.oscJitterMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--drop-late") == 0) sharedData.oscDropLate = true;
+    }
+    if (sharedData.replaySpeed < 0) sharedData.replaySpeed = 1.0;
+    if (sharedData.oscJitterMs < -1) sharedData.oscJitterMs = -1;
+    
+    // (a replay only partly passes through the sockets' code, so it cannot be re-recorded)
+    if (sharedData.replayFile != NULL && sharedData.recordFile != NULL) {
+        printf("\nNot recording a replay (--record ignored).\n");
+        sharedData.recordFile = NULL;
+    }
+    if (!sharedData.threadConfig.load(threadConfigFile)) printf("\nNo thread configuration in %s, using defaults.\n", threadConfigFile);
+    
+    // only the simulation can keep up with faster-than-real-time loops
+    if (sharedData.hardware != HW_SIMULATED || sharedData.speedup < 1.0) sharedData.speedup = 1.0;
+    if (sharedData.speedup > MAX_SPEEDUP) sharedData.speedup = MAX_SPEEDUP;
+    
+}
+
+// the control paradigm is set after setup() has filled in the defaults
+static void parseController(int argc, char* argv[]) {
+    
+    for (int i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], "--controller") == 0) {
+            int controller = atoi(argv[i+1]);
+            if (controller >= HAPTICS_OFF && controller <= VEL_ANTI_CURSOR) sharedData.controller = controller;
+        }
+    }
+    
+}
+
+
+// a replay stands in for the BCI it was recorded from (NOTE: after setup(), which fills in the default input)
+static bool setUpReplay(void) {
+    
+    cInputReplayer replay;
+    if (!replay.open(sharedData.replayFile)) return false;
+    sharedData.input = BCI;
+    sharedData.bci = replay.getBci();
+    printf("\nReplaying %s input from %s", (sharedData.bci == GTEC) ? "g.MOBIlab+" : "Emotiv", sharedData.replayFile);
+    if (sharedData.replaySpeed > 0) printf(" at %gx.\n", sharedData.replaySpeed);
+    else printf(" as fast as possible.\n");
+    return true;
+    
+}
+
+
 //---------------
 // Main Function
 //---------------
 int main(int argc, char* argv[]) {
 	
-    // set up simulation with user input
+    // micro-benchmarks need nothing else set up
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--benchmark") == 0) {
+            const char* trafficFile = NULL;
+            for (int j = 1; j < argc - 1; j++) if (strcmp(argv[j], "--traffic") == 0) trafficFile = argv[j+1];
+            benchmarkSampleStorage(stdout);
+            benchmarkLogFormat(stdout);
+            benchmarkSeqLock(stdout);
+            benchmarkGTecParser(stdout, trafficFile);
+            benchmarkOscReceive(stdout);
+            benchmarkOscDispatch(stdout);
+            benchmarkOscParse(stdout);
+            return 0;
+        }
+    }
+    
+    // set up simulation with command-line options and user input
+    parseOptions(argc, argv);
+    sharedData.threadConfig.lockMemory(HEAP_PREFAULT);
     linkSharedData(sharedData);
     setup();
+    parseController(argc, argv);
+    if (sharedData.replayFile != NULL && !setUpReplay()) return 1;
+    if (sharedData.hardware == HW_SIMULATED) printf("\nRunning with simulated hardware (%.0fx real time).\n", sharedData.speedup);
 
     // create threads
     cThread* bciThread = new cThread();
     cThread* phantomThread = new cThread();
     cThread* neurotouchThread = new cThread();
+    cThread* cursorThread = new cThread();
     cThread* experimentThread = new cThread();
+    cThread* recorderThread = new cThread();
+    cThread* writerThread = new cThread();
+    cThread* diagThread = new cThread();
     
     // give each thread access to shared data
     linkSharedDataToBCI(sharedData);
     linkSharedDataToPhantom(sharedData);
     linkSharedDataToNeuroTouch(sharedData);
+    linkSharedDataToCursor(sharedData);
     linkSharedDataToExperiment(sharedData);
     linkSharedDataToGraphics(sharedData);
     
     // initialize devices
+	// (the BCI and PHANTOM threads open their devices once the input switch selects them)
 	if (sharedData.input == BCI)     initBCI();
-    if (sharedData.input == PHANTOM) initPhantom();	
+    sharedData.inputSwitch.select(sharedData.input);
     initNeuroTouch();
+    initCursor();
     
-	// initialize force sensor
+	// initialize force sensor (NOTE: a simulated sensor reads contact force from the simulated NeuroTouch, so this comes after initNeuroTouch)
+	if (sharedData.hardware == HW_SIMULATED) sharedData.g_ForceSensor.Set_Backend(HW_SIMULATED, sharedData.p_NeuroTouch->getMotorBackend());
 	sharedData.g_ForceSensor.Set_Calibration_File_Loc(FS_CALIB);
 	sharedData.g_ForceSensor.Initialize_Force_Sensor(FS_INIT);
-	cSleepMs(1000);
+	if (sharedData.hardware == HW_HARDWARE) cSleepMs(1000);
 	sharedData.g_ForceSensor.Zero_Force_Sensor();
 
     // initialize experiment or demo (default)
     if(sharedData.opMode == EXPERIMENT) initExperiment();
 
+    // headless: run the threads without graphics, then shut down
+    if (sharedData.headless) {
+        sharedData.simulationRunning = true;
+        neurotouchThread->start(updateNeuroTouch, CTHREAD_PRIORITY_HAPTICS);
+        cursorThread->start(updateCursor, CTHREAD_PRIORITY_HAPTICS);
+        bciThread->start(updateBCI, CTHREAD_PRIORITY_GRAPHICS);
+        phantomThread->start(updatePhantom, CTHREAD_PRIORITY_GRAPHICS);
+        if (sharedData.opMode == EXPERIMENT) experimentThread->start(updateExperiment, CTHREAD_PRIORITY_GRAPHICS);
+        recorderThread->start(updateRecorder, CTHREAD_PRIORITY_GRAPHICS);
+        writerThread->start(updateWriter, CTHREAD_PRIORITY_GRAPHICS);
+        diagThread->start(updateDiagLog, CTHREAD_PRIORITY_GRAPHICS);
+        
+        cPrecisionClock runClock;
+        runClock.start(true);
+        while (sharedData.runTime <= 0 || runClock.getCurrentTimeSeconds() < sharedData.runTime) cSleepMs(100);
+        close();
+        return 0;
+    }
+    
     // initialize graphics
     initGraphics(argc, argv);
     
@@ -111,11 +264,17 @@ int main(int argc, char* argv[]) {
 	printf("Q/ESC = quit\n");
 	printf("*********************\n\n");   	
 	
-    // start threads
+    // start threads (NOTE: marked running first so no loop sees the flag before the NeuroTouch thread sets it)
+    sharedData.simulationRunning = true;
 	neurotouchThread->start(updateNeuroTouch, CTHREAD_PRIORITY_HAPTICS);  // highest priority
-    bciThread->start(updateBCI, CTHREAD_PRIORITY_HAPTICS);
+    cursorThread->start(updateCursor, CTHREAD_PRIORITY_HAPTICS);
+    bciThread->start(updateBCI, CTHREAD_PRIORITY_GRAPHICS);
     phantomThread->start(updatePhantom, CTHREAD_PRIORITY_GRAPHICS);
     experimentThread->start(updateExperiment, CTHREAD_PRIORITY_GRAPHICS);
+    recorderThread->start(updateRecorder, CTHREAD_PRIORITY_GRAPHICS);
+    writerThread->start(updateWriter, CTHREAD_PRIORITY_GRAPHICS);
+    diagThread->start(updateDiagLog, CTHREAD_PRIORITY_GRAPHICS);
+    sharedData.threadConfig.apply("graphics");
     glutTimerFunc(50, graphicsTimer, 0);
     glutMainLoop();
     
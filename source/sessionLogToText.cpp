@@ -0,0 +1,95 @@
+/***********************************************************
+ Session log converter
+
+ Converts a binary session log (see cSessionLog.h) back to
+ text. By default the output matches the .dat files the
+ experiment used to write (a header line, then one line of
+ space-separated %d/%f columns per time step), so existing
+ analysis scripts keep working. A mapped log that is still
+ being written converts up to the records written so far.
+
+ usage: sessionLogToText [--csv] [--describe] LOG [OUTPUT]
+
+   --csv       comma-separated, full precision
+   --describe  print the log's schema and session info only
+
+ Built on its own (cSessionLog.cpp is its only dependency).
+ ************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "cSessionLog.h"
+
+
+static const char* typeNames[] = {"?", "int32", "bool", "float32", "float64"};
+
+
+// write the schema and session info
+static void describe(const cSessionLogReader& log, FILE* out) {
+
+    fprintf(out, "Session: %s\n", log.getInfo());
+    fprintf(out, "%d fields, %lu-byte records:\n", log.getNumFields(), (unsigned long)log.getRecordSize());
+    for (int i = 0; i < log.getNumFields(); i++) {
+        const log_field& field = log.getField(i);
+        fprintf(out, "  %-14s %-8s %s\n", field.name, typeNames[field.type], field.unit);
+    }
+
+}
+
+int main(int argc, char* argv[]) {
+
+    bool csv = false;
+    bool describeOnly = false;
+    const char* inputName = NULL;
+    const char* outputName = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0) csv = true;
+        else if (strcmp(argv[i], "--describe") == 0) describeOnly = true;
+        else if (inputName == NULL) inputName = argv[i];
+        else if (outputName == NULL) outputName = argv[i];
+        else inputName = NULL;
+    }
+    if (inputName == NULL) {
+        printf("usage: %s [--csv] [--describe] LOG [OUTPUT]\n", argv[0]);
+        return 1;
+    }
+
+    cSessionLogReader log;
+    if (!log.open(inputName)) return 1;
+
+    FILE* out = stdout;
+    if (outputName != NULL) {
+        out = fopen(outputName, "w");
+        if (out == NULL) {
+            printf("Unable to create %s\n", outputName);
+            return 1;
+        }
+    }
+
+    if (describeOnly) describe(log, out);
+    else {
+
+        // header line
+        const char* separator = csv ? "," : " ";
+        for (int i = 0; i < log.getNumFields(); i++) fprintf(out, "%s%s", (i == 0) ? "" : (csv ? "," : ", "), log.getField(i).name);
+        fprintf(out, "\n");
+
+        // one line per record
+        unsigned long records = 0;
+        while (log.readRecord()) {
+            for (int i = 0; i < log.getNumFields(); i++) {
+                if (i > 0) fputs(separator, out);
+                if (log.isInteger(i)) fprintf(out, "%ld", log.getInteger(i));
+                else if (csv) fprintf(out, "%.17g", log.getDouble(i));
+                else fprintf(out, "%f", log.getDouble(i));
+            }
+            fprintf(out, "\n");
+            records++;
+        }
+        if (outputName != NULL) printf("%lu records written to %s\n", records, outputName);
+    }
+
+    if (out != stdout) fclose(out);
+    return 0;
+
+}